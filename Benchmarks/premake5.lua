@@ -0,0 +1,62 @@
+project "IVTCDN-Bench"
+   kind "ConsoleApp"
+   language "C++"
+   cppdialect "C++20"
+   staticruntime "off"
+
+   -- The benchmarks build the GUI's graph and packing code directly so they measure what the application runs
+   files
+   {
+      "src/**.h",
+      "src/**.cpp",
+      "../WalnutApp/src/FramePacking.cpp",
+      "../WalnutApp/src/ProjectFile.cpp",
+      "../WalnutApp/src/ScriptGraph.cpp",
+      "../WalnutApp/src/Simd.cpp",
+      "../WalnutApp/src/SyntheticClip.cpp",
+      "../WalnutApp/src/VSScriptLibrary.cpp",
+      "../WalnutApp/src/WorkerPool.cpp",
+      "../Walnut/src/Walnut/JobSystem.cpp",
+   }
+
+   includedirs
+   {
+      "../vendor",
+      "../vendor/json",
+      "../vendor/libp2p",
+      "../vendor/miniz",
+
+      "../WalnutApp/src",
+      "../Walnut/src",
+
+      "%{IncludeDir.vapoursynth}",
+   }
+
+   links
+   {
+      "libp2p",
+      "miniz",
+   }
+
+   targetdir ("../bin/" .. outputdir .. "/%{prj.name}")
+   objdir ("../bin-int/" .. outputdir .. "/%{prj.name}")
+
+   filter "system:windows"
+      systemversion "latest"
+
+   filter "system:linux"
+      links { "dl", "pthread" }
+
+   filter "configurations:Debug"
+      runtime "Debug"
+      symbols "On"
+
+   filter "configurations:Release"
+      runtime "Release"
+      optimize "On"
+      symbols "On"
+
+   filter "configurations:Dist"
+      runtime "Release"
+      optimize "On"
+      symbols "Off"
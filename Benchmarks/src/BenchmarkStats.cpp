@@ -0,0 +1,67 @@
+#include "BenchmarkStats.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <numeric>
+
+nlohmann::ordered_json Summary::ToJson() const {
+	return nlohmann::ordered_json{
+		{"p50", p50},
+		{"p95", p95},
+		{"p99", p99},
+		{"mean", mean},
+		{"max", max},
+	};
+}
+
+static double Percentile(const std::vector<double>& sorted, const double percentile) {
+	const size_t rank = (size_t)std::ceil(percentile / 100.0 * sorted.size());
+	return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+}
+
+Summary Summarise(std::vector<double> samples) {
+	Summary summary;
+	if (samples.empty()) {
+		return summary;
+	}
+	std::sort(samples.begin(), samples.end());
+	summary.p50 = Percentile(samples, 50);
+	summary.p95 = Percentile(samples, 95);
+	summary.p99 = Percentile(samples, 99);
+	summary.mean = std::accumulate(samples.begin(), samples.end(), 0.0) / samples.size();
+	summary.max = samples.back();
+	return summary;
+}
+
+std::vector<std::string> SplitList(const std::string& list) {
+	std::vector<std::string> items;
+	size_t start = 0;
+	while (start <= list.size()) {
+		size_t end = list.find(',', start);
+		if (end == std::string::npos) {
+			end = list.size();
+		}
+		if (end > start) {
+			items.push_back(list.substr(start, end - start));
+		}
+		start = end + 1;
+	}
+	return items;
+}
+
+bool WriteReport(const nlohmann::ordered_json& report, const std::string& output) {
+	const std::string text = report.dump(2);
+	if (output.empty()) {
+		printf("%s\n", text.c_str());
+		return true;
+	}
+	std::ofstream file(output);
+	file << text << "\n";
+	if (!file) {
+		fprintf(stderr, "Could not write %s\n", output.c_str());
+		return false;
+	}
+	return true;
+}
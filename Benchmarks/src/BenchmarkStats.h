@@ -0,0 +1,31 @@
+#pragma once
+
+#include "json.hpp"
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+// Milliseconds elapsed since start
+inline double ElapsedMs(const std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+struct Summary {
+	double p50 = 0;
+	double p95 = 0;
+	double p99 = 0;
+	double mean = 0;
+	double max = 0;
+
+	nlohmann::ordered_json ToJson() const;
+};
+
+// Nearest-rank percentiles of the samples, all zero if there are none
+Summary Summarise(std::vector<double> samples);
+
+// Splits a comma separated option value, skipping empty items
+std::vector<std::string> SplitList(const std::string& list);
+
+// Prints the report to stdout, or writes it to output if that isn't empty. Returns false if the file couldn't be written.
+bool WriteReport(const nlohmann::ordered_json& report, const std::string& output);
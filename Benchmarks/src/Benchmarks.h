@@ -0,0 +1,5 @@
+#pragma once
+
+// Each benchmark parses its own options (argv[0] is the benchmark name), writes a JSON report and returns the exit code
+int RunNavigationBenchmark(int argc, char** argv);
+int RunPackBenchmark(int argc, char** argv);
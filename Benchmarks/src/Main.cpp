@@ -0,0 +1,37 @@
+#include "Benchmarks.h"
+
+#include <cstdio>
+#include <cstring>
+
+struct Benchmark {
+	const char* name;
+	int (*run)(int argc, char** argv);
+	const char* description;
+};
+
+static const Benchmark BENCHMARKS[] = {
+	{ "navigation", RunNavigationBenchmark, "Cycle navigation latency through the GUI's fields and frames graphs" },
+	{ "pack", RunPackBenchmark, "libp2p planar to packed conversion throughput" },
+};
+
+static void PrintUsage() {
+	printf("Usage: IVTCDN-Bench <benchmark> [options]\n\n");
+	for (const Benchmark& benchmark : BENCHMARKS) {
+		printf("  %-12s %s\n", benchmark.name, benchmark.description);
+	}
+	printf("\nRun a benchmark with --help to list its options.\n");
+}
+
+int main(int argc, char** argv) {
+	if (argc < 2) {
+		PrintUsage();
+		return 2;
+	}
+	for (const Benchmark& benchmark : BENCHMARKS) {
+		if (strcmp(argv[1], benchmark.name) == 0) {
+			return benchmark.run(argc - 1, argv + 1);
+		}
+	}
+	PrintUsage();
+	return strcmp(argv[1], "help") == 0 || strcmp(argv[1], "--help") == 0 ? 0 : 2;
+}
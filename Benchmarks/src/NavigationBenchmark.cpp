@@ -0,0 +1,275 @@
+#include "Benchmarks.h"
+#include "BenchmarkStats.h"
+#include "SyntheticClip.h"
+
+#include "FramePacking.h"
+#include "ScriptGraph.h"
+#include "Simd.h"
+#include "VSScriptLibrary.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+using nlohmann::ordered_json;
+
+struct NavigationOptions {
+	SyntheticClip clip;
+	int steps = 300;
+	unsigned seed = 1;
+	bool combedDetection = false;
+	std::vector<std::string> modes = { "sequential", "random", "back_and_forth" };
+	std::string output;
+};
+
+// Timings of one cycle change, the same work OnUIRender does when m_NeedNewFields is set
+struct StepTiming {
+	double fetchMs = 0;
+	double packMs = 0;
+	bool failed = false;
+};
+
+// What the ID bands of the fetched fields and frames showed, against what the clip's plan says they should
+struct IdCheck {
+	int wrongFields = 0;
+	// Output frames woven from fields of two different source frames
+	int mixedFrames = 0;
+};
+
+static void PrintUsage() {
+	printf(
+		"Usage: IVTCDN-Bench navigation [options]\n\n"
+		"Steps through cycles of a synthetic telecined clip, fetching and packing the 11 fields and 4 frames the GUI\n"
+		"shows for each one, and reports latency percentiles as JSON. The project holds the clip's correct actions, and\n"
+		"every field and frame is checked against the IDs the clip embeds.\n\n"
+		"  --width <n>          Clip width (default 720)\n"
+		"  --height <n>         Clip height, a multiple of 4 (default 480)\n"
+		"  --format <name>      VapourSynth preset format (default YUV420P8)\n"
+		"  --clip-cycles <n>    Length of the clip in cycles (default 2000)\n"
+		"  --pattern-breaks <n> Cycles between cuts in the telecine pattern (default 0, none)\n"
+		"  --orphans <n>        Cycles between orphan fields (default 0, none)\n"
+		"  --scene-length <n>   Progressive frames per scene (default 0, one scene)\n"
+		"  --clip-seed <n>      Seed for where breaks and orphans fall (default 1)\n"
+		"  --steps <n>          Cycle changes measured per mode (default 300)\n"
+		"  --seed <n>           Seed for the random mode (default 1)\n"
+		"  --combed-detection   Include DMetrics in the frames graph\n"
+		"  --modes <list>       Comma separated: sequential, random, back_and_forth (default all)\n"
+		"  --output <file>      Write the report to a file instead of stdout\n");
+}
+
+static bool ParseOptions(int argc, char** argv, NavigationOptions& options) {
+	for (int i = 1; i < argc; i++) {
+		const std::string arg = argv[i];
+		const bool hasValue = i + 1 < argc;
+		if (arg == "--combed-detection") {
+			options.combedDetection = true;
+		} else if (arg == "--width" && hasValue) {
+			options.clip.width = atoi(argv[++i]);
+		} else if (arg == "--height" && hasValue) {
+			options.clip.height = atoi(argv[++i]);
+		} else if (arg == "--format" && hasValue) {
+			options.clip.format = argv[++i];
+		} else if (arg == "--clip-cycles" && hasValue) {
+			options.clip.cycles = atoi(argv[++i]);
+		} else if (arg == "--pattern-breaks" && hasValue) {
+			options.clip.patternBreakInterval = atoi(argv[++i]);
+		} else if (arg == "--orphans" && hasValue) {
+			options.clip.orphanInterval = atoi(argv[++i]);
+		} else if (arg == "--scene-length" && hasValue) {
+			options.clip.sceneLength = atoi(argv[++i]);
+		} else if (arg == "--clip-seed" && hasValue) {
+			options.clip.seed = (uint32_t)strtoul(argv[++i], nullptr, 10);
+		} else if (arg == "--steps" && hasValue) {
+			options.steps = atoi(argv[++i]);
+		} else if (arg == "--seed" && hasValue) {
+			options.seed = (unsigned)strtoul(argv[++i], nullptr, 10);
+		} else if (arg == "--modes" && hasValue) {
+			options.modes = SplitList(argv[++i]);
+		} else if (arg == "--output" && hasValue) {
+			options.output = argv[++i];
+		} else {
+			return false;
+		}
+	}
+	return options.steps > 0 && !options.modes.empty();
+}
+
+// Cycle visited at each step, modelled on how people move through a project
+static std::vector<int> CyclePath(const std::string& mode, const int steps, const int cycles, const unsigned seed) {
+	std::vector<int> path;
+	path.reserve(steps);
+	if (mode == "sequential") {
+		for (int i = 0; i < steps; i++) {
+			path.push_back(i % cycles);
+		}
+	} else if (mode == "random") {
+		std::mt19937 generator(seed);
+		std::uniform_int_distribution<int> distribution(0, cycles - 1);
+		for (int i = 0; i < steps; i++) {
+			path.push_back(distribution(generator));
+		}
+	} else if (mode == "back_and_forth") {
+		// Forward, back to compare, then on to the next cycle
+		static const int OFFSETS[] = { 0, 1, 0 };
+		for (int i = 0; i < steps; i++) {
+			path.push_back((i / 3 + OFFSETS[i % 3]) % cycles);
+		}
+	}
+	return path;
+}
+
+// ids gets the field IDs of the first two rows, the same field's twice for a field and the top then bottom field's
+// for a frame
+static bool FetchAndPack(const VSAPI* vsapi, VSNode* node, const int n, StepTiming& timing, int ids[2]) {
+	char error_message[1024];
+	auto start = std::chrono::steady_clock::now();
+	const VSFrame* frame = vsapi->getFrame(n, node, error_message, sizeof(error_message));
+	timing.fetchMs += ElapsedMs(start);
+	if (!frame) {
+		fprintf(stderr, "%s\n", error_message);
+		return false;
+	}
+	start = std::chrono::steady_clock::now();
+	const int width = vsapi->getFrameWidth(frame, 0);
+	const size_t size = (size_t)width * vsapi->getFrameHeight(frame, 0) * 4;
+	uint8_t* imageBuffer = (uint8_t*)malloc(size);
+	PackRGBA32(vsapi, frame, imageBuffer);
+	timing.packMs += ElapsedMs(start);
+	ids[0] = SyntheticClip::ReadFieldId(imageBuffer, width, 4);
+	ids[1] = SyntheticClip::ReadFieldId(imageBuffer + (size_t)width * 4, width, 4);
+	free(imageBuffer);
+	vsapi->freeFrame(frame);
+	return true;
+}
+
+// Runs one mode against a freshly evaluated script so frame caches don't carry over between modes
+static ordered_json RunMode(const VSSCRIPTAPI* vssapi, const NavigationOptions& options, const std::string& mode) {
+	const std::vector<int> path = CyclePath(mode, options.steps, options.clip.cycles, options.seed);
+	if (path.empty()) {
+		return { {"error", "unknown mode"} };
+	}
+
+	const VSAPI* vsapi = vssapi->getVSAPI(VAPOURSYNTH_API_VERSION);
+	VSScript* script = vssapi->createScript(nullptr);
+	if (vssapi->evaluateBuffer(script, options.clip.Script().c_str(), "synthetic.vpy") != 0) {
+		ordered_json result = { {"error", vssapi->getError(script)} };
+		vssapi->freeScript(script);
+		return result;
+	}
+
+	const ScriptGraph graph(vsapi, vssapi->getCore(script));
+	const SyntheticClip::Plan plan = options.clip.MakePlan();
+	const std::string rawProject = options.clip.Project("synthetic.vpy").dump();
+	VSNode* fieldsNode = graph.FieldsView(vssapi->getOutputNode(script, 0));
+	VSNode* framesNode = graph.FramesView(vssapi->getOutputNode(script, 0), rawProject, options.combedDetection);
+	if (!fieldsNode || !framesNode) {
+		vsapi->freeNode(fieldsNode);
+		vsapi->freeNode(framesNode);
+		vssapi->freeScript(script);
+		return { {"error", "failed to build the fields and frames graphs, is the IVTC DN plugin installed?"} };
+	}
+	const int fieldCount = vsapi->getVideoInfo(fieldsNode)->numFrames;
+	const int frameCount = vsapi->getVideoInfo(framesNode)->numFrames;
+
+	std::vector<double> latency, fetch, pack;
+	double firstStepMs = 0;
+	int failures = 0;
+	IdCheck check;
+	const auto modeStart = std::chrono::steady_clock::now();
+	for (size_t step = 0; step < path.size(); step++) {
+		const int cycle = path[step];
+		StepTiming timing;
+		const auto stepStart = std::chrono::steady_clock::now();
+		int ids[2];
+		for (int i = 0; i < 11 && cycle * 10 + i < fieldCount && !timing.failed; i++) {
+			timing.failed = !FetchAndPack(vsapi, fieldsNode, cycle * 10 + i, timing, ids);
+			check.wrongFields += !timing.failed && ids[0] != plan.sourceFields[cycle * 10 + i];
+		}
+		for (int i = 0; i < 4 && cycle * 4 + i < frameCount && !timing.failed; i++) {
+			timing.failed = !FetchAndPack(vsapi, framesNode, cycle * 4 + i, timing, ids);
+			check.mixedFrames += !timing.failed && ids[0] / 2 != ids[1] / 2;
+		}
+		const double stepMs = ElapsedMs(stepStart);
+		if (timing.failed) {
+			failures++;
+		} else if (step == 0) {
+			// Pays for plugin and filter initialisation, reported on its own
+			firstStepMs = stepMs;
+		} else {
+			latency.push_back(stepMs);
+			fetch.push_back(timing.fetchMs);
+			pack.push_back(timing.packMs);
+		}
+	}
+	const double totalSeconds = ElapsedMs(modeStart) / 1000.0;
+
+	vsapi->freeNode(fieldsNode);
+	vsapi->freeNode(framesNode);
+	vssapi->freeScript(script);
+
+	return ordered_json{
+		{"steps", path.size()},
+		{"failed_steps", failures},
+		{"wrong_fields", check.wrongFields},
+		{"mixed_frames", check.mixedFrames},
+		{"first_step_ms", firstStepMs},
+		{"latency_ms", Summarise(latency).ToJson()},
+		{"fetch_ms", Summarise(fetch).ToJson()},
+		{"pack_ms", Summarise(pack).ToJson()},
+		// Walnut::Image needs the Vulkan device of a running Application, which a headless run doesn't have
+		{"upload_ms", nullptr},
+		{"cycles_per_second", totalSeconds > 0 ? path.size() / totalSeconds : 0.0},
+	};
+}
+
+int RunNavigationBenchmark(int argc, char** argv) {
+	NavigationOptions options;
+	if (!ParseOptions(argc, argv, options)) {
+		PrintUsage();
+		return argc > 1 && strcmp(argv[1], "--help") == 0 ? 0 : 2;
+	}
+	const std::string clipError = options.clip.Validate();
+	if (!clipError.empty()) {
+		fprintf(stderr, "%s\n", clipError.c_str());
+		return 2;
+	}
+	const VSSCRIPTAPI* vssapi = GetVSScriptAPI();
+	if (!vssapi) {
+		fprintf(stderr, "VapourSynth is not available\n");
+		return 2;
+	}
+
+	ordered_json report = {
+		{"benchmark", "navigation"},
+		{"simd", Simd::LevelName(Simd::ActiveLevel())},
+		{"clip", {
+			{"width", options.clip.width},
+			{"height", options.clip.height},
+			{"format", options.clip.format},
+			{"cycles", options.clip.cycles},
+			{"pattern_break_interval", options.clip.patternBreakInterval},
+			{"orphan_interval", options.clip.orphanInterval},
+			{"scene_length", options.clip.sceneLength},
+			{"clip_seed", options.clip.seed},
+			{"combed_detection", options.combedDetection},
+		}},
+		{"seed", options.seed},
+		{"modes", ordered_json::object()},
+	};
+	int status = 0;
+	for (const std::string& mode : options.modes) {
+		ordered_json result = RunMode(vssapi, options, mode);
+		if (result.contains("error") || result.value("failed_steps", 0) > 0 || result.value("wrong_fields", 0) > 0 || result.value("mixed_frames", 0) > 0) {
+			status = 1;
+		}
+		report["modes"][mode] = std::move(result);
+	}
+
+	if (!WriteReport(report, options.output)) {
+		return 2;
+	}
+	return status;
+}
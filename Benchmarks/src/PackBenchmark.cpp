@@ -0,0 +1,252 @@
+#include "Benchmarks.h"
+#include "BenchmarkStats.h"
+
+#include "FramePacking.h"
+#include "Simd.h"
+#include "p2p_api.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using nlohmann::ordered_json;
+
+// A planar source layout and the packing it is converted to
+struct PackCase {
+	const char* name;
+	enum p2p_packing packing;
+	int bytesPerSample;
+	// log2 chroma subsampling of planes 1 and 2
+	int subsampleW;
+	int subsampleH;
+	// Bytes per pixel of the (first) destination plane
+	int dstBytesPerPixel;
+	bool hasAlpha;
+	bool isNV;
+};
+
+static const PackCase PACK_CASES[] = {
+	// What the fields and frames views upload
+	{ "rgb24_rgba32", p2p_rgba32_be, 1, 0, 0, 4, true, false },
+	// Thumbnails
+	{ "rgb24_rgb24", p2p_rgb24_be, 1, 0, 0, 3, false, false },
+	// R-G-B-A in memory with native endian components, the layout R16G16B16A16 textures expect
+	{ "rgb48_rgba64", p2p_abgr64_le, 2, 0, 0, 8, true, false },
+	{ "yuv444p8_ayuv", p2p_ayuv_be, 1, 0, 0, 4, true, false },
+	{ "yuv422p8_yuy2", p2p_yuy2, 1, 1, 0, 2, false, false },
+	{ "yuv420p8_nv12", p2p_nv12_le, 1, 1, 1, 1, false, true },
+};
+
+struct FrameSize {
+	const char* name;
+	unsigned width;
+	unsigned height;
+};
+
+static const FrameSize FRAME_SIZES[] = {
+	{ "sd", 720, 480 },
+	{ "hd", 1920, 1080 },
+	{ "uhd", 3840, 2160 },
+};
+
+struct PackOptions {
+	std::vector<std::string> cases;
+	std::vector<std::string> sizes = { "sd", "hd", "uhd" };
+	bool parallel = true;
+	double minTimeMs = 250;
+	std::string output;
+};
+
+// Like VapourSynth frames, rows start on 64 byte boundaries
+struct Plane {
+	std::vector<uint8_t> storage;
+	uint8_t* data = nullptr;
+	ptrdiff_t stride = 0;
+
+	Plane(const size_t rowBytes, const unsigned rows, const size_t alignment) {
+		stride = (ptrdiff_t)((rowBytes + alignment - 1) / alignment * alignment);
+		storage.resize(stride * rows + 64);
+		data = storage.data() + (64 - (uintptr_t)storage.data() % 64) % 64;
+	}
+};
+
+static void PrintUsage() {
+	printf(
+		"Usage: IVTCDN-Bench pack [options]\n\n"
+		"Times p2p_pack_frame for the packings the application uses, reporting GB/s and cycles per pixel as JSON.\n\n"
+		"  --cases <list>       Comma separated, default all:");
+	for (const PackCase& packCase : PACK_CASES) {
+		printf(" %s", packCase.name);
+	}
+	printf(
+		"\n"
+		"  --sizes <list>       Comma separated: sd, hd, uhd (default all)\n"
+		"  --serial-only        Skip measuring PackFrameParallel\n"
+		"  --min-time-ms <n>    Minimum time spent on each measurement (default 250)\n"
+		"  --output <file>      Write the report to a file instead of stdout\n");
+}
+
+static bool ParseOptions(int argc, char** argv, PackOptions& options) {
+	for (int i = 1; i < argc; i++) {
+		const std::string arg = argv[i];
+		const bool hasValue = i + 1 < argc;
+		if (arg == "--cases" && hasValue) {
+			options.cases = SplitList(argv[++i]);
+		} else if (arg == "--sizes" && hasValue) {
+			options.sizes = SplitList(argv[++i]);
+		} else if (arg == "--serial-only") {
+			options.parallel = false;
+		} else if (arg == "--min-time-ms" && hasValue) {
+			options.minTimeMs = atof(argv[++i]);
+		} else if (arg == "--output" && hasValue) {
+			options.output = argv[++i];
+		} else {
+			return false;
+		}
+	}
+	return !options.sizes.empty();
+}
+
+static bool Selected(const std::vector<std::string>& selection, const char* name) {
+	if (selection.empty()) {
+		return true;
+	}
+	for (const std::string& item : selection) {
+		if (item == name) {
+			return true;
+		}
+	}
+	return false;
+}
+
+// parallel measures the GUI's PackFrameParallel rather than p2p_pack_frame on one thread
+static ordered_json Measure(const PackCase& packCase, const FrameSize& size, const bool alphaOne, const bool parallel, const double minTimeMs) {
+	const unsigned width = size.width;
+	const unsigned height = size.height;
+	std::vector<Plane> src;
+	for (int plane = 0; plane < 3; plane++) {
+		const int shiftW = plane ? packCase.subsampleW : 0;
+		const int shiftH = plane ? packCase.subsampleH : 0;
+		src.emplace_back((size_t)(width >> shiftW) * packCase.bytesPerSample, height >> shiftH, 64);
+	}
+	// Contiguous like the buffers handed to Walnut::Image
+	std::vector<Plane> dst;
+	dst.emplace_back((size_t)width * packCase.dstBytesPerPixel, height, 1);
+	if (packCase.isNV) {
+		dst.emplace_back((size_t)width * packCase.bytesPerSample, height >> packCase.subsampleH, 1);
+	}
+
+	std::mt19937 generator(1);
+	size_t bytes = 0;
+	for (Plane& plane : src) {
+		for (uint8_t& byte : plane.storage) {
+			byte = (uint8_t)generator();
+		}
+		bytes += plane.storage.size() - 64;
+	}
+	for (const Plane& plane : dst) {
+		bytes += plane.storage.size() - 64;
+	}
+
+	p2p_buffer_param p = {};
+	p.packing = packCase.packing;
+	p.width = width;
+	p.height = height;
+	for (int plane = 0; plane < 3; plane++) {
+		p.src[plane] = src[plane].data;
+		p.src_stride[plane] = src[plane].stride;
+	}
+	for (size_t plane = 0; plane < dst.size(); plane++) {
+		p.dst[plane] = dst[plane].data;
+		p.dst_stride[plane] = dst[plane].stride;
+	}
+	const unsigned long flags = alphaOne ? P2P_ALPHA_SET_ONE : 0;
+
+	auto pack = [&]() {
+		if (parallel) {
+			PackFrameParallel(p, flags);
+		} else {
+			p2p_pack_frame(&p, flags);
+		}
+	};
+
+	// Warm the caches, page in the destination and start the pool before timing anything
+	pack();
+
+	std::vector<double> frameMs;
+	std::vector<double> cycles;
+	const auto start = std::chrono::steady_clock::now();
+	while (frameMs.size() < 5 || ElapsedMs(start) < minTimeMs) {
+		const auto frameStart = std::chrono::steady_clock::now();
+		const uint64_t tscStart = __rdtsc();
+		pack();
+		cycles.push_back((double)(__rdtsc() - tscStart));
+		frameMs.push_back(ElapsedMs(frameStart));
+	}
+
+	const Summary time = Summarise(frameMs);
+	const double pixels = (double)width * height;
+	return ordered_json{
+		{"case", packCase.name},
+		{"size", size.name},
+		{"width", width},
+		{"height", height},
+		{"alpha_set_one", alphaOne},
+		{"parallel", parallel},
+		{"iterations", frameMs.size()},
+		{"frame_ms", time.ToJson()},
+		// Source and destination traffic at the median time
+		{"gb_per_s", time.p50 > 0 ? bytes / (time.p50 / 1000.0) / 1e9 : 0.0},
+		// TSC cycles, which tick at the nominal rather than the boosted clock (wall time, not summed over threads)
+		{"cycles_per_pixel", Summarise(cycles).p50 / pixels},
+	};
+}
+
+int RunPackBenchmark(int argc, char** argv) {
+	PackOptions options;
+	if (!ParseOptions(argc, argv, options)) {
+		PrintUsage();
+		return argc > 1 && strcmp(argv[1], "--help") == 0 ? 0 : 2;
+	}
+
+	std::vector<ordered_json> results;
+	for (const FrameSize& size : FRAME_SIZES) {
+		if (!Selected(options.sizes, size.name)) {
+			continue;
+		}
+		for (const PackCase& packCase : PACK_CASES) {
+			if (!Selected(options.cases, packCase.name)) {
+				continue;
+			}
+			for (int parallel = 0; parallel <= (options.parallel ? 1 : 0); parallel++) {
+				results.push_back(Measure(packCase, size, false, parallel, options.minTimeMs));
+				if (packCase.hasAlpha) {
+					results.push_back(Measure(packCase, size, true, parallel, options.minTimeMs));
+				}
+			}
+		}
+	}
+	if (results.empty()) {
+		fprintf(stderr, "No cases or sizes matched\n");
+		return 2;
+	}
+
+	const ordered_json report = {
+		{"benchmark", "pack"},
+		{"simd", Simd::LevelName(Simd::ActiveLevel())},
+		{"threads", std::thread::hardware_concurrency()},
+		{"results", results},
+	};
+	return WriteReport(report, options.output) ? 0 : 2;
+}
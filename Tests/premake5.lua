@@ -0,0 +1,57 @@
+project "IVTCDN-Tests"
+   kind "ConsoleApp"
+   language "C++"
+   cppdialect "C++20"
+   staticruntime "off"
+
+   -- Checks of the application's logic, and of the libp2p kernels it packs frames with, which don't need a window or
+   -- VapourSynth
+   files
+   {
+      "src/**.h",
+      "src/**.cpp",
+      "../WalnutApp/src/ActionScan.cpp",
+      "../WalnutApp/src/ProjectFile.cpp",
+      "../WalnutApp/src/SyntheticClip.cpp",
+      "../WalnutApp/src/Y4MExport.cpp",
+   }
+
+   includedirs
+   {
+      "../vendor",
+      "../vendor/json",
+      "../vendor/miniz",
+
+      "../WalnutApp/src",
+
+      "%{IncludeDir.vapoursynth}",
+   }
+
+   links
+   {
+      "libp2p",
+      "miniz",
+   }
+
+   targetdir ("../bin/" .. outputdir .. "/%{prj.name}")
+   objdir ("../bin-int/" .. outputdir .. "/%{prj.name}")
+
+   filter "system:windows"
+      systemversion "latest"
+
+   filter "system:linux"
+      links { "pthread" }
+
+   filter "configurations:Debug"
+      runtime "Debug"
+      symbols "On"
+
+   filter "configurations:Release"
+      runtime "Release"
+      optimize "On"
+      symbols "On"
+
+   filter "configurations:Dist"
+      runtime "Release"
+      optimize "On"
+      symbols "Off"
@@ -0,0 +1,83 @@
+#include "Tests.h"
+#include "ActionScan.h"
+#include "SyntheticClip.h"
+
+#include <vector>
+
+static const int D = 8; // ACTION_DROP
+static const int C = 9; // ACTION_COMPLETE_PREVIOUS_CYCLE
+
+static std::vector<int> Examples(const Findings& findings) {
+	return findings.examples;
+}
+
+static CycleFindings Scan(const std::vector<int>& actions) {
+	return ScanCycles(actions, 0, ((int)actions.size() + 9) / 10);
+}
+
+int RunActionScanTests() {
+	int failures = 0;
+
+	// AA BB BC CD DD matched into four whole frames
+	{
+		const CycleFindings findings = Scan({ 0, 1, 2, 3, D, D, 4, 5, 6, 7 });
+		TEST_CHECK(failures, findings.invalidActions.count == 0);
+		TEST_CHECK(failures, findings.duplicateFields.count == 0);
+		TEST_CHECK(failures, findings.orphanedFields.count == 0);
+		TEST_CHECK(failures, findings.singleFieldFrames.count == 0);
+		TEST_CHECK(failures, findings.freezeFrames.count == 0);
+	}
+
+	// The third frame's bottom field is dropped, leaving its top field without a partner
+	{
+		const CycleFindings findings = Scan({ 0, 1, 2, 3, D, D, 4, D, 6, 7 });
+		TEST_CHECK(failures, Examples(findings.orphanedFields) == std::vector<int>{ 6 });
+		TEST_CHECK(failures, Examples(findings.singleFieldFrames) == std::vector<int>{ 2 });
+		TEST_CHECK(failures, findings.duplicateFields.count == 0);
+		TEST_CHECK(failures, findings.freezeFrames.count == 0);
+	}
+
+	// A second top field for the second frame is a duplicate, not an orphan
+	{
+		const CycleFindings findings = Scan({ 0, 1, 2, 3, 2, D, 4, 5, 6, 7 });
+		TEST_CHECK(failures, Examples(findings.duplicateFields) == std::vector<int>{ 4 });
+		TEST_CHECK(failures, findings.orphanedFields.count == 0);
+		TEST_CHECK(failures, findings.singleFieldFrames.count == 0);
+	}
+
+	// Both fields of a frame dropped is a freeze frame, with no orphans
+	{
+		const CycleFindings findings = Scan({ 0, 1, 2, 3, D, D, D, D, 6, 7 });
+		TEST_CHECK(failures, Examples(findings.freezeFrames) == std::vector<int>{ 2 });
+		TEST_CHECK(failures, findings.orphanedFields.count == 0);
+	}
+
+	// The last frame completed by the next cycle's first field, then without it
+	{
+		const std::vector<int> completed = { 0, 1, 2, 3, 4, 5, D, 7, D, D, C, D, 0, 1, 2, 3, 4, 5, 6, 7 };
+		const CycleFindings findings = Scan(completed);
+		TEST_CHECK(failures, findings.invalidActions.count == 0);
+		TEST_CHECK(failures, findings.orphanedFields.count == 0);
+		TEST_CHECK(failures, findings.singleFieldFrames.count == 0);
+
+		std::vector<int> dropped = completed;
+		dropped[10] = D;
+		const CycleFindings droppedFindings = Scan(dropped);
+		TEST_CHECK(failures, Examples(droppedFindings.orphanedFields) == std::vector<int>{ 7 });
+	}
+
+	// Orphan fields of a synthetic clip are dropped by its answer, so it has no orphaned fields
+	{
+		SyntheticClip clip;
+		clip.cycles = 500;
+		clip.patternBreakInterval = 7;
+		clip.orphanInterval = 3;
+		const std::vector<int> actions = clip.Project("synthetic.vpy")["ivtc_actions"].get<std::vector<int>>();
+		const CycleFindings findings = Scan(actions);
+		TEST_CHECK(failures, findings.invalidActions.count == 0);
+		TEST_CHECK(failures, findings.duplicateFields.count == 0);
+		TEST_CHECK(failures, findings.orphanedFields.count == 0);
+	}
+
+	return failures;
+}
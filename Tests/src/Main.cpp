@@ -0,0 +1,33 @@
+#include "Tests.h"
+
+#include <cstring>
+
+struct Test {
+	const char* name;
+	int (*run)();
+};
+
+static const Test TESTS[] = {
+	{ "action_scan", RunActionScanTests },
+	{ "p2p_simd", RunP2PSimdTests },
+	{ "pattern_track", RunPatternTrackTests },
+	{ "y4m_export", RunY4MExportTests },
+};
+
+// Runs every test, or those named on the command line, and exits with 1 if any check failed
+int main(int argc, char** argv) {
+	int failed = 0;
+	for (const Test& test : TESTS) {
+		bool selected = argc < 2;
+		for (int i = 1; i < argc; i++) {
+			selected |= strcmp(argv[i], test.name) == 0;
+		}
+		if (!selected) {
+			continue;
+		}
+		const int failures = test.run();
+		printf("%-16s %s\n", test.name, failures == 0 ? "passed" : "FAILED");
+		failed += failures > 0;
+	}
+	return failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,109 @@
+#include "Tests.h"
+
+// The templates without P2P_SIMD, in their own namespace so they don't clash with libp2p's dispatching ones, are the
+// generic reference the kernels must match
+#define P2P_USER_NAMESPACE p2p_generic
+#include "libp2p/p2p.h"
+#undef P2P_USER_NAMESPACE
+#include "libp2p/simd/cpuinfo_x86.h"
+#include "libp2p/simd/p2p_simd.h"
+
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace {
+
+using PackFunc = void (*)(const void* const*, void*, unsigned, unsigned);
+
+struct Packing {
+	const char* name;
+	unsigned sampleSize;
+	p2p::detail::interleave_order order;
+	PackFunc generic[2]; // Indexed by alpha one fill
+};
+
+#define PACKING(name, size, order) { #name, size, p2p::detail::order, { p2p_generic::planar_to_packed<p2p_generic::name, false>::pack, p2p_generic::planar_to_packed<p2p_generic::name, true>::pack } }
+
+// Every packing libp2p hands to the kernels, see lookup_interleave_format
+const Packing PACKINGS[] = {
+	PACKING(packed_rgba32_be, 1, interleave_rgba),
+	PACKING(packed_rgba32_le, 1, interleave_abgr),
+	PACKING(packed_argb32_be, 1, interleave_argb),
+	PACKING(packed_argb32_le, 1, interleave_bgra),
+	PACKING(packed_abgr64_le, 2, interleave_rgba),
+	PACKING(packed_rgba64_le, 2, interleave_abgr),
+	PACKING(packed_bgra64_le, 2, interleave_argb),
+	PACKING(packed_argb64_le, 2, interleave_bgra),
+};
+
+#undef PACKING
+
+// Packs [left, right) of random planes with both functions into buffers filled with the same pattern beforehand, so
+// writes outside the range show up too
+bool SameOutput(PackFunc expected, PackFunc actual, const unsigned sampleSize, const unsigned width, const unsigned left, const unsigned right, const bool alphaPlane, std::mt19937& random) {
+	std::vector<uint8_t> planes[4];
+	for (auto& plane : planes) {
+		plane.resize(width * sampleSize);
+		for (auto& byte : plane) {
+			byte = (uint8_t)random();
+		}
+	}
+	const void* src[4] = { planes[0].data(), planes[1].data(), planes[2].data(), alphaPlane ? planes[3].data() : nullptr };
+
+	std::vector<uint8_t> expectedOut(width * sampleSize * 4 + 64, 0x5A);
+	std::vector<uint8_t> actualOut = expectedOut;
+	expected(src, expectedOut.data(), left, right);
+	actual(src, actualOut.data(), left, right);
+	return expectedOut == actualOut;
+}
+
+}
+
+int RunP2PSimdTests() {
+	int failures = 0;
+	const p2p::detail::x86_capabilities caps = p2p::detail::query_x86_capabilities();
+	if (!caps.avx2) {
+		printf("p2p_simd: no AVX2 on this CPU, checking SSE2 only\n");
+	}
+
+	// Around each vector size (16 and 32 bytes of 8 or 16 bit samples) and a few whole rows
+	const unsigned widths[] = { 1, 3, 7, 8, 9, 15, 16, 17, 31, 32, 33, 47, 63, 64, 65, 100, 257, 720, 1921 };
+	std::mt19937 random(1234);
+	for (const Packing& packing : PACKINGS) {
+		for (int fill = 0; fill < 2; fill++) {
+			const PackFunc kernels[] = {
+				p2p::detail::select_interleave_sse2(packing.sampleSize, packing.order, fill != 0),
+				caps.avx2 ? p2p::detail::select_interleave_avx2(packing.sampleSize, packing.order, fill != 0) : nullptr,
+			};
+			TEST_CHECK(failures, kernels[0] != nullptr);
+			TEST_CHECK(failures, !caps.avx2 || kernels[1] != nullptr);
+
+			for (const PackFunc kernel : kernels) {
+				if (kernel == nullptr) {
+					continue;
+				}
+				for (const unsigned width : widths) {
+					// The whole row, then ranges starting and ending at odd offsets as the row bands of a split frame do
+					const unsigned ranges[][2] = { { 0, width }, { width / 3 | 1, width }, { 0, width - width / 5 }, { width / 4 | 1, width - (width / 7 | 1) } };
+					for (const auto& range : ranges) {
+						if (range[0] >= range[1] || range[1] > width) {
+							continue;
+						}
+						for (const bool alphaPlane : { false, true }) {
+							const bool same = SameOutput(packing.generic[fill], kernel, packing.sampleSize, width, range[0], range[1], alphaPlane, random);
+							if (!same) {
+								fprintf(stderr, "p2p_simd: %s %s fill %d width %u [%u, %u) alpha plane %d differs\n", packing.name,
+									kernel == kernels[0] ? "sse2" : "avx2", fill, width, range[0], range[1], alphaPlane);
+							}
+							TEST_CHECK(failures, same);
+						}
+					}
+				}
+			}
+		}
+	}
+
+	return failures;
+}
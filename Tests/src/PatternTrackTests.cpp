@@ -0,0 +1,44 @@
+#include "Tests.h"
+#include "PatternTrack.h"
+
+#include <cstdint>
+#include <vector>
+
+int RunPatternTrackTests() {
+	int failures = 0;
+	using Track = PatternTrack<int8_t>;
+
+	// Reads of a track with no fields, before anything is loaded or after Clear, don't touch its (empty) runs
+	{
+		Track track;
+		TEST_CHECK(failures, track.GetPattern(0) == Track::Pattern{});
+		TEST_CHECK(failures, track.Get(5) == 0);
+		track.Set(0, 3);
+		TEST_CHECK(failures, track.GetOverrideCount() == 0);
+		TEST_CHECK(failures, track.ToVector().empty());
+
+		track.Reset(20, { 0, 1, 2, 3, 8, 8, 4, 5, 6, 7 });
+		track.Clear();
+		TEST_CHECK(failures, track.GetPattern(12) == Track::Pattern{});
+		TEST_CHECK(failures, track.GetRunCount() == 0);
+	}
+
+	// Values round trip through runs and overrides, including a partial last cycle
+	{
+		std::vector<int8_t> values;
+		for (int cycle = 0; cycle < 6; cycle++) {
+			const std::vector<int8_t> pattern = cycle < 3 ? std::vector<int8_t>{ 0, 1, 2, 3, 8, 8, 4, 5, 6, 7 } : std::vector<int8_t>{ 0, 1, 8, 8, 2, 3, 4, 5, 6, 7 };
+			values.insert(values.end(), pattern.begin(), pattern.end());
+		}
+		values[14] = 2;
+		values.resize(55);
+		Track track;
+		track.Assign(values);
+		TEST_CHECK(failures, track.ToVector() == values);
+		for (int field = 0; field < (int)values.size(); field++) {
+			TEST_CHECK(failures, track.Get(field) == values[field]);
+		}
+	}
+
+	return failures;
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstdio>
+
+// Each test returns the number of checks that failed, having printed them
+int RunActionScanTests();
+int RunP2PSimdTests();
+int RunPatternTrackTests();
+int RunY4MExportTests();
+
+#define TEST_CHECK(failures, condition) \
+	do { \
+		if (!(condition)) { \
+			fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+			(failures)++; \
+		} \
+	} while (0)
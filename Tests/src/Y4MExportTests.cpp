@@ -0,0 +1,246 @@
+#include "Tests.h"
+#include "Y4MExport.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <vector>
+
+namespace {
+
+// Just enough of a core to export a GRAY8 clip: getFrameAsync queues requests, which a few threads standing in for the
+// core's own complete in a random order. Every frame's samples are its number.
+struct MockCore {
+	static const int THREADS = 4;
+	static const int WIDTH = 6;
+	static const int HEIGHT = 3;
+	// Wider than a row so the exporter writes row by row
+	static const int STRIDE = 8;
+
+	struct Request {
+		int n;
+		VSFrameDoneCallback callback;
+		void* userData;
+	};
+
+	struct Frame {
+		uint8_t data[STRIDE * HEIGHT];
+	};
+
+	VSVideoInfo info = {};
+	int failFrame = -1;
+	// Requests for frame 0 are held back until released, so the export stalls
+	bool holdFirst = false;
+
+	std::mutex mutex;
+	std::condition_variable condition;
+	std::vector<Request> pending;
+	int requestCount = 0;
+	bool released = false;
+	bool stopping = false;
+	std::vector<std::thread> threads;
+
+	std::atomic<int> liveFrames = 0;
+	std::atomic<int> nodeRefs = 1;
+
+	MockCore(const int numFrames) {
+		info.format = { cfGray, stInteger, 8, 1, 0, 0, 1 };
+		info.fpsNum = 24000;
+		info.fpsDen = 1001;
+		info.width = WIDTH;
+		info.height = HEIGHT;
+		info.numFrames = numFrames;
+	}
+
+	void Start() {
+		for (int i = 0; i < THREADS; i++) {
+			threads.emplace_back(&MockCore::Complete, this, i);
+		}
+	}
+
+	void Stop() {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+		condition.notify_all();
+		for (auto& thread : threads) {
+			thread.join();
+		}
+	}
+
+	void Release() {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			released = true;
+		}
+		condition.notify_all();
+	}
+
+	// Waits for a few requests to pile up, then answers one of them at random. Notifies after each, for the test waiting on it.
+	void Complete(const int seed) {
+		std::mt19937 random(seed);
+		std::unique_lock<std::mutex> lock(mutex);
+		while (true) {
+			condition.wait_for(lock, std::chrono::milliseconds(1), [&]() { return stopping || pending.size() >= 4; });
+			auto runnable = std::partition(pending.begin(), pending.end(), [&](const Request& request) { return request.n != 0 || !holdFirst || released; });
+			if (runnable == pending.begin()) {
+				if (stopping) {
+					return;
+				}
+				continue;
+			}
+			const auto chosen = pending.begin() + random() % (runnable - pending.begin());
+			const Request request = *chosen;
+			pending.erase(chosen);
+			lock.unlock();
+			if (request.n == failFrame) {
+				request.callback(request.userData, nullptr, request.n, nullptr, "mock failure");
+			} else {
+				Frame* frame = new Frame;
+				std::fill(std::begin(frame->data), std::end(frame->data), (uint8_t)request.n);
+				liveFrames++;
+				request.callback(request.userData, (const VSFrame*)frame, request.n, nullptr, nullptr);
+			}
+			lock.lock();
+			condition.notify_all();
+		}
+	}
+};
+
+MockCore* g_Core = nullptr;
+
+const VSVideoInfo* VS_CC GetVideoInfo(VSNode*) VS_NOEXCEPT { return &g_Core->info; }
+VSNode* VS_CC AddNodeRef(VSNode* node) VS_NOEXCEPT { g_Core->nodeRefs++; return node; }
+void VS_CC FreeNode(VSNode*) VS_NOEXCEPT { g_Core->nodeRefs--; }
+void VS_CC FreeFrame(const VSFrame* frame) VS_NOEXCEPT {
+	delete (const MockCore::Frame*)frame;
+	g_Core->liveFrames--;
+}
+const VSVideoFormat* VS_CC GetVideoFrameFormat(const VSFrame*) VS_NOEXCEPT { return &g_Core->info.format; }
+const uint8_t* VS_CC GetReadPtr(const VSFrame* frame, int) VS_NOEXCEPT { return ((const MockCore::Frame*)frame)->data; }
+ptrdiff_t VS_CC GetStride(const VSFrame*, int) VS_NOEXCEPT { return MockCore::STRIDE; }
+int VS_CC GetFrameWidth(const VSFrame*, int) VS_NOEXCEPT { return MockCore::WIDTH; }
+int VS_CC GetFrameHeight(const VSFrame*, int) VS_NOEXCEPT { return MockCore::HEIGHT; }
+
+void VS_CC GetFrameAsync(int n, VSNode*, VSFrameDoneCallback callback, void* userData) VS_NOEXCEPT {
+	{
+		std::lock_guard<std::mutex> lock(g_Core->mutex);
+		g_Core->pending.push_back({ n, callback, userData });
+		g_Core->requestCount++;
+	}
+	g_Core->condition.notify_all();
+}
+
+VSAPI MockAPI() {
+	VSAPI api = {};
+	api.getVideoInfo = GetVideoInfo;
+	api.addNodeRef = AddNodeRef;
+	api.freeNode = FreeNode;
+	api.freeFrame = FreeFrame;
+	api.getVideoFrameFormat = GetVideoFrameFormat;
+	api.getReadPtr = GetReadPtr;
+	api.getStride = GetStride;
+	api.getFrameWidth = GetFrameWidth;
+	api.getFrameHeight = GetFrameHeight;
+	api.getFrameAsync = GetFrameAsync;
+	return api;
+}
+
+std::string ReadFile(const std::filesystem::path& path) {
+	std::ifstream file(path, std::ios::binary);
+	return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+std::string ExpectedY4M(const int frames) {
+	std::string expected = "YUV4MPEG2 Cmono W6 H3 F24000:1001 Ip A0:0 XLENGTH=" + std::to_string(frames) + "\n";
+	for (int n = 0; n < frames; n++) {
+		expected += "FRAME\n" + std::string(MockCore::WIDTH * MockCore::HEIGHT, (char)n);
+	}
+	return expected;
+}
+
+}
+
+int RunY4MExportTests() {
+	int failures = 0;
+	const VSAPI api = MockAPI();
+	VSNode* node = (VSNode*)&api;
+	const std::filesystem::path path = std::filesystem::temp_directory_path() / "ivtcdn-y4m-export-test.y4m";
+
+	// Frames completed in any order are written in order, and each is freed once
+	{
+		MockCore core(300);
+		g_Core = &core;
+		core.Start();
+		Y4MExporter exporter;
+		TEST_CHECK(failures, exporter.Start(&api, nullptr, node, path.string(), 16));
+		exporter.Wait();
+		core.Stop();
+		TEST_CHECK(failures, exporter.Succeeded());
+		TEST_CHECK(failures, exporter.GetFramesWritten() == 300);
+		TEST_CHECK(failures, core.requestCount == 300);
+		TEST_CHECK(failures, ReadFile(path) == ExpectedY4M(300));
+		TEST_CHECK(failures, core.liveFrames == 0);
+		TEST_CHECK(failures, core.nodeRefs == 1);
+	}
+
+	// A failed frame stops the export, the requests still in flight come back and are freed before it ends
+	{
+		MockCore core(300);
+		core.failFrame = 100;
+		g_Core = &core;
+		core.Start();
+		Y4MExporter exporter;
+		TEST_CHECK(failures, exporter.Start(&api, nullptr, node, path.string(), 16));
+		exporter.Wait();
+		core.Stop();
+		TEST_CHECK(failures, !exporter.Succeeded());
+		TEST_CHECK(failures, exporter.GetError() == "Frame 100: mock failure");
+		TEST_CHECK(failures, exporter.GetFramesWritten() <= 100);
+		TEST_CHECK(failures, core.pending.empty());
+		TEST_CHECK(failures, core.liveFrames == 0);
+		TEST_CHECK(failures, core.nodeRefs == 1);
+	}
+
+	// Cancelling while the writer waits on a frame blocks until every request in flight has come back
+	{
+		MockCore core(300);
+		core.holdFirst = true;
+		g_Core = &core;
+		core.Start();
+		Y4MExporter exporter;
+		TEST_CHECK(failures, exporter.Start(&api, nullptr, node, path.string(), 16));
+		{
+			std::unique_lock<std::mutex> lock(core.mutex);
+			core.condition.wait(lock, [&]() { return core.requestCount == 16 && core.pending.size() == 1; });
+		}
+		std::thread release([&]() {
+			std::this_thread::sleep_for(std::chrono::milliseconds(50));
+			core.Release();
+		});
+		exporter.Cancel();
+		{
+			std::lock_guard<std::mutex> lock(core.mutex);
+			TEST_CHECK(failures, core.released);
+			TEST_CHECK(failures, core.pending.empty());
+		}
+		release.join();
+		core.Stop();
+		TEST_CHECK(failures, !exporter.IsRunning());
+		TEST_CHECK(failures, !exporter.Succeeded());
+		TEST_CHECK(failures, exporter.GetError() == "Cancelled");
+		TEST_CHECK(failures, exporter.GetFramesWritten() == 0);
+		TEST_CHECK(failures, core.requestCount == 16);
+		TEST_CHECK(failures, core.liveFrames == 0);
+		TEST_CHECK(failures, core.nodeRefs == 1);
+	}
+
+	g_Core = nullptr;
+	std::filesystem::remove(path);
+	return failures;
+}
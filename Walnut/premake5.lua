@@ -5,10 +5,19 @@ project "Walnut"
    targetdir "bin/%{cfg.buildcfg}"
    staticruntime "off"
 
-   files { "src/**.h", "src/**.cpp" }
+   files { "src/**.h", "src/**.cpp", "src/**.vert", "src/**.frag" }
+
+   -- Shaders are compiled to SPIR-V headers which Image.cpp embeds
+   prebuildcommands
+   {
+      "{MKDIR} generated",
+      '"%{GLSLANG_VALIDATOR}" -V --vn s_YUVToRGBVertexShader -o generated/YUVToRGB.vert.h src/Walnut/Shaders/YUVToRGB.vert',
+      '"%{GLSLANG_VALIDATOR}" -V --vn s_YUVToRGBFragmentShader -o generated/YUVToRGB.frag.h src/Walnut/Shaders/YUVToRGB.frag',
+   }
 
    includedirs
    {
+      "generated",
       "../vendor/imgui",
       "../vendor/glfw/include",
       "../vendor/stb_image",
@@ -1,4 +1,7 @@
 #include "Application.h"
+#include "Image.h"
+#include "JobSystem.h"
+#include "MemoryAllocator.h"
 
 //
 // Adapted from Dear ImGui Vulkan example
@@ -16,6 +19,7 @@
 #include <iostream>
 
 #include <chrono>
+#include <future>
 #include <thread>
 
 // Emedded font
@@ -386,7 +390,7 @@ static void glfw_error_callback(int error, const char* description)
 namespace Walnut {
 
 	Application::Application(const ApplicationSpecification& specification)
-		: m_Specification(specification)
+		: m_Specification(specification), m_StartupMark(std::chrono::steady_clock::now())
 	{
 		Init();
 	}
@@ -398,21 +402,65 @@ namespace Walnut {
 
 	void Application::Init()
 	{
+		JobSystem::Init();
+		MarkStartupStage("job system");
+
+		// Setup Dear ImGui context
+		IMGUI_CHECKVERSION();
+		ImGui::CreateContext();
+		ImGuiIO& io = ImGui::GetIO(); (void)io;
+		io.ConfigFlags |= ImGuiConfigFlags_NavEnableKeyboard;       // Enable Keyboard Controls
+		//io.ConfigFlags |= ImGuiConfigFlags_NavEnableGamepad;      // Enable Gamepad Controls
+		io.ConfigFlags |= ImGuiConfigFlags_DockingEnable;           // Enable Docking
+		io.ConfigFlags |= ImGuiConfigFlags_ViewportsEnable;         // Enable Multi-Viewport / Platform Windows
+		//io.ConfigViewportsNoAutoMerge = true;
+		//io.ConfigViewportsNoTaskBarIcon = true;
+
+		// Setup Dear ImGui style
+		ImGui::StyleColorsDark();
+		//ImGui::StyleColorsClassic();
+
+		// When viewports are enabled we tweak WindowRounding/WindowBg so platform windows can look identical to regular ones.
+		ImGuiStyle& style = ImGui::GetStyle();
+		if (io.ConfigFlags & ImGuiConfigFlags_ViewportsEnable)
+		{
+			style.WindowRounding = 0.0f;
+			style.Colors[ImGuiCol_WindowBg].w = 1.0f;
+		}
+
+		// Rasterise the fonts on a worker while the window and Vulkan device are created. Nothing else may allocate through
+		// ImGui (the swapchain helpers do) until the atlas is built, those allocations count towards the context's metrics.
+		using FontPair = std::pair<ImFont*, ImFont*>;
+		auto buildFonts = std::make_shared<std::packaged_task<FontPair()>>([atlas = io.Fonts]()
+		{
+			ImFontConfig fontConfig;
+			fontConfig.FontDataOwnedByAtlas = false;
+			ImFont* robotoFont = atlas->AddFontFromMemoryTTF((void*)g_RobotoRegular, sizeof(g_RobotoRegular), 20.0f, &fontConfig);
+			ImFont* ubuntuMonoFont = atlas->AddFontFromMemoryCompressedTTF(UbuntuMono_compressed_data, UbuntuMono_compressed_size, 64.0f, &fontConfig);
+			atlas->Build();
+			return FontPair(robotoFont, ubuntuMonoFont);
+		});
+		std::future<FontPair> fontsBuilt = buildFonts->get_future();
+		JobSystem::Submit(JobPriority::Interactive, [buildFonts]() { (*buildFonts)(); });
+
 		// Setup GLFW window
 		glfwSetErrorCallback(glfw_error_callback);
 		if (!glfwInit())
 		{
 			std::cerr << "Could not initalize GLFW!\n";
+			fontsBuilt.wait();
 			return;
 		}
 
 		glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
 		m_WindowHandle = glfwCreateWindow(m_Specification.Width, m_Specification.Height, m_Specification.Name.c_str(), NULL, NULL);
+		MarkStartupStage("window");
 
 		// Setup Vulkan
 		if (!glfwVulkanSupported())
 		{
 			std::cerr << "GLFW: Vulkan not supported!\n";
+			fontsBuilt.wait();
 			return;
 		}
 		uint32_t extensions_count = 0;
@@ -423,6 +471,13 @@ namespace Walnut {
 		VkSurfaceKHR surface;
 		VkResult err = glfwCreateWindowSurface(g_Instance, m_WindowHandle, g_Allocator, &surface);
 		check_vk_result(err);
+		MarkStartupStage("vulkan");
+
+		// Usually built by now
+		const FontPair fonts = fontsBuilt.get();
+		io.FontDefault = fonts.first;
+		m_UbuntuMonoFont = fonts.second;
+		MarkStartupStage("font atlas wait");
 
 		// Create Framebuffers
 		int w, h;
@@ -432,29 +487,7 @@ namespace Walnut {
 
 		s_AllocatedCommandBuffers.resize(wd->ImageCount);
 		s_ResourceFreeQueue.resize(wd->ImageCount);
-
-		// Setup Dear ImGui context
-		IMGUI_CHECKVERSION();
-		ImGui::CreateContext();
-		ImGuiIO& io = ImGui::GetIO(); (void)io;
-		io.ConfigFlags |= ImGuiConfigFlags_NavEnableKeyboard;       // Enable Keyboard Controls
-		//io.ConfigFlags |= ImGuiConfigFlags_NavEnableGamepad;      // Enable Gamepad Controls
-		io.ConfigFlags |= ImGuiConfigFlags_DockingEnable;           // Enable Docking
-		io.ConfigFlags |= ImGuiConfigFlags_ViewportsEnable;         // Enable Multi-Viewport / Platform Windows
-		//io.ConfigViewportsNoAutoMerge = true;
-		//io.ConfigViewportsNoTaskBarIcon = true;
-
-		// Setup Dear ImGui style
-		ImGui::StyleColorsDark();
-		//ImGui::StyleColorsClassic();
-
-		// When viewports are enabled we tweak WindowRounding/WindowBg so platform windows can look identical to regular ones.
-		ImGuiStyle& style = ImGui::GetStyle();
-		if (io.ConfigFlags & ImGuiConfigFlags_ViewportsEnable)
-		{
-			style.WindowRounding = 0.0f;
-			style.Colors[ImGuiCol_WindowBg].w = 1.0f;
-		}
+		MarkStartupStage("swapchain");
 
 		// Setup Platform/Renderer backends
 		ImGui_ImplGlfw_InitForVulkan(m_WindowHandle, true);
@@ -473,13 +506,7 @@ namespace Walnut {
 		init_info.Allocator = g_Allocator;
 		init_info.CheckVkResultFn = check_vk_result;
 		ImGui_ImplVulkan_Init(&init_info, wd->RenderPass);
-
-		// Load default font
-		ImFontConfig fontConfig;
-		fontConfig.FontDataOwnedByAtlas = false;
-		ImFont* robotoFont = io.Fonts->AddFontFromMemoryTTF((void*)g_RobotoRegular, sizeof(g_RobotoRegular), 20.0f, &fontConfig);
-		m_UbuntuMonoFont = io.Fonts->AddFontFromMemoryCompressedTTF(UbuntuMono_compressed_data, UbuntuMono_compressed_size, 64.0f, & fontConfig);
-		io.FontDefault = robotoFont;
+		MarkStartupStage("imgui backends");
 
 		// Upload Fonts
 		{
@@ -510,6 +537,7 @@ namespace Walnut {
 			check_vk_result(err);
 			ImGui_ImplVulkan_DestroyFontUploadObjects();
 		}
+		MarkStartupStage("font upload");
 	}
 
 	void Application::Shutdown()
@@ -518,6 +546,8 @@ namespace Walnut {
 			layer->OnDetach();
 
 		m_LayerStack.clear();
+		// After the layers, whose destructors may wait on their jobs
+		JobSystem::Shutdown();
 
 		// Cleanup
 		VkResult err = vkDeviceWaitIdle(g_Device);
@@ -530,6 +560,8 @@ namespace Walnut {
 				func();
 		}
 		s_ResourceFreeQueue.clear();
+		Image::ReleaseSharedResources();
+		MemoryAllocator::Shutdown();
 
 		ImGui_ImplVulkan_Shutdown();
 		ImGui_ImplGlfw_Shutdown();
@@ -562,6 +594,9 @@ namespace Walnut {
 			// Generally you may always pass all inputs to dear imgui, and hide them from your application based on those two flags.
 			glfwPollEvents();
 
+			// Continuations of background jobs, before the layers look at their results
+			JobSystem::RunMainThreadTasks();
+
 			// Resize swap chain?
 			if (g_SwapChainRebuild)
 			{
@@ -668,10 +703,39 @@ namespace Walnut {
 				// Sleep if window is minimized to avoid 100% cpu usage
 				std::this_thread::sleep_for(std::chrono::microseconds(6944)); // Approx 144Hz
 			}
+
+			if (!m_StartupReported)
+				ReportStartupTimings();
 		}
 
 	}
 
+	void Application::MarkStartupStage(const std::string& stage)
+	{
+		if (m_StartupReported)
+			return;
+		const auto now = std::chrono::steady_clock::now();
+		m_StartupTimings.emplace_back(stage, std::chrono::duration<double, std::milli>(now - m_StartupMark).count());
+		m_StartupMark = now;
+	}
+
+	void Application::ReportStartupTimings()
+	{
+		MarkStartupStage("first frame");
+		m_StartupReported = true;
+		if (!m_Specification.PrintStartupTiming)
+			return;
+
+		double total = 0.0;
+		fprintf(stderr, "Startup timing:\n");
+		for (const auto& [stage, milliseconds] : m_StartupTimings)
+		{
+			fprintf(stderr, "  %-22s %8.1f ms\n", stage.c_str(), milliseconds);
+			total += milliseconds;
+		}
+		fprintf(stderr, "  %-22s %8.1f ms\n", "total", total);
+	}
+
 	void Application::Close()
 	{
 		m_Running = false;
@@ -759,4 +823,12 @@ namespace Walnut {
 		s_ResourceFreeQueue[s_CurrentFrameIndex].emplace_back(func);
 	}
 
+	size_t Application::GetPendingResourceFreeCount()
+	{
+		size_t count = 0;
+		for (const auto& queue : s_ResourceFreeQueue)
+			count += queue.size();
+		return count;
+	}
+
 }
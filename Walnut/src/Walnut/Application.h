@@ -6,6 +6,7 @@
 #include <vector>
 #include <memory>
 #include <functional>
+#include <chrono>
 
 #include "imgui.h"
 #include "vulkan/vulkan.h"
@@ -21,6 +22,8 @@ namespace Walnut {
 		std::string Name = "Walnut App";
 		uint32_t Width = 1600;
 		uint32_t Height = 900;
+		// Print how long each stage of startup took once the first frame is presented
+		bool PrintStartupTiming = false;
 	};
 
 	class Application
@@ -45,6 +48,9 @@ namespace Walnut {
 
 		GLFWwindow* GetWindowHandle();
 
+		// Records the time since the previous stage (or construction) under stage, until the first frame is presented
+		void MarkStartupStage(const std::string& stage);
+
 		ImFont* m_UbuntuMonoFont;
 
 		static VkInstance GetInstance();
@@ -55,9 +61,12 @@ namespace Walnut {
 		static void FlushCommandBuffer(VkCommandBuffer commandBuffer);
 
 		static void SubmitResourceFree(std::function<void()>&& func);
+		// Resources submitted for freeing which are still waiting on the frames that may use them
+		static size_t GetPendingResourceFreeCount();
 	private:
 		void Init();
 		void Shutdown();
+		void ReportStartupTimings();
 	private:
 		ApplicationSpecification m_Specification;
 		GLFWwindow* m_WindowHandle = nullptr;
@@ -65,6 +74,10 @@ namespace Walnut {
 
 		std::vector<std::shared_ptr<Layer>> m_LayerStack;
 		std::function<void()> m_MenubarCallback;
+
+		std::chrono::steady_clock::time_point m_StartupMark;
+		std::vector<std::pair<std::string, double>> m_StartupTimings;
+		bool m_StartupReported = false;
 	};
 
 	// Implemented by CLIENT
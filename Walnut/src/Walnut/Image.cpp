@@ -4,26 +4,24 @@
 #include "backends/imgui_impl_vulkan.h"
 
 #include "Application.h"
+#include "MemoryAllocator.h"
+
+#include <atomic>
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 
+// SPIR-V compiled from Shaders/ by the prebuild step
+#include "YUVToRGB.vert.h"
+#include "YUVToRGB.frag.h"
+
 namespace Walnut {
 
-	namespace Utils {
+	static std::atomic<uint64_t> s_DeviceLocalBytes = 0;
+	static std::atomic<uint64_t> s_HostVisibleBytes = 0;
+	static std::atomic<uint32_t> s_ImageCount = 0;
 
-		static uint32_t GetVulkanMemoryType(VkMemoryPropertyFlags properties, uint32_t type_bits)
-		{
-			VkPhysicalDeviceMemoryProperties prop;
-			vkGetPhysicalDeviceMemoryProperties(Application::GetPhysicalDevice(), &prop);
-			for (uint32_t i = 0; i < prop.memoryTypeCount; i++)
-			{
-				if ((prop.memoryTypes[i].propertyFlags & properties) == properties && type_bits & (1 << i))
-					return i;
-			}
-			
-			return 0xffffffff;
-		}
+	namespace Utils {
 
 		static uint32_t BytesPerPixel(ImageFormat format)
 		{
@@ -32,7 +30,8 @@ namespace Walnut {
 				case ImageFormat::RGBA:    return 4;
 				case ImageFormat::RGBA32F: return 16;
 			}
-			return 0;
+			// YUV formats are converted into RGBA
+			return Image::IsYUV(format) ? 4 : 0;
 		}
 		
 		static VkFormat WalnutFormatToVulkanFormat(ImageFormat format)
@@ -42,7 +41,330 @@ namespace Walnut {
 				case ImageFormat::RGBA:    return VK_FORMAT_R8G8B8A8_UNORM;
 				case ImageFormat::RGBA32F: return VK_FORMAT_R32G32B32A32_SFLOAT;
 			}
-			return (VkFormat)0;
+			return Image::IsYUV(format) ? VK_FORMAT_R8G8B8A8_UNORM : (VkFormat)0;
+		}
+
+		static uint32_t BytesPerSample(ImageFormat format)
+		{
+			switch (format)
+			{
+				case ImageFormat::YUV420P8:
+				case ImageFormat::YUV422P8:
+				case ImageFormat::YUV444P8:  return 1;
+				case ImageFormat::YUV420P16:
+				case ImageFormat::YUV422P16:
+				case ImageFormat::YUV444P16: return 2;
+			}
+			return 0;
+		}
+
+		static VkFormat PlaneFormat(ImageFormat format)
+		{
+			return BytesPerSample(format) == 2 ? VK_FORMAT_R16_UNORM : VK_FORMAT_R8_UNORM;
+		}
+
+		static void ChromaSubsampling(ImageFormat format, uint32_t& shiftW, uint32_t& shiftH)
+		{
+			shiftW = 0;
+			shiftH = 0;
+			switch (format)
+			{
+				case ImageFormat::YUV420P8:
+				case ImageFormat::YUV420P16: shiftW = 1; shiftH = 1; break;
+				case ImageFormat::YUV422P8:
+				case ImageFormat::YUV422P16: shiftW = 1; break;
+			}
+		}
+
+		// Returns the bytes allocated
+		static VkDeviceSize CreateImage(VkFormat format, uint32_t width, uint32_t height, VkImageUsageFlags usage, VkImage& image, MemoryAllocation& memory, VkImageView& view)
+		{
+			VkDevice device = Application::GetDevice();
+
+			VkImageCreateInfo info = {};
+			info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+			info.imageType = VK_IMAGE_TYPE_2D;
+			info.format = format;
+			info.extent.width = width;
+			info.extent.height = height;
+			info.extent.depth = 1;
+			info.mipLevels = 1;
+			info.arrayLayers = 1;
+			info.samples = VK_SAMPLE_COUNT_1_BIT;
+			info.tiling = VK_IMAGE_TILING_OPTIMAL;
+			info.usage = usage;
+			info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+			info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+			VkResult err = vkCreateImage(device, &info, nullptr, &image);
+			check_vk_result(err);
+			VkMemoryRequirements req;
+			vkGetImageMemoryRequirements(device, image, &req);
+			memory = MemoryAllocator::Allocate(req, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, false);
+			err = vkBindImageMemory(device, image, memory.Memory, memory.Offset);
+			check_vk_result(err);
+
+			VkImageViewCreateInfo view_info = {};
+			view_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+			view_info.image = image;
+			view_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+			view_info.format = format;
+			view_info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			view_info.subresourceRange.levelCount = 1;
+			view_info.subresourceRange.layerCount = 1;
+			err = vkCreateImageView(device, &view_info, nullptr, &view);
+			check_vk_result(err);
+
+			s_DeviceLocalBytes += req.size;
+			return req.size;
+		}
+
+	}
+
+	// Shared by every YUV image, created with the first one
+	namespace YUV {
+
+		struct PushConstants
+		{
+			float Rows[3][4];
+			float Range[4];
+		};
+
+		static VkRenderPass s_RenderPass = nullptr;
+		static VkDescriptorSetLayout s_SetLayout = nullptr;
+		static VkPipelineLayout s_PipelineLayout = nullptr;
+		static VkPipeline s_Pipeline = nullptr;
+		static VkSampler s_LinearSampler = nullptr;
+		static VkSampler s_NearestSampler = nullptr;
+
+		static VkShaderModule CreateShaderModule(const uint32_t* code, size_t size)
+		{
+			VkShaderModuleCreateInfo info = {};
+			info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+			info.codeSize = size;
+			info.pCode = code;
+			VkShaderModule module;
+			VkResult err = vkCreateShaderModule(Application::GetDevice(), &info, nullptr, &module);
+			check_vk_result(err);
+			return module;
+		}
+
+		static VkSampler CreateSampler(VkFilter filter)
+		{
+			VkSamplerCreateInfo info = {};
+			info.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+			info.magFilter = filter;
+			info.minFilter = filter;
+			info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+			info.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+			info.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+			info.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+			info.maxAnisotropy = 1.0f;
+			VkSampler sampler;
+			VkResult err = vkCreateSampler(Application::GetDevice(), &info, nullptr, &sampler);
+			check_vk_result(err);
+			return sampler;
+		}
+
+		static void CreateSharedResources()
+		{
+			if (s_Pipeline)
+				return;
+
+			VkDevice device = Application::GetDevice();
+			VkResult err;
+
+			// Render Pass, the whole target is drawn over so its previous contents are never loaded
+			{
+				VkAttachmentDescription attachment = {};
+				attachment.format = VK_FORMAT_R8G8B8A8_UNORM;
+				attachment.samples = VK_SAMPLE_COUNT_1_BIT;
+				attachment.loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+				attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+				attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+				attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+				attachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+				attachment.finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+				VkAttachmentReference color_attachment = {};
+				color_attachment.attachment = 0;
+				color_attachment.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+				VkSubpassDescription subpass = {};
+				subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+				subpass.colorAttachmentCount = 1;
+				subpass.pColorAttachments = &color_attachment;
+				// Wait for earlier frames to stop sampling the image before overwriting it, and make the result visible to them after
+				VkSubpassDependency dependencies[2] = {};
+				dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+				dependencies[0].dstSubpass = 0;
+				dependencies[0].srcStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+				dependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+				dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+				dependencies[1].srcSubpass = 0;
+				dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+				dependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+				dependencies[1].dstStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+				dependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+				dependencies[1].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+				VkRenderPassCreateInfo info = {};
+				info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+				info.attachmentCount = 1;
+				info.pAttachments = &attachment;
+				info.subpassCount = 1;
+				info.pSubpasses = &subpass;
+				info.dependencyCount = 2;
+				info.pDependencies = dependencies;
+				err = vkCreateRenderPass(device, &info, nullptr, &s_RenderPass);
+				check_vk_result(err);
+			}
+
+			// Descriptor Set Layout, one sampler per plane
+			{
+				VkDescriptorSetLayoutBinding binding = {};
+				binding.binding = 0;
+				binding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+				binding.descriptorCount = 3;
+				binding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+				VkDescriptorSetLayoutCreateInfo info = {};
+				info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+				info.bindingCount = 1;
+				info.pBindings = &binding;
+				err = vkCreateDescriptorSetLayout(device, &info, nullptr, &s_SetLayout);
+				check_vk_result(err);
+			}
+
+			// Pipeline Layout
+			{
+				VkPushConstantRange push_constants = {};
+				push_constants.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+				push_constants.size = sizeof(PushConstants);
+				VkPipelineLayoutCreateInfo info = {};
+				info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+				info.setLayoutCount = 1;
+				info.pSetLayouts = &s_SetLayout;
+				info.pushConstantRangeCount = 1;
+				info.pPushConstantRanges = &push_constants;
+				err = vkCreatePipelineLayout(device, &info, nullptr, &s_PipelineLayout);
+				check_vk_result(err);
+			}
+
+			// Pipeline, a single full screen triangle with no vertex input
+			{
+				VkShaderModule vertex_module = CreateShaderModule(s_YUVToRGBVertexShader, sizeof(s_YUVToRGBVertexShader));
+				VkShaderModule fragment_module = CreateShaderModule(s_YUVToRGBFragmentShader, sizeof(s_YUVToRGBFragmentShader));
+
+				VkPipelineShaderStageCreateInfo stages[2] = {};
+				stages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+				stages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+				stages[0].module = vertex_module;
+				stages[0].pName = "main";
+				stages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+				stages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+				stages[1].module = fragment_module;
+				stages[1].pName = "main";
+
+				VkPipelineVertexInputStateCreateInfo vertex_info = {};
+				vertex_info.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+
+				VkPipelineInputAssemblyStateCreateInfo ia_info = {};
+				ia_info.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+				ia_info.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+
+				VkPipelineViewportStateCreateInfo viewport_info = {};
+				viewport_info.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+				viewport_info.viewportCount = 1;
+				viewport_info.scissorCount = 1;
+
+				VkPipelineRasterizationStateCreateInfo raster_info = {};
+				raster_info.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+				raster_info.polygonMode = VK_POLYGON_MODE_FILL;
+				raster_info.cullMode = VK_CULL_MODE_NONE;
+				raster_info.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+				raster_info.lineWidth = 1.0f;
+
+				VkPipelineMultisampleStateCreateInfo ms_info = {};
+				ms_info.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+				ms_info.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+				VkPipelineColorBlendAttachmentState color_attachment = {};
+				color_attachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+
+				VkPipelineColorBlendStateCreateInfo blend_info = {};
+				blend_info.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+				blend_info.attachmentCount = 1;
+				blend_info.pAttachments = &color_attachment;
+
+				VkDynamicState dynamic_states[2] = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+				VkPipelineDynamicStateCreateInfo dynamic_state = {};
+				dynamic_state.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+				dynamic_state.dynamicStateCount = 2;
+				dynamic_state.pDynamicStates = dynamic_states;
+
+				VkGraphicsPipelineCreateInfo info = {};
+				info.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+				info.stageCount = 2;
+				info.pStages = stages;
+				info.pVertexInputState = &vertex_info;
+				info.pInputAssemblyState = &ia_info;
+				info.pViewportState = &viewport_info;
+				info.pRasterizationState = &raster_info;
+				info.pMultisampleState = &ms_info;
+				info.pColorBlendState = &blend_info;
+				info.pDynamicState = &dynamic_state;
+				info.layout = s_PipelineLayout;
+				info.renderPass = s_RenderPass;
+				err = vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &info, nullptr, &s_Pipeline);
+				check_vk_result(err);
+
+				vkDestroyShaderModule(device, vertex_module, nullptr);
+				vkDestroyShaderModule(device, fragment_module, nullptr);
+			}
+
+			s_LinearSampler = CreateSampler(VK_FILTER_LINEAR);
+			s_NearestSampler = CreateSampler(VK_FILTER_NEAREST);
+		}
+
+		static bool SupportsFeatures(VkFormat format, VkFormatFeatureFlags features)
+		{
+			VkFormatProperties properties;
+			vkGetPhysicalDeviceFormatProperties(Application::GetPhysicalDevice(), format, &properties);
+			return (properties.optimalTilingFeatures & features) == features;
+		}
+
+		static PushConstants MakePushConstants(const YUVColorimetry& colorimetry, ImageFormat format)
+		{
+			float kr = 0.299f, kb = 0.114f;
+			switch (colorimetry.Matrix)
+			{
+				case YUVMatrix::BT709:  kr = 0.2126f; kb = 0.0722f; break;
+				case YUVMatrix::BT2020: kr = 0.2627f; kb = 0.0593f; break;
+			}
+			const float kg = 1.0f - kr - kb;
+
+			PushConstants constants = {};
+			constants.Rows[0][0] = 1.0f;
+			constants.Rows[0][2] = 2.0f * (1.0f - kr);
+			constants.Rows[1][0] = 1.0f;
+			constants.Rows[1][1] = -2.0f * kb * (1.0f - kb) / kg;
+			constants.Rows[1][2] = -2.0f * kr * (1.0f - kr) / kg;
+			constants.Rows[2][0] = 1.0f;
+			constants.Rows[2][1] = 2.0f * (1.0f - kb);
+
+			// Samples arrive normalized to the container, so 10 bit white in a 16 bit plane reads as 1023 / 65535
+			const uint32_t bits = colorimetry.BitDepth;
+			const float max = (float)((1u << bits) - 1);
+			const float norm = (Utils::BytesPerSample(format) == 2 ? 65535.0f : 255.0f) / max;
+			float y_offset = 0.0f, y_scale = 1.0f, c_offset = (float)(1u << (bits - 1)) / max, c_scale = 1.0f;
+			if (!colorimetry.FullRange)
+			{
+				y_offset = (float)(16u << (bits - 8)) / max;
+				y_scale = max / (float)(219u << (bits - 8));
+				c_offset = (float)(128u << (bits - 8)) / max;
+				c_scale = max / (float)(224u << (bits - 8));
+			}
+			constants.Range[0] = norm * y_scale;
+			constants.Range[1] = -y_offset * y_scale;
+			constants.Range[2] = norm * c_scale;
+			constants.Range[3] = -c_offset * c_scale;
+			return constants;
 		}
 
 	}
@@ -75,6 +397,8 @@ namespace Walnut {
 		: m_Width(width), m_Height(height), m_Format(format)
 	{
 		AllocateMemory(m_Width * m_Height * Utils::BytesPerPixel(m_Format));
+		if (IsYUV(m_Format))
+			AllocatePlanes();
 		if (data)
 			SetData(data);
 	}
@@ -82,69 +406,83 @@ namespace Walnut {
 	Image::~Image()
 	{
 		Application::SubmitResourceFree([sampler = m_Sampler, imageView = m_ImageView, image = m_Image,
-			memory = m_Memory, stagingBuffer = m_StagingBuffer, stagingBufferMemory = m_StagingBufferMemory]()
+			memory = m_Memory, stagingBuffer = m_StagingBuffer, stagingBufferMemory = m_StagingBufferMemory,
+			planes = m_Planes, framebuffer = m_Framebuffer, planeDescriptorPool = m_PlaneDescriptorPool,
+			deviceBytes = m_DeviceBytes, hostBytes = m_StagingBuffer ? m_AlignedSize : 0]()
 		{
 			VkDevice device = Application::GetDevice();
 
 			vkDestroySampler(device, sampler, nullptr);
 			vkDestroyImageView(device, imageView, nullptr);
 			vkDestroyImage(device, image, nullptr);
-			vkFreeMemory(device, memory, nullptr);
+			MemoryAllocator::Free(memory);
 			vkDestroyBuffer(device, stagingBuffer, nullptr);
-			vkFreeMemory(device, stagingBufferMemory, nullptr);
+			MemoryAllocator::Free(stagingBufferMemory);
+
+			for (const Plane& plane : planes)
+			{
+				vkDestroyImageView(device, plane.View, nullptr);
+				vkDestroyImage(device, plane.Image, nullptr);
+				MemoryAllocator::Free(plane.Memory);
+			}
+			vkDestroyFramebuffer(device, framebuffer, nullptr);
+			vkDestroyDescriptorPool(device, planeDescriptorPool, nullptr);
+
+			s_DeviceLocalBytes -= deviceBytes;
+			s_HostVisibleBytes -= hostBytes;
+			s_ImageCount--;
 		});
 	}
 
+	bool Image::IsYUV(ImageFormat format)
+	{
+		return Utils::BytesPerSample(format) != 0;
+	}
+
+	bool Image::IsSupported(ImageFormat format)
+	{
+		if (!IsYUV(format))
+			return true;
+		return YUV::SupportsFeatures(Utils::PlaneFormat(format), VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT | VK_FORMAT_FEATURE_TRANSFER_DST_BIT);
+	}
+
+	ImageMemoryStats Image::GetMemoryStats()
+	{
+		ImageMemoryStats stats;
+		stats.DeviceLocalBytes = s_DeviceLocalBytes;
+		stats.HostVisibleBytes = s_HostVisibleBytes;
+		stats.ImageCount = s_ImageCount;
+		return stats;
+	}
+
+	void Image::ReleaseSharedResources()
+	{
+		if (!YUV::s_Pipeline)
+			return;
+
+		VkDevice device = Application::GetDevice();
+		vkDestroySampler(device, YUV::s_LinearSampler, nullptr);
+		vkDestroySampler(device, YUV::s_NearestSampler, nullptr);
+		vkDestroyPipeline(device, YUV::s_Pipeline, nullptr);
+		vkDestroyPipelineLayout(device, YUV::s_PipelineLayout, nullptr);
+		vkDestroyDescriptorSetLayout(device, YUV::s_SetLayout, nullptr);
+		vkDestroyRenderPass(device, YUV::s_RenderPass, nullptr);
+		YUV::s_Pipeline = nullptr;
+	}
+
 	void Image::AllocateMemory(uint64_t size)
 	{
 		VkDevice device = Application::GetDevice();
 
-		VkResult err;
-		
 		VkFormat vulkanFormat = Utils::WalnutFormatToVulkanFormat(m_Format);
 
-		// Create the Image
-		{
-			VkImageCreateInfo info = {};
-			info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
-			info.imageType = VK_IMAGE_TYPE_2D;
-			info.format = vulkanFormat;
-			info.extent.width = m_Width;
-			info.extent.height = m_Height;
-			info.extent.depth = 1;
-			info.mipLevels = 1;
-			info.arrayLayers = 1;
-			info.samples = VK_SAMPLE_COUNT_1_BIT;
-			info.tiling = VK_IMAGE_TILING_OPTIMAL;
-			info.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
-			info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-			info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-			err = vkCreateImage(device, &info, nullptr, &m_Image);
-			check_vk_result(err);
-			VkMemoryRequirements req;
-			vkGetImageMemoryRequirements(device, m_Image, &req);
-			VkMemoryAllocateInfo alloc_info = {};
-			alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-			alloc_info.allocationSize = req.size;
-			alloc_info.memoryTypeIndex = Utils::GetVulkanMemoryType(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, req.memoryTypeBits);
-			err = vkAllocateMemory(device, &alloc_info, nullptr, &m_Memory);
-			check_vk_result(err);
-			err = vkBindImageMemory(device, m_Image, m_Memory, 0);
-			check_vk_result(err);
-		}
-
-		// Create the Image View:
+		// Create the Image and Image View, YUV images are rendered into rather than copied to
 		{
-			VkImageViewCreateInfo info = {};
-			info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
-			info.image = m_Image;
-			info.viewType = VK_IMAGE_VIEW_TYPE_2D;
-			info.format = vulkanFormat;
-			info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-			info.subresourceRange.levelCount = 1;
-			info.subresourceRange.layerCount = 1;
-			err = vkCreateImageView(device, &info, nullptr, &m_ImageView);
-			check_vk_result(err);
+			VkImageUsageFlags usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+			if (IsYUV(m_Format))
+				usage |= VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+			m_DeviceBytes += Utils::CreateImage(vulkanFormat, m_Width, m_Height, usage, m_Image, m_Memory, m_ImageView);
+			s_ImageCount++;
 		}
 
 		// Create sampler:
@@ -168,53 +506,143 @@ namespace Walnut {
 		m_DescriptorSet = (VkDescriptorSet)ImGui_ImplVulkan_AddTexture(m_Sampler, m_ImageView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
 	}
 
-	void Image::SetData(const void* data)
+	void Image::AllocatePlanes()
 	{
 		VkDevice device = Application::GetDevice();
 
-		size_t upload_size = m_Width * m_Height * Utils::BytesPerPixel(m_Format);
-
 		VkResult err;
 
-		if (!m_StagingBuffer)
+		YUV::CreateSharedResources();
+
+		VkFormat plane_format = Utils::PlaneFormat(m_Format);
+		uint32_t shift_w, shift_h;
+		Utils::ChromaSubsampling(m_Format, shift_w, shift_h);
+
+		// Create the Plane Images
+		for (int i = 0; i < 3; i++)
+		{
+			Plane& plane = m_Planes[i];
+			plane.Width = i == 0 ? m_Width : m_Width >> shift_w;
+			plane.Height = i == 0 ? m_Height : m_Height >> shift_h;
+			m_DeviceBytes += Utils::CreateImage(plane_format, plane.Width, plane.Height, VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT, plane.Image, plane.Memory, plane.View);
+		}
+
+		// Create the Framebuffer:
 		{
-			// Create the Upload Buffer
+			VkFramebufferCreateInfo info = {};
+			info.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+			info.renderPass = YUV::s_RenderPass;
+			info.attachmentCount = 1;
+			info.pAttachments = &m_ImageView;
+			info.width = m_Width;
+			info.height = m_Height;
+			info.layers = 1;
+			err = vkCreateFramebuffer(device, &info, nullptr, &m_Framebuffer);
+			check_vk_result(err);
+		}
+
+		// Create the Plane Descriptor Set, from a pool of its own so it's freed along with the image
+		{
+			VkDescriptorPoolSize pool_size = {};
+			pool_size.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+			pool_size.descriptorCount = 3;
+			VkDescriptorPoolCreateInfo pool_info = {};
+			pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+			pool_info.maxSets = 1;
+			pool_info.poolSizeCount = 1;
+			pool_info.pPoolSizes = &pool_size;
+			err = vkCreateDescriptorPool(device, &pool_info, nullptr, &m_PlaneDescriptorPool);
+			check_vk_result(err);
+
+			VkDescriptorSetAllocateInfo alloc_info = {};
+			alloc_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+			alloc_info.descriptorPool = m_PlaneDescriptorPool;
+			alloc_info.descriptorSetCount = 1;
+			alloc_info.pSetLayouts = &YUV::s_SetLayout;
+			err = vkAllocateDescriptorSets(device, &alloc_info, &m_PlaneDescriptorSet);
+			check_vk_result(err);
+
+			// Chroma is interpolated up to full size, unless the device can't filter 16 bit planes
+			VkSampler sampler = YUV::SupportsFeatures(plane_format, VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT) ? YUV::s_LinearSampler : YUV::s_NearestSampler;
+			VkDescriptorImageInfo image_info[3] = {};
+			for (int i = 0; i < 3; i++)
 			{
-				VkBufferCreateInfo buffer_info = {};
-				buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-				buffer_info.size = upload_size;
-				buffer_info.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-				buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-				err = vkCreateBuffer(device, &buffer_info, nullptr, &m_StagingBuffer);
-				check_vk_result(err);
-				VkMemoryRequirements req;
-				vkGetBufferMemoryRequirements(device, m_StagingBuffer, &req);
-				m_AlignedSize = req.size;
-				VkMemoryAllocateInfo alloc_info = {};
-				alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-				alloc_info.allocationSize = req.size;
-				alloc_info.memoryTypeIndex = Utils::GetVulkanMemoryType(VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, req.memoryTypeBits);
-				err = vkAllocateMemory(device, &alloc_info, nullptr, &m_StagingBufferMemory);
-				check_vk_result(err);
-				err = vkBindBufferMemory(device, m_StagingBuffer, m_StagingBufferMemory, 0);
-				check_vk_result(err);
+				image_info[i].sampler = sampler;
+				image_info[i].imageView = m_Planes[i].View;
+				image_info[i].imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
 			}
-
+			VkWriteDescriptorSet write = {};
+			write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			write.dstSet = m_PlaneDescriptorSet;
+			write.descriptorCount = 3;
+			write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+			write.pImageInfo = image_info;
+			vkUpdateDescriptorSets(device, 1, &write, 0, nullptr);
 		}
+	}
 
-		// Upload to Buffer
+	void Image::EnsureStagingBuffer(size_t size)
+	{
+		if (m_StagingBuffer && size <= m_StagingSize)
+			return;
+
+		VkDevice device = Application::GetDevice();
+
+		VkResult err;
+
+		// Uploads wait for their copy to finish, so nothing can still be reading a smaller buffer
+		if (m_StagingBuffer)
+			s_HostVisibleBytes -= m_AlignedSize;
+		vkDestroyBuffer(device, m_StagingBuffer, nullptr);
+		MemoryAllocator::Free(m_StagingBufferMemory);
+
+		// Create the Upload Buffer
 		{
-			char* map = NULL;
-			err = vkMapMemory(device, m_StagingBufferMemory, 0, m_AlignedSize, 0, (void**)(&map));
+			VkBufferCreateInfo buffer_info = {};
+			buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+			buffer_info.size = size;
+			buffer_info.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+			buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+			err = vkCreateBuffer(device, &buffer_info, nullptr, &m_StagingBuffer);
 			check_vk_result(err);
-			memcpy(map, data, upload_size);
-			VkMappedMemoryRange range[1] = {};
-			range[0].sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-			range[0].memory = m_StagingBufferMemory;
-			range[0].size = m_AlignedSize;
-			err = vkFlushMappedMemoryRanges(device, 1, range);
+			VkMemoryRequirements req;
+			vkGetBufferMemoryRequirements(device, m_StagingBuffer, &req);
+			m_AlignedSize = req.size;
+			m_StagingBufferMemory = MemoryAllocator::Allocate(req, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, true);
+			err = vkBindBufferMemory(device, m_StagingBuffer, m_StagingBufferMemory.Memory, m_StagingBufferMemory.Offset);
 			check_vk_result(err);
-			vkUnmapMemory(device, m_StagingBufferMemory);
+		}
+		m_StagingSize = size;
+		s_HostVisibleBytes += m_AlignedSize;
+	}
+
+	void Image::SetData(const void* data)
+	{
+		if (IsYUV(m_Format))
+		{
+			// Tightly packed planes, one after the other
+			uint32_t shift_w, shift_h;
+			Utils::ChromaSubsampling(m_Format, shift_w, shift_h);
+			const size_t sample_size = Utils::BytesPerSample(m_Format);
+			const size_t strides[3] = { m_Width * sample_size, (m_Width >> shift_w) * sample_size, (m_Width >> shift_w) * sample_size };
+			const uint8_t* luma = (const uint8_t*)data;
+			const uint8_t* u = luma + strides[0] * m_Height;
+			const uint8_t* v = u + strides[1] * (m_Height >> shift_h);
+			const void* planes[3] = { luma, u, v };
+			YUVColorimetry colorimetry;
+			colorimetry.BitDepth = (uint32_t)sample_size * 8;
+			SetPlanes(planes, strides, colorimetry);
+			return;
+		}
+
+		size_t upload_size = m_Width * m_Height * Utils::BytesPerPixel(m_Format);
+
+		EnsureStagingBuffer(upload_size);
+
+		// Upload to Buffer
+		{
+			memcpy(m_StagingBufferMemory.Mapped, data, upload_size);
+			MemoryAllocator::Flush(m_StagingBufferMemory);
 		}
 
 
@@ -261,4 +689,176 @@ namespace Walnut {
 		}
 	}
 
+	void Image::SetPlanes(const void* const planes[3], const size_t strides[3], const YUVColorimetry& colorimetry)
+	{
+		// Each plane is uploaded with its stride intact rather than repacked, copy offsets must stay texel aligned
+		const size_t sample_size = Utils::BytesPerSample(m_Format);
+		size_t offsets[3];
+		size_t upload_size = 0;
+		for (int i = 0; i < 3; i++)
+		{
+			offsets[i] = upload_size;
+			upload_size += (strides[i] * m_Planes[i].Height + 15) & ~(size_t)15;
+		}
+
+		EnsureStagingBuffer(upload_size);
+
+		// Upload to Buffer
+		{
+			char* map = (char*)m_StagingBufferMemory.Mapped;
+			for (int i = 0; i < 3; i++)
+				memcpy(map + offsets[i], planes[i], strides[i] * m_Planes[i].Height);
+			MemoryAllocator::Flush(m_StagingBufferMemory);
+		}
+
+		VkCommandBuffer command_buffer = Application::GetCommandBuffer(true);
+
+		// Copy to Plane Images
+		{
+			VkImageMemoryBarrier copy_barriers[3] = {};
+			VkImageMemoryBarrier use_barriers[3] = {};
+			for (int i = 0; i < 3; i++)
+			{
+				copy_barriers[i].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+				copy_barriers[i].dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+				copy_barriers[i].oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+				copy_barriers[i].newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+				copy_barriers[i].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+				copy_barriers[i].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+				copy_barriers[i].image = m_Planes[i].Image;
+				copy_barriers[i].subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+				copy_barriers[i].subresourceRange.levelCount = 1;
+				copy_barriers[i].subresourceRange.layerCount = 1;
+
+				use_barriers[i] = copy_barriers[i];
+				use_barriers[i].srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+				use_barriers[i].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+				use_barriers[i].oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+				use_barriers[i].newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+			}
+			vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_HOST_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, NULL, 0, NULL, 3, copy_barriers);
+
+			for (int i = 0; i < 3; i++)
+			{
+				VkBufferImageCopy region = {};
+				region.bufferOffset = offsets[i];
+				region.bufferRowLength = (uint32_t)(strides[i] / sample_size);
+				region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+				region.imageSubresource.layerCount = 1;
+				region.imageExtent.width = m_Planes[i].Width;
+				region.imageExtent.height = m_Planes[i].Height;
+				region.imageExtent.depth = 1;
+				vkCmdCopyBufferToImage(command_buffer, m_StagingBuffer, m_Planes[i].Image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+			}
+
+			vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, NULL, 0, NULL, 3, use_barriers);
+		}
+
+		// Convert to RGBA
+		{
+			VkRenderPassBeginInfo info = {};
+			info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+			info.renderPass = YUV::s_RenderPass;
+			info.framebuffer = m_Framebuffer;
+			info.renderArea.extent.width = m_Width;
+			info.renderArea.extent.height = m_Height;
+			vkCmdBeginRenderPass(command_buffer, &info, VK_SUBPASS_CONTENTS_INLINE);
+
+			vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, YUV::s_Pipeline);
+			vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, YUV::s_PipelineLayout, 0, 1, &m_PlaneDescriptorSet, 0, NULL);
+
+			VkViewport viewport = {};
+			viewport.width = (float)m_Width;
+			viewport.height = (float)m_Height;
+			viewport.maxDepth = 1.0f;
+			vkCmdSetViewport(command_buffer, 0, 1, &viewport);
+			vkCmdSetScissor(command_buffer, 0, 1, &info.renderArea);
+
+			YUV::PushConstants constants = YUV::MakePushConstants(colorimetry, m_Format);
+			vkCmdPushConstants(command_buffer, YUV::s_PipelineLayout, VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(constants), &constants);
+			vkCmdDraw(command_buffer, 3, 1, 0, 0);
+
+			vkCmdEndRenderPass(command_buffer);
+		}
+
+		Application::FlushCommandBuffer(command_buffer);
+	}
+
+	void Image::ReadPixels(void* data) const
+	{
+		VkDevice device = Application::GetDevice();
+
+		VkResult err;
+
+		const size_t read_size = m_Width * m_Height * Utils::BytesPerPixel(m_Format);
+
+		// Create the Read Back Buffer, only for this read so it doesn't count towards the image's memory
+		VkBuffer buffer;
+		MemoryAllocation memory;
+		{
+			VkBufferCreateInfo buffer_info = {};
+			buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+			buffer_info.size = read_size;
+			buffer_info.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+			buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+			err = vkCreateBuffer(device, &buffer_info, nullptr, &buffer);
+			check_vk_result(err);
+			VkMemoryRequirements req;
+			vkGetBufferMemoryRequirements(device, buffer, &req);
+			memory = MemoryAllocator::Allocate(req, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, true);
+			err = vkBindBufferMemory(device, buffer, memory.Memory, memory.Offset);
+			check_vk_result(err);
+		}
+
+		// Copy to Buffer, images are always left ready to sample
+		{
+			VkCommandBuffer command_buffer = Application::GetCommandBuffer(true);
+
+			VkImageMemoryBarrier copy_barrier = {};
+			copy_barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+			copy_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+			copy_barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+			copy_barrier.oldLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+			copy_barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+			copy_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			copy_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			copy_barrier.image = m_Image;
+			copy_barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			copy_barrier.subresourceRange.levelCount = 1;
+			copy_barrier.subresourceRange.layerCount = 1;
+			vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, NULL, 0, NULL, 1, &copy_barrier);
+
+			VkBufferImageCopy region = {};
+			region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			region.imageSubresource.layerCount = 1;
+			region.imageExtent.width = m_Width;
+			region.imageExtent.height = m_Height;
+			region.imageExtent.depth = 1;
+			vkCmdCopyImageToBuffer(command_buffer, m_Image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, buffer, 1, &region);
+
+			VkImageMemoryBarrier use_barrier = copy_barrier;
+			use_barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+			use_barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+			use_barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+			use_barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+			VkBufferMemoryBarrier host_barrier = {};
+			host_barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+			host_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			host_barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+			host_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			host_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			host_barrier.buffer = buffer;
+			host_barrier.size = VK_WHOLE_SIZE;
+			vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_HOST_BIT, 0, 0, NULL, 1, &host_barrier, 1, &use_barrier);
+
+			Application::FlushCommandBuffer(command_buffer);
+		}
+
+		// Read from Buffer, the copy has finished so it can be freed straight away
+		MemoryAllocator::Invalidate(memory);
+		memcpy(data, memory.Mapped, read_size);
+		vkDestroyBuffer(device, buffer, nullptr);
+		MemoryAllocator::Free(memory);
+	}
+
 }
\ No newline at end of file
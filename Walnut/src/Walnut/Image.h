@@ -1,16 +1,49 @@
 #pragma once
 
+#include <array>
 #include <string>
 
 #include "vulkan/vulkan.h"
 
+#include "MemoryAllocator.h"
+
 namespace Walnut {
 
 	enum class ImageFormat
 	{
 		None = 0,
 		RGBA,
-		RGBA32F
+		RGBA32F,
+
+		// Planar YUV, uploaded as is and converted to RGBA on the GPU. The 16 bit formats hold 9 to 16 bit samples.
+		YUV420P8,
+		YUV422P8,
+		YUV444P8,
+		YUV420P16,
+		YUV422P16,
+		YUV444P16
+	};
+
+	enum class YUVMatrix
+	{
+		BT601 = 0,
+		BT709,
+		BT2020
+	};
+
+	// Memory held by every live Image, including those waiting on a resource free
+	struct ImageMemoryStats
+	{
+		uint64_t DeviceLocalBytes = 0;
+		uint64_t HostVisibleBytes = 0;
+		uint32_t ImageCount = 0;
+	};
+
+	struct YUVColorimetry
+	{
+		YUVMatrix Matrix = YUVMatrix::BT601;
+		bool FullRange = false;
+		uint32_t BitDepth = 8;
 	};
 
 	class Image
@@ -21,27 +54,57 @@ namespace Walnut {
 		~Image();
 
 		void SetData(const void* data);
+		// YUV formats only. Uploads each plane from rows of strides[i] bytes and converts them to RGBA.
+		void SetPlanes(const void* const planes[3], const size_t strides[3], const YUVColorimetry& colorimetry);
+		// Copies the image back from the GPU, RGBA for YUV formats. Waits for the GPU, so it's meant for checks rather
+		// than every frame.
+		void ReadPixels(void* data) const;
 
 		VkDescriptorSet GetDescriptorSet() const { return m_DescriptorSet; }
 
 		uint32_t GetWidth() const { return m_Width; }
 		uint32_t GetHeight() const { return m_Height; }
+
+		static bool IsYUV(ImageFormat format);
+		// Whether the device can sample the format's planes, RGB formats always are
+		static bool IsSupported(ImageFormat format);
+		// Destroys the conversion pipeline shared by YUV images, after every image has been freed
+		static void ReleaseSharedResources();
+		static ImageMemoryStats GetMemoryStats();
 	private:
 		void AllocateMemory(uint64_t size);
+		void AllocatePlanes();
+		void EnsureStagingBuffer(size_t size);
 	private:
 		uint32_t m_Width = 0, m_Height = 0;
 
 		VkImage m_Image = nullptr;
 		VkImageView m_ImageView = nullptr;
-		VkDeviceMemory m_Memory = nullptr;
+		MemoryAllocation m_Memory;
 		VkSampler m_Sampler = nullptr;
 
 		ImageFormat m_Format = ImageFormat::None;
 
 		VkBuffer m_StagingBuffer = nullptr;
-		VkDeviceMemory m_StagingBufferMemory = nullptr;
+		MemoryAllocation m_StagingBufferMemory;
 
 		size_t m_AlignedSize = 0;
+		size_t m_StagingSize = 0;
+		// Device local bytes allocated for the image and its planes
+		uint64_t m_DeviceBytes = 0;
+
+		// YUV formats render into m_Image from these planes
+		struct Plane
+		{
+			VkImage Image = nullptr;
+			VkImageView View = nullptr;
+			MemoryAllocation Memory;
+			uint32_t Width = 0, Height = 0;
+		};
+		std::array<Plane, 3> m_Planes;
+		VkFramebuffer m_Framebuffer = nullptr;
+		VkDescriptorPool m_PlaneDescriptorPool = nullptr;
+		VkDescriptorSet m_PlaneDescriptorSet = nullptr;
 
 		VkDescriptorSet m_DescriptorSet = nullptr;
 
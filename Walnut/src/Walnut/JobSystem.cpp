@@ -0,0 +1,374 @@
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Walnut {
+
+	namespace {
+
+		const int PRIORITY_COUNT = (int)JobPriority::Count;
+		const int BACKGROUND = (int)JobPriority::Background;
+
+		struct Task
+		{
+			std::function<void()> Function;
+			std::shared_ptr<std::atomic<bool>> Cancelled;
+		};
+
+		struct Worker
+		{
+			std::mutex Mutex;
+			std::deque<Task> Queues[PRIORITY_COUNT];
+			std::thread Thread;
+		};
+
+		std::mutex s_InitMutex;
+		std::atomic<bool> s_Running = false;
+		std::vector<std::unique_ptr<Worker>> s_Workers;
+		std::atomic<uint32_t> s_NextWorker = 0;
+		thread_local int t_WorkerIndex = -1;
+
+		// Workers sleep on this while there's nothing they're allowed to run
+		std::mutex s_SleepMutex;
+		std::condition_variable s_SleepCondition;
+		bool s_Stopping = false;
+
+		std::atomic<uint32_t> s_Queued[PRIORITY_COUNT] = {};
+		std::atomic<uint32_t> s_BackgroundLimit = 1;
+		std::atomic<uint32_t> s_BackgroundRunning = 0;
+		std::atomic<uint32_t> s_Busy = 0;
+		std::atomic<uint64_t> s_Completed = 0;
+		std::atomic<uint64_t> s_Stolen = 0;
+		std::atomic<uint64_t> s_BusyNanoseconds = 0;
+
+		std::mutex s_StatsMutex;
+		int64_t s_StatsTime = 0;
+		uint64_t s_StatsBusyNanoseconds = 0;
+
+		std::mutex s_MainThreadMutex;
+		std::vector<std::function<void()>> s_MainThreadTasks;
+
+		int64_t NowNanoseconds()
+		{
+			return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+		}
+
+		void EnsureStarted()
+		{
+			if (!s_Running)
+				JobSystem::Init();
+		}
+
+		bool HasRunnableTask()
+		{
+			for (int priority = 0; priority < BACKGROUND; priority++)
+			{
+				if (s_Queued[priority])
+					return true;
+			}
+			return s_Queued[BACKGROUND] && s_BackgroundRunning < s_BackgroundLimit;
+		}
+
+		// Wakes a sleeping worker. Taking the lock means a worker about to sleep either sees the new task or gets notified.
+		void WakeWorker(bool all)
+		{
+			{
+				std::lock_guard<std::mutex> lock(s_SleepMutex);
+			}
+			if (all)
+				s_SleepCondition.notify_all();
+			else
+				s_SleepCondition.notify_one();
+		}
+
+		bool PopFrom(Worker& worker, int priority, bool newest, Task& task)
+		{
+			std::lock_guard<std::mutex> lock(worker.Mutex);
+			std::deque<Task>& queue = worker.Queues[priority];
+			if (queue.empty())
+				return false;
+			if (newest)
+			{
+				task = std::move(queue.back());
+				queue.pop_back();
+			}
+			else
+			{
+				task = std::move(queue.front());
+				queue.pop_front();
+			}
+			s_Queued[priority]--;
+			return true;
+		}
+
+		// The most urgent task available to the worker (or an outside thread when self is -1), its own before stolen ones
+		bool TakeTask(int self, Task& task, int& priority)
+		{
+			const int count = (int)s_Workers.size();
+			for (priority = 0; priority < PRIORITY_COUNT; priority++)
+			{
+				if (!s_Queued[priority])
+					continue;
+
+				// Reserve a background slot before looking, so the limit holds however many workers look at once
+				if (priority == BACKGROUND)
+				{
+					uint32_t running = s_BackgroundRunning;
+					do
+					{
+						if (running >= s_BackgroundLimit)
+							return false;
+					} while (!s_BackgroundRunning.compare_exchange_weak(running, running + 1));
+				}
+
+				if (self >= 0 && PopFrom(*s_Workers[self], priority, true, task))
+					return true;
+				for (int i = 1; i <= count; i++)
+				{
+					const int victim = (std::max(self, 0) + i) % count;
+					if (victim != self && PopFrom(*s_Workers[victim], priority, false, task))
+					{
+						if (self >= 0)
+							s_Stolen++;
+						return true;
+					}
+				}
+
+				if (priority == BACKGROUND)
+					s_BackgroundRunning--;
+			}
+			return false;
+		}
+
+		void RunTask(Task& task, int priority)
+		{
+			const int64_t start = NowNanoseconds();
+			s_Busy++;
+			if (!task.Cancelled || !*task.Cancelled)
+				task.Function();
+			s_Busy--;
+			s_BusyNanoseconds += NowNanoseconds() - start;
+			s_Completed++;
+
+			// Freeing a background slot may let a sleeping worker take a queued background task
+			if (priority == BACKGROUND)
+			{
+				s_BackgroundRunning--;
+				if (s_Queued[BACKGROUND])
+					WakeWorker(false);
+			}
+		}
+
+		void WorkerLoop(int index)
+		{
+			t_WorkerIndex = index;
+			while (true)
+			{
+				Task task;
+				int priority;
+				if (TakeTask(index, task, priority))
+				{
+					RunTask(task, priority);
+					continue;
+				}
+
+				std::unique_lock<std::mutex> lock(s_SleepMutex);
+				s_SleepCondition.wait(lock, []() { return s_Stopping || HasRunnableTask(); });
+				// Queued tasks are dropped on shutdown, like the resources of a closing application
+				if (s_Stopping)
+					return;
+			}
+		}
+
+		void Push(JobPriority priority, Task&& task)
+		{
+			EnsureStarted();
+			const int index = t_WorkerIndex >= 0 ? t_WorkerIndex : (int)(s_NextWorker++ % s_Workers.size());
+			{
+				Worker& worker = *s_Workers[index];
+				std::lock_guard<std::mutex> lock(worker.Mutex);
+				worker.Queues[(int)priority].push_back(std::move(task));
+				s_Queued[(int)priority]++;
+			}
+			WakeWorker(false);
+		}
+
+	}
+
+	namespace {
+
+		// Joins the workers of a process which exits without calling Shutdown, as the command line does
+		struct ShutdownAtExit
+		{
+			~ShutdownAtExit() { JobSystem::Shutdown(); }
+		} s_ShutdownAtExit;
+
+	}
+
+	void JobSystem::Init(uint32_t workerCount)
+	{
+		std::lock_guard<std::mutex> lock(s_InitMutex);
+		if (s_Running)
+			return;
+
+		if (workerCount == 0)
+			workerCount = std::max(2u, std::thread::hardware_concurrency()) - 1;
+		s_BackgroundLimit = std::max(1u, workerCount / 2);
+		for (uint32_t i = 0; i < workerCount; i++)
+			s_Workers.push_back(std::make_unique<Worker>());
+		// Every worker exists before any of them starts stealing
+		for (uint32_t i = 0; i < workerCount; i++)
+			s_Workers[i]->Thread = std::thread(WorkerLoop, (int)i);
+		s_Running = true;
+	}
+
+	void JobSystem::Shutdown()
+	{
+		std::lock_guard<std::mutex> lock(s_InitMutex);
+		if (!s_Running)
+			return;
+
+		{
+			std::lock_guard<std::mutex> sleep_lock(s_SleepMutex);
+			s_Stopping = true;
+		}
+		s_SleepCondition.notify_all();
+		for (auto& worker : s_Workers)
+			worker->Thread.join();
+		s_Workers.clear();
+		for (auto& queued : s_Queued)
+			queued = 0;
+		s_BackgroundRunning = 0;
+		s_Stopping = false;
+		s_Running = false;
+
+		std::lock_guard<std::mutex> main_lock(s_MainThreadMutex);
+		s_MainThreadTasks.clear();
+	}
+
+	void JobSystem::Submit(JobPriority priority, std::function<void()>&& task)
+	{
+		Push(priority, { std::move(task), nullptr });
+	}
+
+	void JobSystem::Submit(JobPriority priority, std::function<void()>&& task, const CancellationToken& token)
+	{
+		Push(priority, { std::move(task), token.m_Cancelled });
+	}
+
+	void JobSystem::ParallelFor(JobPriority priority, int begin, int end, int chunkSize, const std::function<void(int, int)>& body)
+	{
+		chunkSize = std::max(1, chunkSize);
+		const int chunks = end > begin ? (end - begin + chunkSize - 1) / chunkSize : 0;
+		if (chunks == 0)
+			return;
+
+		struct State
+		{
+			std::function<void(int, int)> Body;
+			int Begin, End, ChunkSize, Chunks;
+			std::atomic<int> Next = 0;
+			std::atomic<int> Remaining = 0;
+			std::mutex Mutex;
+			std::condition_variable Done;
+		};
+		auto state = std::make_shared<State>();
+		state->Body = body;
+		state->Begin = begin;
+		state->End = end;
+		state->ChunkSize = chunkSize;
+		state->Chunks = chunks;
+		state->Remaining = chunks;
+
+		// Helpers which only start after every chunk is claimed find nothing to do, and never touch body
+		auto work = [](State& state)
+		{
+			for (int chunk = state.Next++; chunk < state.Chunks; chunk = state.Next++)
+			{
+				const int chunk_begin = state.Begin + chunk * state.ChunkSize;
+				state.Body(chunk_begin, std::min(state.End, chunk_begin + state.ChunkSize));
+				if (--state.Remaining == 0)
+				{
+					// Under the lock, so the caller can't miss it between checking and going to sleep
+					std::lock_guard<std::mutex> lock(state.Mutex);
+					state.Done.notify_all();
+				}
+			}
+		};
+		const int helpers = std::min(chunks - 1, (int)GetWorkerCount());
+		for (int i = 0; i < helpers; i++)
+			Submit(priority, [state, work]() { work(*state); });
+		work(*state);
+		// The remaining chunks are already running on workers, so sleep until the last one finishes
+		std::unique_lock<std::mutex> lock(state->Mutex);
+		state->Done.wait(lock, [&]() { return state->Remaining == 0; });
+	}
+
+	bool JobSystem::RunPendingTask()
+	{
+		EnsureStarted();
+		Task task;
+		int priority;
+		if (!TakeTask(t_WorkerIndex, task, priority))
+			return false;
+		RunTask(task, priority);
+		return true;
+	}
+
+	void JobSystem::PostToMainThread(std::function<void()>&& task)
+	{
+		std::lock_guard<std::mutex> lock(s_MainThreadMutex);
+		s_MainThreadTasks.push_back(std::move(task));
+	}
+
+	void JobSystem::RunMainThreadTasks()
+	{
+		std::vector<std::function<void()>> tasks;
+		{
+			std::lock_guard<std::mutex> lock(s_MainThreadMutex);
+			tasks.swap(s_MainThreadTasks);
+		}
+		for (auto& task : tasks)
+			task();
+	}
+
+	void JobSystem::SetBackgroundLimit(uint32_t limit)
+	{
+		s_BackgroundLimit = std::max(1u, limit);
+		WakeWorker(true);
+	}
+
+	uint32_t JobSystem::GetWorkerCount()
+	{
+		EnsureStarted();
+		return (uint32_t)s_Workers.size();
+	}
+
+	JobSystemStats JobSystem::GetStats()
+	{
+		JobSystemStats stats;
+		stats.WorkerCount = s_Running ? (uint32_t)s_Workers.size() : 0;
+		stats.BackgroundLimit = s_BackgroundLimit;
+		stats.BusyWorkers = s_Busy;
+		for (int priority = 0; priority < PRIORITY_COUNT; priority++)
+			stats.Queued[priority] = s_Queued[priority];
+		stats.Completed = s_Completed;
+		stats.Stolen = s_Stolen;
+
+		std::lock_guard<std::mutex> lock(s_StatsMutex);
+		const int64_t now = NowNanoseconds();
+		const uint64_t busy = s_BusyNanoseconds;
+		if (s_StatsTime && now > s_StatsTime && stats.WorkerCount)
+			stats.Utilisation = std::min(1.0f, (float)(busy - s_StatsBusyNanoseconds) / ((float)(now - s_StatsTime) * stats.WorkerCount));
+		s_StatsTime = now;
+		s_StatsBusyNanoseconds = busy;
+		return stats;
+	}
+
+}
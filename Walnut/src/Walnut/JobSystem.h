@@ -0,0 +1,74 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+namespace Walnut {
+
+	// Workers always take the most urgent task they can find, their own or stolen
+	enum class JobPriority
+	{
+		Interactive = 0, // Something the UI is waiting on
+		Prefetch,        // Likely to be needed soon
+		Background,      // Whole clip analysis and the like, limited by SetBackgroundLimit
+		Count
+	};
+
+	// Shared by the tasks of a job and whoever started it. Tasks which haven't started when it's cancelled are skipped,
+	// running ones are expected to check IsCancelled.
+	class CancellationToken
+	{
+	public:
+		void Cancel() { *m_Cancelled = true; }
+		bool IsCancelled() const { return *m_Cancelled; }
+	private:
+		friend class JobSystem;
+		std::shared_ptr<std::atomic<bool>> m_Cancelled = std::make_shared<std::atomic<bool>>(false);
+	};
+
+	struct JobSystemStats
+	{
+		uint32_t WorkerCount = 0;
+		uint32_t BackgroundLimit = 0;
+		uint32_t BusyWorkers = 0;
+		uint32_t Queued[(int)JobPriority::Count] = {};
+		uint64_t Completed = 0;
+		uint64_t Stolen = 0;
+		// Fraction of worker time spent running tasks since the previous GetStats call
+		float Utilisation = 0.0f;
+	};
+
+	// Work stealing pool shared by everything that runs off the UI thread. Each worker has a queue per priority which it
+	// works through newest first, and idle workers steal the oldest task from another worker's queue. Tasks submitted
+	// from outside the pool are spread across the workers. Started on first use, with one worker fewer than the hardware
+	// has threads to leave room for the UI thread.
+	class JobSystem
+	{
+	public:
+		static void Init(uint32_t workerCount = 0);
+		// Drops queued tasks and joins the workers
+		static void Shutdown();
+
+		static void Submit(JobPriority priority, std::function<void()>&& task);
+		static void Submit(JobPriority priority, std::function<void()>&& task, const CancellationToken& token);
+		// Calls body(chunkBegin, chunkEnd) for chunks of [begin, end) and returns once they're all done. The calling
+		// thread works through chunks too, and never runs unrelated tasks while it waits; once every chunk is claimed it sleeps
+		// until the last one finishes.
+		static void ParallelFor(JobPriority priority, int begin, int end, int chunkSize, const std::function<void(int, int)>& body);
+		// Runs one queued task on the calling thread if there is one, for waiting on tasks without idling
+		static bool RunPendingTask();
+
+		// Runs on the UI thread at the start of the next frame
+		static void PostToMainThread(std::function<void()>&& task);
+		static void RunMainThreadTasks();
+
+		// Most workers running background tasks at once, so they leave room for interactive work and don't compete with
+		// other thread pools (VapourSynth's) for the cores
+		static void SetBackgroundLimit(uint32_t limit);
+		static uint32_t GetWorkerCount();
+		static JobSystemStats GetStats();
+	};
+
+}
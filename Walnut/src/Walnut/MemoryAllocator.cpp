@@ -0,0 +1,268 @@
+#include "MemoryAllocator.h"
+
+#include "Application.h"
+
+#include <algorithm>
+#include <cassert>
+#include <mutex>
+#include <vector>
+
+namespace Walnut {
+
+	namespace {
+
+		struct FreeRange
+		{
+			VkDeviceSize Offset;
+			VkDeviceSize Size;
+		};
+
+		struct Block
+		{
+			VkDeviceMemory Memory = nullptr;
+			VkDeviceSize Size = 0;
+			void* Mapped = nullptr;
+			// Sorted by offset, adjacent ranges are always merged
+			std::vector<FreeRange> FreeRanges;
+		};
+
+		struct Pool
+		{
+			uint32_t MemoryType = 0;
+			bool Linear = false;
+			bool HostVisible = false;
+			bool Coherent = false;
+			std::vector<Block> Blocks;
+		};
+
+		std::mutex s_Mutex;
+		std::vector<Pool> s_Pools;
+		VkDeviceSize s_NonCoherentAtomSize = 0;
+		uint32_t s_AllocationCount = 0;
+		VkDeviceSize s_AllocatedBytes = 0;
+
+		VkDeviceSize AlignUp(VkDeviceSize value, VkDeviceSize alignment)
+		{
+			return (value + alignment - 1) / alignment * alignment;
+		}
+
+		uint32_t FindMemoryType(VkMemoryPropertyFlags properties, uint32_t type_bits, VkMemoryPropertyFlags& type_properties)
+		{
+			VkPhysicalDeviceMemoryProperties prop;
+			vkGetPhysicalDeviceMemoryProperties(Application::GetPhysicalDevice(), &prop);
+			for (uint32_t i = 0; i < prop.memoryTypeCount; i++)
+			{
+				if ((prop.memoryTypes[i].propertyFlags & properties) == properties && type_bits & (1 << i))
+				{
+					type_properties = prop.memoryTypes[i].propertyFlags;
+					return i;
+				}
+			}
+
+			return 0xffffffff;
+		}
+
+		// Takes size bytes aligned to alignment from the block's free ranges, or returns false if none is big enough
+		bool Carve(Block& block, VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offset)
+		{
+			for (size_t i = 0; i < block.FreeRanges.size(); i++)
+			{
+				const FreeRange range = block.FreeRanges[i];
+				const VkDeviceSize aligned = AlignUp(range.Offset, alignment);
+				if (aligned + size > range.Offset + range.Size)
+					continue;
+
+				// Whatever is left either side of the allocation stays free
+				std::vector<FreeRange> remaining;
+				if (aligned > range.Offset)
+					remaining.push_back({ range.Offset, aligned - range.Offset });
+				if (aligned + size < range.Offset + range.Size)
+					remaining.push_back({ aligned + size, range.Offset + range.Size - aligned - size });
+				block.FreeRanges.erase(block.FreeRanges.begin() + i);
+				block.FreeRanges.insert(block.FreeRanges.begin() + i, remaining.begin(), remaining.end());
+				offset = aligned;
+				return true;
+			}
+			return false;
+		}
+
+	}
+
+	MemoryAllocation MemoryAllocator::Allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, bool linear)
+	{
+		VkDevice device = Application::GetDevice();
+
+		std::lock_guard<std::mutex> lock(s_Mutex);
+
+		VkMemoryPropertyFlags type_properties = 0;
+		const uint32_t memory_type = FindMemoryType(properties, requirements.memoryTypeBits, type_properties);
+		if (memory_type == 0xffffffff)
+			check_vk_result(VK_ERROR_OUT_OF_DEVICE_MEMORY);
+
+		uint32_t pool_index = 0;
+		while (pool_index < s_Pools.size() && (s_Pools[pool_index].MemoryType != memory_type || s_Pools[pool_index].Linear != linear))
+			pool_index++;
+		if (pool_index == s_Pools.size())
+		{
+			Pool& pool = s_Pools.emplace_back();
+			pool.MemoryType = memory_type;
+			pool.Linear = linear;
+			pool.HostVisible = (type_properties & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) != 0;
+			pool.Coherent = (type_properties & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0;
+		}
+		Pool& pool = s_Pools[pool_index];
+
+		// Flushed ranges must start and end on atom boundaries, which no neighbouring allocation may share
+		VkDeviceSize size = requirements.size;
+		VkDeviceSize alignment = requirements.alignment;
+		if (pool.HostVisible && !pool.Coherent)
+		{
+			if (!s_NonCoherentAtomSize)
+			{
+				VkPhysicalDeviceProperties device_properties;
+				vkGetPhysicalDeviceProperties(Application::GetPhysicalDevice(), &device_properties);
+				s_NonCoherentAtomSize = device_properties.limits.nonCoherentAtomSize;
+			}
+			alignment = std::max(alignment, s_NonCoherentAtomSize);
+			size = AlignUp(size, s_NonCoherentAtomSize);
+		}
+
+		MemoryAllocation allocation;
+		allocation.Size = size;
+		allocation.Pool = pool_index;
+
+		uint32_t block_index = 0;
+		while (block_index < pool.Blocks.size() && !Carve(pool.Blocks[block_index], size, alignment, allocation.Offset))
+			block_index++;
+		if (block_index == pool.Blocks.size())
+		{
+			Block& block = pool.Blocks.emplace_back();
+			block.Size = AlignUp(size, BLOCK_SIZE);
+
+			VkMemoryAllocateInfo alloc_info = {};
+			alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+			alloc_info.allocationSize = block.Size;
+			alloc_info.memoryTypeIndex = memory_type;
+			VkResult err = vkAllocateMemory(device, &alloc_info, nullptr, &block.Memory);
+			check_vk_result(err);
+			if (pool.HostVisible)
+			{
+				err = vkMapMemory(device, block.Memory, 0, VK_WHOLE_SIZE, 0, &block.Mapped);
+				check_vk_result(err);
+			}
+			block.FreeRanges.push_back({ 0, block.Size });
+			Carve(block, size, alignment, allocation.Offset);
+		}
+
+		const Block& block = pool.Blocks[block_index];
+		allocation.Memory = block.Memory;
+		allocation.Block = block_index;
+		if (block.Mapped)
+			allocation.Mapped = (char*)block.Mapped + allocation.Offset;
+
+		s_AllocationCount++;
+		s_AllocatedBytes += size;
+		return allocation;
+	}
+
+	void MemoryAllocator::Free(const MemoryAllocation& allocation)
+	{
+		if (!allocation.Memory)
+			return;
+
+		std::lock_guard<std::mutex> lock(s_Mutex);
+		// Anything freed after Shutdown outlived the pools it came from
+		assert(allocation.Pool < s_Pools.size() && allocation.Block < s_Pools[allocation.Pool].Blocks.size());
+
+		std::vector<FreeRange>& ranges = s_Pools[allocation.Pool].Blocks[allocation.Block].FreeRanges;
+		size_t i = 0;
+		while (i < ranges.size() && ranges[i].Offset < allocation.Offset)
+			i++;
+		ranges.insert(ranges.begin() + i, { allocation.Offset, allocation.Size });
+
+		// Merge with the following range, then the preceding one
+		if (i + 1 < ranges.size() && ranges[i].Offset + ranges[i].Size == ranges[i + 1].Offset)
+		{
+			ranges[i].Size += ranges[i + 1].Size;
+			ranges.erase(ranges.begin() + i + 1);
+		}
+		if (i > 0 && ranges[i - 1].Offset + ranges[i - 1].Size == ranges[i].Offset)
+		{
+			ranges[i - 1].Size += ranges[i].Size;
+			ranges.erase(ranges.begin() + i);
+		}
+
+		s_AllocationCount--;
+		s_AllocatedBytes -= allocation.Size;
+	}
+
+	void MemoryAllocator::Flush(const MemoryAllocation& allocation)
+	{
+		{
+			std::lock_guard<std::mutex> lock(s_Mutex);
+			if (s_Pools[allocation.Pool].Coherent)
+				return;
+		}
+
+		VkMappedMemoryRange range[1] = {};
+		range[0].sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+		range[0].memory = allocation.Memory;
+		range[0].offset = allocation.Offset;
+		range[0].size = allocation.Size;
+		VkResult err = vkFlushMappedMemoryRanges(Application::GetDevice(), 1, range);
+		check_vk_result(err);
+	}
+
+	void MemoryAllocator::Invalidate(const MemoryAllocation& allocation)
+	{
+		{
+			std::lock_guard<std::mutex> lock(s_Mutex);
+			if (s_Pools[allocation.Pool].Coherent)
+				return;
+		}
+
+		VkMappedMemoryRange range[1] = {};
+		range[0].sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+		range[0].memory = allocation.Memory;
+		range[0].offset = allocation.Offset;
+		range[0].size = allocation.Size;
+		VkResult err = vkInvalidateMappedMemoryRanges(Application::GetDevice(), 1, range);
+		check_vk_result(err);
+	}
+
+	MemoryAllocatorStats MemoryAllocator::GetStats()
+	{
+		std::lock_guard<std::mutex> lock(s_Mutex);
+
+		MemoryAllocatorStats stats;
+		for (const Pool& pool : s_Pools)
+		{
+			for (const Block& block : pool.Blocks)
+			{
+				stats.BlockCount++;
+				stats.BlockBytes += block.Size;
+			}
+		}
+		stats.AllocationCount = s_AllocationCount;
+		stats.AllocatedBytes = s_AllocatedBytes;
+		return stats;
+	}
+
+	void MemoryAllocator::Shutdown()
+	{
+		VkDevice device = Application::GetDevice();
+
+		std::lock_guard<std::mutex> lock(s_Mutex);
+		for (const Pool& pool : s_Pools)
+		{
+			for (const Block& block : pool.Blocks)
+			{
+				if (block.Mapped)
+					vkUnmapMemory(device, block.Memory);
+				vkFreeMemory(device, block.Memory, nullptr);
+			}
+		}
+		s_Pools.clear();
+	}
+
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "vulkan/vulkan.h"
+
+namespace Walnut {
+
+	// A range of one of MemoryAllocator's blocks
+	struct MemoryAllocation
+	{
+		VkDeviceMemory Memory = nullptr;
+		VkDeviceSize Offset = 0;
+		VkDeviceSize Size = 0;
+		// Host visible allocations stay mapped for as long as their block exists
+		void* Mapped = nullptr;
+		uint32_t Pool = 0;
+		uint32_t Block = 0;
+	};
+
+	struct MemoryAllocatorStats
+	{
+		// Live vkAllocateMemory allocations and their total size
+		uint32_t BlockCount = 0;
+		VkDeviceSize BlockBytes = 0;
+		uint32_t AllocationCount = 0;
+		VkDeviceSize AllocatedBytes = 0;
+	};
+
+	// Sub-allocates memory for images and buffers out of large blocks, so the number of live vkAllocateMemory
+	// allocations follows peak usage rather than how many images have come and gone. Blocks are BLOCK_SIZE unless a
+	// single allocation needs more, and are kept until Shutdown once allocated. Each memory type has separate blocks for
+	// linear (buffer) and optimal (image) resources, so bufferImageGranularity never applies.
+	class MemoryAllocator
+	{
+	public:
+		static constexpr VkDeviceSize BLOCK_SIZE = 64 * 1024 * 1024;
+
+		static MemoryAllocation Allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, bool linear);
+		// Returns the range to its block straight away, defer it with Application::SubmitResourceFree while the GPU may still use it
+		static void Free(const MemoryAllocation& allocation);
+		// Makes host writes through Mapped visible to the device, when the memory isn't coherent
+		static void Flush(const MemoryAllocation& allocation);
+		// Makes device writes visible to host reads through Mapped, when the memory isn't coherent
+		static void Invalidate(const MemoryAllocation& allocation);
+
+		static MemoryAllocatorStats GetStats();
+		// Frees every block, after everything allocated from them has been freed
+		static void Shutdown();
+	};
+
+}
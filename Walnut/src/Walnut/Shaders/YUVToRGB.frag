@@ -0,0 +1,23 @@
+#version 450
+
+layout(location = 0) in vec2 inUV;
+layout(location = 0) out vec4 outColor;
+
+// Y, U and V, chroma planes are sampled with the same UVs so subsampled planes are interpolated up to full size
+layout(set = 0, binding = 0) uniform sampler2D planes[3];
+
+layout(push_constant) uniform Constants
+{
+	// R, G and B as weights of Y, U and V
+	vec4 rows[3];
+	// Scale and offset taking Y then U and V from normalized samples to 0..1 and -0.5..0.5
+	vec4 range;
+} constants;
+
+void main()
+{
+	vec3 yuv = vec3(texture(planes[0], inUV).r, texture(planes[1], inUV).r, texture(planes[2], inUV).r);
+	yuv = yuv * constants.range.xzz + constants.range.ywww;
+	vec3 rgb = vec3(dot(constants.rows[0].xyz, yuv), dot(constants.rows[1].xyz, yuv), dot(constants.rows[2].xyz, yuv));
+	outColor = vec4(clamp(rgb, 0.0, 1.0), 1.0);
+}
@@ -0,0 +1,10 @@
+#version 450
+
+// A single triangle covering the whole target, with UVs running 0 to 1 across the visible part
+layout(location = 0) out vec2 outUV;
+
+void main()
+{
+	outUV = vec2((gl_VertexIndex << 1) & 2, gl_VertexIndex & 2);
+	gl_Position = vec4(outUV * 2.0 - 1.0, 0.0, 1.0);
+}
@@ -0,0 +1,65 @@
+#include "ActionScan.h"
+
+#include <algorithm>
+
+static const int ACTION_DROP = 8;
+static const int ACTION_COMPLETE_PREVIOUS_CYCLE = 9;
+
+// Output frames 0-3 of a cycle have their top and bottom fields at actions 0-7
+static const int CYCLE_OUTPUT_FIELDS = 8;
+
+static bool IsValidAction(const int action, const int field) {
+	if (action >= 0 && action < ACTION_DROP) {
+		// Both fields of an output frame must have opposite parity
+		return action % 2 == field % 2;
+	}
+	if (action == ACTION_COMPLETE_PREVIOUS_CYCLE) {
+		// Only the first field after a cycle can complete it
+		return field % 10 == 0 && field > 0;
+	}
+	return action == ACTION_DROP;
+}
+
+CycleFindings ScanCycles(const std::vector<int>& actions, const int firstCycle, const int endCycle) {
+	CycleFindings findings;
+	const int fieldCount = (int)actions.size();
+	for (int cycle = firstCycle; cycle < endCycle; cycle++) {
+		const int first = cycle * 10;
+		const int last = std::min(first + 10, fieldCount);
+		// The field assigned to each output field of the cycle, -1 where there's none
+		int slots[CYCLE_OUTPUT_FIELDS];
+		std::fill(std::begin(slots), std::end(slots), -1);
+		auto assign = [&](const int slot, const int field) {
+			if (slots[slot] >= 0) {
+				findings.duplicateFields.Add(field);
+			} else {
+				slots[slot] = field;
+			}
+		};
+		for (int field = first; field < last; field++) {
+			const int action = actions[field];
+			if (!IsValidAction(action, field)) {
+				findings.invalidActions.Add(field);
+			} else if (action < ACTION_DROP) {
+				assign(action, field);
+			}
+		}
+		// The next cycle's first field is the top of this cycle's last frame
+		if (last < fieldCount && actions[last] == ACTION_COMPLETE_PREVIOUS_CYCLE) {
+			assign(6, last);
+		}
+
+		const int frames = (last - first) * 4 / 10;
+		for (int frame = 0; frame < frames; frame++) {
+			const int top = slots[frame * 2];
+			const int bottom = slots[frame * 2 + 1];
+			if (top < 0 && bottom < 0) {
+				findings.freezeFrames.Add(cycle * 4 + frame);
+			} else if (top < 0 || bottom < 0) {
+				findings.singleFieldFrames.Add(cycle * 4 + frame);
+				findings.orphanedFields.Add(top < 0 ? bottom : top);
+			}
+		}
+	}
+	return findings;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "json.hpp"
+
+#include <cstdint>
+#include <vector>
+
+// Indices of one kind of problem, the count is always exact but only the first few are listed
+struct Findings {
+	static const size_t MAX_EXAMPLES = 10;
+
+	int64_t count = 0;
+	std::vector<int> examples;
+
+	void Add(const int index) {
+		count++;
+		if (examples.size() < MAX_EXAMPLES) {
+			examples.push_back(index);
+		}
+	}
+
+	void Merge(const Findings& other) {
+		count += other.count;
+		for (size_t i = 0; i < other.examples.size() && examples.size() < MAX_EXAMPLES; i++) {
+			examples.push_back(other.examples[i]);
+		}
+	}
+
+	nlohmann::ordered_json ToJson() const {
+		return nlohmann::ordered_json{ {"count", count}, {"first", examples} };
+	}
+};
+
+struct CycleFindings {
+	// Fields with an action out of range, or assigned to an output field of the other parity
+	Findings invalidActions;
+	// Fields assigned to an output field another field of the cycle already fills
+	Findings duplicateFields;
+	// Fields kept in an output frame whose opposite parity field is missing, so they're shown line doubled
+	Findings orphanedFields;
+	// Output frames with no fields, and with one
+	Findings freezeFrames;
+	Findings singleFieldFrames;
+
+	void Merge(const CycleFindings& other) {
+		invalidActions.Merge(other.invalidActions);
+		duplicateFields.Merge(other.duplicateFields);
+		orphanedFields.Merge(other.orphanedFields);
+		freezeFrames.Merge(other.freezeFrames);
+		singleFieldFrames.Merge(other.singleFieldFrames);
+	}
+};
+
+// Checks the actions of cycles [firstCycle, endCycle) on their own, so ranges of cycles can be scanned in parallel and
+// merged. actions holds -1 where the project doesn't hold an integer.
+CycleFindings ScanCycles(const std::vector<int>& actions, int firstCycle, int endCycle);
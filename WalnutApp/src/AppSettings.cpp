@@ -0,0 +1,30 @@
+#include "AppSettings.h"
+
+#include <cstdio>
+#include <fstream>
+
+using json = nlohmann::json;
+
+static const char* SETTINGS_FILE = "IVTCDN.json";
+
+json ReadAppSettings() {
+	std::ifstream input(SETTINGS_FILE);
+	if (!input) {
+		return json::object();
+	}
+	json settings = json::parse(input, nullptr, false);
+	if (!settings.is_object()) {
+		fprintf(stderr, "Ignoring malformed %s\n", SETTINGS_FILE);
+		return json::object();
+	}
+	return settings;
+}
+
+void WriteAppSettings(const json& settings) {
+	std::ofstream output(SETTINGS_FILE);
+	if (!output) {
+		fprintf(stderr, "Failed to write %s\n", SETTINGS_FILE);
+		return;
+	}
+	output << settings.dump(4);
+}
@@ -0,0 +1,8 @@
+#pragma once
+
+#include "json.hpp"
+
+// Preferences shared by every project, kept in IVTCDN.json alongside imgui.ini. Missing or unreadable settings read
+// as an empty object so every attribute falls back to its default.
+nlohmann::json ReadAppSettings();
+void WriteAppSettings(const nlohmann::json& settings);
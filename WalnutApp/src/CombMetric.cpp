@@ -0,0 +1,135 @@
+#include "CombMetric.h"
+#include "Simd.h"
+
+#include <algorithm>
+#include <bit>
+#include <vector>
+
+namespace {
+
+// Each row function adds the number of combed pixels in [0, width) to blockCounts[x / COMB_BLOCK_SIZE]
+
+template <typename T>
+void CombRowScalar(const T* cur, const T* above, const T* below, int start, int width, int threshold, uint16_t* blockCounts) {
+	for (int x = start; x < width; x++) {
+		const int d1 = cur[x] - above[x];
+		const int d2 = cur[x] - below[x];
+		if ((d1 > threshold && d2 > threshold) || (d1 < -threshold && d2 < -threshold)) {
+			blockCounts[x / COMB_BLOCK_SIZE]++;
+		}
+	}
+}
+
+void CombRowSSE2(const uint8_t* cur, const uint8_t* above, const uint8_t* below, int width, int threshold, uint16_t* blockCounts) {
+	const __m128i thresholdV = _mm_set1_epi8((char)threshold);
+	const __m128i zero = _mm_setzero_si128();
+	const int vectorWidth = width & ~15;
+	for (int x = 0; x < vectorWidth; x += 16) {
+		const __m128i c = _mm_loadu_si128((const __m128i*)(cur + x));
+		const __m128i a = _mm_loadu_si128((const __m128i*)(above + x));
+		const __m128i b = _mm_loadu_si128((const __m128i*)(below + x));
+		// min(c - a, c - b) > t  <=>  both differences exceed the threshold (saturating, so negative differences are 0)
+		const __m128i brighter = _mm_subs_epu8(_mm_min_epu8(_mm_subs_epu8(c, a), _mm_subs_epu8(c, b)), thresholdV);
+		const __m128i darker = _mm_subs_epu8(_mm_min_epu8(_mm_subs_epu8(a, c), _mm_subs_epu8(b, c)), thresholdV);
+		const unsigned clean = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_or_si128(brighter, darker), zero));
+		blockCounts[x / COMB_BLOCK_SIZE] += (uint16_t)(16 - std::popcount(clean));
+	}
+	CombRowScalar(cur, above, below, vectorWidth, width, threshold, blockCounts);
+}
+
+IVTCDN_TARGET_AVX2
+void CombRowAVX2(const uint8_t* cur, const uint8_t* above, const uint8_t* below, int width, int threshold, uint16_t* blockCounts) {
+	const __m256i thresholdV = _mm256_set1_epi8((char)threshold);
+	const __m256i zero = _mm256_setzero_si256();
+	const int vectorWidth = width & ~31;
+	for (int x = 0; x < vectorWidth; x += 32) {
+		const __m256i c = _mm256_loadu_si256((const __m256i*)(cur + x));
+		const __m256i a = _mm256_loadu_si256((const __m256i*)(above + x));
+		const __m256i b = _mm256_loadu_si256((const __m256i*)(below + x));
+		const __m256i brighter = _mm256_subs_epu8(_mm256_min_epu8(_mm256_subs_epu8(c, a), _mm256_subs_epu8(c, b)), thresholdV);
+		const __m256i darker = _mm256_subs_epu8(_mm256_min_epu8(_mm256_subs_epu8(a, c), _mm256_subs_epu8(b, c)), thresholdV);
+		const uint32_t clean = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_or_si256(brighter, darker), zero));
+		// 32 pixels span exactly two blocks
+		blockCounts[x / COMB_BLOCK_SIZE] += (uint16_t)(16 - _mm_popcnt_u32(clean & 0xFFFF));
+		blockCounts[x / COMB_BLOCK_SIZE + 1] += (uint16_t)(16 - _mm_popcnt_u32(clean >> 16));
+	}
+	CombRowSSE2(cur + vectorWidth, above + vectorWidth, below + vectorWidth, width - vectorWidth, threshold, blockCounts + vectorWidth / COMB_BLOCK_SIZE);
+}
+
+void CombRowSSE2(const uint16_t* cur, const uint16_t* above, const uint16_t* below, int width, int threshold, uint16_t* blockCounts) {
+	const __m128i thresholdV = _mm_set1_epi16((short)threshold);
+	const __m128i zero = _mm_setzero_si128();
+	// All ones in lanes where the saturated difference does not exceed the threshold
+	auto notAbove = [&](__m128i x, __m128i y) {
+		return _mm_cmpeq_epi16(_mm_subs_epu16(_mm_subs_epu16(x, y), thresholdV), zero);
+	};
+	const int vectorWidth = width & ~15;
+	for (int x = 0; x < vectorWidth; x += 16) {
+		__m128i clean[2];
+		for (int half = 0; half < 2; half++) {
+			const __m128i c = _mm_loadu_si128((const __m128i*)(cur + x + half * 8));
+			const __m128i a = _mm_loadu_si128((const __m128i*)(above + x + half * 8));
+			const __m128i b = _mm_loadu_si128((const __m128i*)(below + x + half * 8));
+			const __m128i notBrighter = _mm_or_si128(notAbove(c, a), notAbove(c, b));
+			const __m128i notDarker = _mm_or_si128(notAbove(a, c), notAbove(b, c));
+			clean[half] = _mm_and_si128(notBrighter, notDarker);
+		}
+		const unsigned mask = _mm_movemask_epi8(_mm_packs_epi16(clean[0], clean[1]));
+		blockCounts[x / COMB_BLOCK_SIZE] += (uint16_t)(16 - std::popcount(mask));
+	}
+	CombRowScalar(cur, above, below, vectorWidth, width, threshold, blockCounts);
+}
+
+template <typename T>
+int CombMetricImpl(const FieldPlane& top, const FieldPlane& bottom, int threshold, Simd::Level level) {
+	const int width = top.width;
+	const int frameHeight = top.height + bottom.height;
+	const int blocksPerRow = (width + COMB_BLOCK_SIZE - 1) / COMB_BLOCK_SIZE;
+	std::vector<uint16_t> blockCounts(blocksPerRow);
+
+	auto row = [&](int y) -> const T* {
+		const FieldPlane& field = (y % 2 == 0) ? top : bottom;
+		return (const T*)(field.data + (y / 2) * field.stride);
+	};
+
+	int metric = 0;
+	for (int blockY = 0; blockY < frameHeight; blockY += COMB_BLOCK_SIZE) {
+		std::fill(blockCounts.begin(), blockCounts.end(), 0);
+		const int endY = std::min(blockY + COMB_BLOCK_SIZE, frameHeight - 1);
+		for (int y = std::max(blockY, 1); y < endY; y++) {
+			const T* cur = row(y);
+			const T* above = row(y - 1);
+			const T* below = row(y + 1);
+			if constexpr (sizeof(T) == 1) {
+				if (level == Simd::Level::AVX2) {
+					CombRowAVX2(cur, above, below, width, threshold, blockCounts.data());
+				} else if (level == Simd::Level::SSE2) {
+					CombRowSSE2(cur, above, below, width, threshold, blockCounts.data());
+				} else {
+					CombRowScalar(cur, above, below, 0, width, threshold, blockCounts.data());
+				}
+			} else {
+				if (level != Simd::Level::Scalar) {
+					CombRowSSE2(cur, above, below, width, threshold, blockCounts.data());
+				} else {
+					CombRowScalar(cur, above, below, 0, width, threshold, blockCounts.data());
+				}
+			}
+		}
+		metric = std::max(metric, (int)*std::max_element(blockCounts.begin(), blockCounts.end()));
+	}
+	return metric;
+}
+
+}
+
+int CombMetric(const FieldPlane& top, const FieldPlane& bottom, int pixelThreshold) {
+	if (!top.data || !bottom.data || top.width <= 0 || top.height <= 0 || top.width != bottom.width) {
+		return -1;
+	}
+	const Simd::Level level = Simd::ActiveLevel();
+	if (top.bitsPerSample <= 8) {
+		return CombMetricImpl<uint8_t>(top, bottom, pixelThreshold, level);
+	}
+	return CombMetricImpl<uint16_t>(top, bottom, pixelThreshold << (top.bitsPerSample - 8), level);
+}
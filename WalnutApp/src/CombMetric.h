@@ -0,0 +1,15 @@
+#pragma once
+
+#include "FieldPlane.h"
+
+// Block size of the comb metric in woven frame pixels, so the metric ranges from 0 to COMB_BLOCK_SIZE * COMB_BLOCK_SIZE
+static const int COMB_BLOCK_SIZE = 16;
+
+// Default difference threshold for a pixel to count as combed, in 8-bit units (same default as TFM's cthresh)
+static const int COMB_PIXEL_THRESHOLD = 9;
+
+// Scores how combed the frame woven from `top` (even lines) and `bottom` (odd lines) would be, without building the frame.
+// A pixel is combed when it is brighter or darker than both vertical neighbours (which come from the other field) by more
+// than pixelThreshold. The result is the highest count of combed pixels in any COMB_BLOCK_SIZE square block, like TFM's MIC.
+// Both planes must have the same dimensions and bit depth.
+int CombMetric(const FieldPlane& top, const FieldPlane& bottom, int pixelThreshold = COMB_PIXEL_THRESHOLD);
@@ -0,0 +1,599 @@
+#include "CommandLine.h"
+#include "ActionScan.h"
+#include "CycleStatus.h"
+#include "ProjectFile.h"
+#include "ScriptGraph.h"
+#include "SyntheticClip.h"
+#include "VSScriptLibrary.h"
+#include "WorkerPool.h"
+#include "Y4MExport.h"
+#include "gzip/compress.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(_WIN32) && defined(WL_DIST)
+#define NOMINMAX
+#include <windows.h>
+#endif
+
+using nlohmann::json;
+using nlohmann::ordered_json;
+
+enum CommandStatus {
+	COMMAND_SUCCESS = 0,
+	COMMAND_INVALID = 1, // A project failed validation, or its script doesn't match it
+	COMMAND_ERROR = 2,   // Bad arguments or unreadable projects
+};
+
+static const int ACTION_INVALID = -1;
+static const int ACTION_DROP = 8;
+static const int ACTION_COMPLETE_PREVIOUS_CYCLE = 9;
+
+static const int VALIDATION_CHUNK_CYCLES = 4096;
+
+struct LoadedProject {
+	std::string path;
+	std::string error;
+	json project;
+	// ACTION_INVALID where the project doesn't hold an integer
+	std::vector<int> actions;
+};
+
+static void PrintUsage() {
+	fprintf(stderr,
+		"Usage: IVTCDN <command> [--json] <project.ivtc>...\n"
+		"       IVTCDN export [-o <file.y4m>] [--requests <n>] <project.ivtc>\n"
+		"       IVTCDN synth [options] <clip.vpy>\n"
+		"\n"
+		"Commands:\n"
+		"  info      Project summary, and the clip its script produces\n"
+		"  validate  Check actions, notes, scene changes and no match handling\n"
+		"  stats     Action pattern and cycle status statistics\n"
+		"  export    Write the IVTC output as Y4M to a file, or stdout if no file (or -) is given\n"
+		"  synth     Write a synthetic telecined clip's script, and a project next to it holding the right answer\n"
+		"\n"
+		"synth options (defaults in brackets):\n"
+		"  --width <n> [720]  --height <n> [480]  --format <name> [YUV420P8]  --cycles <n> [2000]\n"
+		"  --pattern-breaks <cycles> [0]  --orphans <cycles> [0]  --scene-length <frames> [0]  --seed <n> [1]\n"
+		"\n"
+		"Exit status is 0 on success, 1 if a project is invalid and 2 if a project can't be read.\n");
+}
+
+static void PrintText(const ordered_json& value, const int indent) {
+	for (auto& [key, item] : value.items()) {
+		if (item.is_object()) {
+			printf("%*s%s:\n", indent, "", key.c_str());
+			PrintText(item, indent + 2);
+		} else if (item.is_string()) {
+			printf("%*s%s: %s\n", indent, "", key.c_str(), item.get<std::string>().c_str());
+		} else {
+			printf("%*s%s: %s\n", indent, "", key.c_str(), item.dump().c_str());
+		}
+	}
+}
+
+static void PrintResults(const std::vector<ordered_json>& results, const bool asJson) {
+	if (asJson) {
+		printf("%s\n", ordered_json(results).dump(2).c_str());
+		return;
+	}
+	for (size_t i = 0; i < results.size(); i++) {
+		if (i > 0) {
+			printf("\n");
+		}
+		PrintText(results[i], 0);
+	}
+}
+
+static std::vector<int> ExtractActions(const json& project) {
+	std::vector<int> actions;
+	const auto it = project.find("ivtc_actions");
+	if (it == project.end() || !it->is_array()) {
+		return actions;
+	}
+	actions.reserve(it->size());
+	for (const auto& action : *it) {
+		actions.push_back(action.is_number_integer() ? action.get<int>() : ACTION_INVALID);
+	}
+	return actions;
+}
+
+// Decompressing and parsing dominates for large projects, so every project is read on its own worker
+static std::vector<LoadedProject> LoadProjects(const std::vector<std::string>& paths, WorkerPool& pool) {
+	std::vector<LoadedProject> projects(paths.size());
+	auto progress = std::make_shared<JobProgress>();
+	pool.ParallelFor(0, (int)paths.size(), 1, progress, [&](int begin, int end) {
+		for (int i = begin; i < end; i++) {
+			projects[i].path = paths[i];
+			if (ReadProjectFile(paths[i], projects[i].project, projects[i].error)) {
+				projects[i].actions = ExtractActions(projects[i].project);
+			}
+			progress->completed++;
+		}
+	});
+	pool.Wait(progress);
+	return projects;
+}
+
+static int OutputFrameCount(const int fieldCount) {
+	return fieldCount / 10 * 4 + fieldCount % 10 * 4 / 10;
+}
+
+static std::vector<int> SceneChanges(const json& project) {
+	std::vector<int> sceneChanges;
+	const auto garbage = project.find("project_garbage");
+	if (garbage == project.end() || !garbage->contains("scene_changes")) {
+		return sceneChanges;
+	}
+	for (const auto& field : (*garbage)["scene_changes"]) {
+		if (field.is_number_integer()) {
+			sceneChanges.push_back(field.get<int>());
+		}
+	}
+	return sceneChanges;
+}
+
+static std::vector<char> Notes(const json& project) {
+	std::vector<char> notes;
+	const auto garbage = project.find("project_garbage");
+	if (garbage == project.end() || !garbage->contains("notes")) {
+		return notes;
+	}
+	for (const auto& note : (*garbage)["notes"]) {
+		notes.push_back(note.is_string() && !note.get<std::string>().empty() ? note.get<std::string>()[0] : 0);
+	}
+	return notes;
+}
+
+// Output frames keyed in one of the project's per frame objects, such as no_match_handling
+static std::vector<int> KeyedFrames(const json& project, const char* key) {
+	std::vector<int> frames;
+	const auto it = project.find(key);
+	if (it == project.end() || !it->is_object()) {
+		return frames;
+	}
+	for (const auto& [frame, handling] : it->items()) {
+		char* end = nullptr;
+		const long value = strtol(frame.c_str(), &end, 10);
+		if (end != frame.c_str() && *end == '\0') {
+			frames.push_back((int)value);
+		}
+	}
+	return frames;
+}
+
+static ordered_json ValidateProjectData(const LoadedProject& loaded, const CycleFindings& findings, bool& valid) {
+	const json& project = loaded.project;
+	const int fieldCount = (int)loaded.actions.size();
+	const int frameCount = OutputFrameCount(fieldCount);
+	std::vector<std::string> problems;
+
+	if (!project.contains("ivtc_actions") || !project["ivtc_actions"].is_array()) {
+		problems.push_back("ivtc_actions is missing");
+	}
+	const auto garbage = project.find("project_garbage");
+	if (garbage == project.end() || !garbage->is_object()) {
+		problems.push_back("project_garbage is missing");
+	} else {
+		if (!garbage->contains("script_file") || !(*garbage)["script_file"].is_string()) {
+			problems.push_back("project_garbage.script_file is missing");
+		}
+		if (garbage->contains("notes") && (*garbage)["notes"].size() != (size_t)fieldCount) {
+			problems.push_back("project_garbage.notes has " + std::to_string((*garbage)["notes"].size()) + " entries for " + std::to_string(fieldCount) + " fields");
+		}
+		if (garbage->contains("scene_changes")) {
+			for (const auto& field : (*garbage)["scene_changes"]) {
+				if (!field.is_number_integer() || field.get<int>() < 0 || field.get<int>() >= fieldCount) {
+					problems.push_back("project_garbage.scene_changes contains " + field.dump());
+				}
+			}
+		}
+	}
+	const auto noMatch = project.find("no_match_handling");
+	if (noMatch != project.end()) {
+		for (const auto& [frame, handling] : noMatch->items()) {
+			char* end = nullptr;
+			const long value = strtol(frame.c_str(), &end, 10);
+			if (end == frame.c_str() || *end != '\0' || value < 0 || value >= frameCount) {
+				problems.push_back("no_match_handling has an entry for frame " + frame);
+			} else if (handling != "Previous" && handling != "Next") {
+				problems.push_back("no_match_handling of frame " + frame + " is " + handling.dump());
+			}
+		}
+	}
+
+	valid = problems.empty() && findings.invalidActions.count == 0 && findings.duplicateFields.count == 0;
+	ordered_json result = {
+		{"project", loaded.path},
+		{"valid", valid},
+		{"fields", fieldCount},
+		{"cycles", (fieldCount + 9) / 10},
+		{"output_frames", frameCount},
+		{"invalid_actions", findings.invalidActions.ToJson()},
+		{"duplicate_fields", findings.duplicateFields.ToJson()},
+		{"orphaned_fields", findings.orphanedFields.ToJson()},
+		{"freeze_frames", findings.freezeFrames.ToJson()},
+		{"single_field_frames", findings.singleFieldFrames.ToJson()},
+	};
+	if (!problems.empty()) {
+		result["problems"] = problems;
+	}
+	return result;
+}
+
+static int Validate(const std::vector<std::string>& paths, const bool asJson) {
+	// There's no UI to leave room for when run from the command line, the command's result is what the user waits on
+	WorkerPool pool(Walnut::JobPriority::Interactive);
+	std::vector<LoadedProject> projects = LoadProjects(paths, pool);
+
+	// Every project's cycles are split into chunks which all share the pool, so one huge project doesn't serialise the rest
+	std::vector<std::vector<CycleFindings>> chunks(projects.size());
+	auto progress = std::make_shared<JobProgress>();
+	for (size_t i = 0; i < projects.size(); i++) {
+		const std::vector<int>& actions = projects[i].actions;
+		const int cycleCount = ((int)actions.size() + 9) / 10;
+		std::vector<CycleFindings>& results = chunks[i];
+		results.resize((cycleCount + VALIDATION_CHUNK_CYCLES - 1) / VALIDATION_CHUNK_CYCLES);
+		pool.ParallelFor(0, cycleCount, VALIDATION_CHUNK_CYCLES, progress, [&actions, &results, progress](int begin, int end) {
+			results[begin / VALIDATION_CHUNK_CYCLES] = ScanCycles(actions, begin, end);
+			progress->completed += end - begin;
+		});
+	}
+	pool.Wait(progress);
+
+	int status = COMMAND_SUCCESS;
+	std::vector<ordered_json> results;
+	for (size_t i = 0; i < projects.size(); i++) {
+		if (!projects[i].error.empty()) {
+			fprintf(stderr, "%s\n", projects[i].error.c_str());
+			results.push_back({ {"project", projects[i].path}, {"error", projects[i].error} });
+			status = COMMAND_ERROR;
+			continue;
+		}
+		CycleFindings findings;
+		for (const CycleFindings& chunk : chunks[i]) {
+			findings.Merge(chunk);
+		}
+		bool valid = false;
+		results.push_back(ValidateProjectData(projects[i], findings, valid));
+		if (!valid) {
+			status = std::max<int>(status, COMMAND_INVALID);
+		}
+	}
+	PrintResults(results, asJson);
+	return status;
+}
+
+static ordered_json ProjectStats(const LoadedProject& loaded) {
+	const std::vector<int>& actions = loaded.actions;
+	const int fieldCount = (int)actions.size();
+	const int cycleCount = (fieldCount + 9) / 10;
+
+	// Actions of every complete cycle as a string of digits, which is also how they read in the GUI
+	std::map<std::string, int> patterns;
+	int dropped = 0;
+	for (int cycle = 0; cycle < fieldCount / 10; cycle++) {
+		std::string pattern(10, '?');
+		for (int i = 0; i < 10; i++) {
+			const int action = actions[cycle * 10 + i];
+			if (action >= 0 && action <= ACTION_COMPLETE_PREVIOUS_CYCLE) {
+				pattern[i] = (char)('0' + action);
+			}
+		}
+		patterns[pattern]++;
+	}
+	for (int action : actions) {
+		dropped += action == ACTION_DROP;
+	}
+	std::vector<std::pair<std::string, int>> sorted(patterns.begin(), patterns.end());
+	std::stable_sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b) { return a.second > b.second; });
+	ordered_json common = ordered_json::object();
+	for (size_t i = 0; i < sorted.size() && i < Findings::MAX_EXAMPLES; i++) {
+		common[sorted[i].first] = sorted[i].second;
+	}
+
+	std::vector<int8_t> statusActions(actions.begin(), actions.end());
+	std::vector<int> sceneChanges = SceneChanges(loaded.project);
+	std::sort(sceneChanges.begin(), sceneChanges.end());
+	sceneChanges.erase(std::unique(sceneChanges.begin(), sceneChanges.end()), sceneChanges.end());
+	const int scenes = 1 + (int)std::count_if(sceneChanges.begin(), sceneChanges.end(), [fieldCount](int field) {
+		return field > 0 && field < fieldCount;
+	});
+	CycleStatus status;
+	status.Rebuild(std::move(statusActions), Notes(loaded.project), sceneChanges, KeyedFrames(loaded.project, "no_match_handling"), KeyedFrames(loaded.project, "extra_attributes"));
+	int flagged[CYCLE_STATUS_FLAG_COUNT] = {};
+	for (int cycle = 0; cycle < status.GetCycleCount(); cycle++) {
+		for (int flag = 0; flag < CYCLE_STATUS_FLAG_COUNT; flag++) {
+			flagged[flag] += (status.GetFlags(cycle) >> flag) & 1;
+		}
+	}
+
+	return ordered_json{
+		{"project", loaded.path},
+		{"fields", fieldCount},
+		{"cycles", cycleCount},
+		{"output_frames", OutputFrameCount(fieldCount)},
+		{"dropped_fields", dropped},
+		{"scenes", scenes},
+		{"distinct_patterns", (int)patterns.size()},
+		{"common_patterns", common},
+		{"cycles_deviating_from_scene", flagged[0]},
+		{"cycles_with_single_field_frames", flagged[1]},
+		{"cycles_with_freeze_frames", flagged[2]},
+		{"cycles_with_no_match_overrides", flagged[3]},
+		{"cycles_with_notes_deviating_from_scene", flagged[4]},
+		{"cycles_with_extra_attributes", flagged[5]},
+	};
+}
+
+static int Stats(const std::vector<std::string>& paths, const bool asJson) {
+	WorkerPool pool(Walnut::JobPriority::Interactive);
+	std::vector<LoadedProject> projects = LoadProjects(paths, pool);
+	int status = COMMAND_SUCCESS;
+	std::vector<ordered_json> results;
+	for (const LoadedProject& project : projects) {
+		if (!project.error.empty()) {
+			fprintf(stderr, "%s\n", project.error.c_str());
+			results.push_back({ {"project", project.path}, {"error", project.error} });
+			status = COMMAND_ERROR;
+			continue;
+		}
+		results.push_back(ProjectStats(project));
+	}
+	PrintResults(results, asJson);
+	return status;
+}
+
+// Evaluates the project's script without requesting any frames
+static ordered_json ScriptInfo(const std::string& scriptFile, const int projectFields, bool& matches) {
+	matches = false;
+	const VSSCRIPTAPI* vssapi = GetVSScriptAPI();
+	if (!vssapi) {
+		return { {"error", "VapourSynth is not available"} };
+	}
+	const VSAPI* vsapi = vssapi->getVSAPI(VAPOURSYNTH_API_VERSION);
+	VSScript* script = vssapi->createScript(nullptr);
+	vssapi->evalSetWorkingDir(script, 1);
+	ordered_json result;
+	if (vssapi->evaluateFile(script, scriptFile.c_str()) != 0) {
+		result["error"] = vssapi->getError(script);
+	} else if (VSNode* node = vssapi->getOutputNode(script, 0)) {
+		const VSVideoInfo* vi = vsapi->getVideoInfo(node);
+		char formatName[32] = {};
+		vsapi->getVideoFormatName(&vi->format, formatName);
+		matches = vi->numFrames * 2 == projectFields;
+		result["format"] = formatName;
+		result["width"] = vi->width;
+		result["height"] = vi->height;
+		result["frames"] = vi->numFrames;
+		result["fields"] = vi->numFrames * 2;
+		if (vi->fpsDen) {
+			result["fps"] = std::to_string(vi->fpsNum) + "/" + std::to_string(vi->fpsDen);
+		}
+		result["matches_project"] = matches;
+		vsapi->freeNode(node);
+	} else {
+		result["error"] = "Script has no output";
+	}
+	vssapi->freeScript(script);
+	return result;
+}
+
+static int Info(const std::vector<std::string>& paths, const bool asJson) {
+	WorkerPool pool(Walnut::JobPriority::Interactive);
+	std::vector<LoadedProject> projects = LoadProjects(paths, pool);
+	int status = COMMAND_SUCCESS;
+	std::vector<ordered_json> results;
+	for (const LoadedProject& loaded : projects) {
+		if (!loaded.error.empty()) {
+			fprintf(stderr, "%s\n", loaded.error.c_str());
+			results.push_back({ {"project", loaded.path}, {"error", loaded.error} });
+			status = COMMAND_ERROR;
+			continue;
+		}
+		const json& project = loaded.project;
+		const json garbage = project.value("project_garbage", json::object());
+		const std::string scriptFile = garbage.value("script_file", std::string());
+		const int fieldCount = (int)loaded.actions.size();
+		ordered_json result = {
+			{"project", loaded.path},
+			{"script_file", scriptFile},
+			{"version", garbage.value("version", 0)},
+			{"tff", project.value("tff", true)},
+			{"fields", fieldCount},
+			{"cycles", (fieldCount + 9) / 10},
+			{"output_frames", OutputFrameCount(fieldCount)},
+			{"scene_changes", (int)SceneChanges(project).size()},
+			{"no_match_default", project.value("no_match_handling_default", std::string("Previous"))},
+			{"no_match_overrides", (int)KeyedFrames(project, "no_match_handling").size()},
+		};
+		bool matches = false;
+		result["script"] = ScriptInfo(scriptFile, fieldCount, matches);
+		if (!matches) {
+			status = std::max<int>(status, COMMAND_INVALID);
+		}
+		results.push_back(result);
+	}
+	PrintResults(results, asJson);
+	return status;
+}
+
+// Streams the project's output as Y4M, reporting progress on stderr so stdout can carry the video
+static int Export(int argc, char** argv) {
+	std::string output = "-";
+	std::string projectPath;
+	int requests = 0;
+	for (int i = 2; i < argc; i++) {
+		const bool hasValue = i + 1 < argc;
+		if ((strcmp(argv[i], "-o") == 0 || strcmp(argv[i], "--output") == 0) && hasValue) {
+			output = argv[++i];
+		} else if (strcmp(argv[i], "--requests") == 0 && hasValue) {
+			requests = atoi(argv[++i]);
+		} else if (projectPath.empty()) {
+			projectPath = argv[i];
+		} else {
+			PrintUsage();
+			return COMMAND_ERROR;
+		}
+	}
+	if (projectPath.empty()) {
+		PrintUsage();
+		return COMMAND_ERROR;
+	}
+
+	json project;
+	std::string error;
+	if (!ReadProjectFile(projectPath, project, error)) {
+		fprintf(stderr, "%s\n", error.c_str());
+		return COMMAND_ERROR;
+	}
+	const std::string scriptFile = project.value("project_garbage", json::object()).value("script_file", std::string());
+	const VSSCRIPTAPI* vssapi = GetVSScriptAPI();
+	if (!vssapi) {
+		fprintf(stderr, "VapourSynth is not available\n");
+		return COMMAND_ERROR;
+	}
+	const VSAPI* vsapi = vssapi->getVSAPI(VAPOURSYNTH_API_VERSION);
+	VSScript* script = vssapi->createScript(nullptr);
+	vssapi->evalSetWorkingDir(script, 1);
+	if (vssapi->evaluateFile(script, scriptFile.c_str()) != 0) {
+		fprintf(stderr, "Error loading %s: %s\n", scriptFile.c_str(), vssapi->getError(script));
+		vssapi->freeScript(script);
+		return COMMAND_ERROR;
+	}
+
+	VSCore* core = vssapi->getCore(script);
+	VSNode* node = ScriptGraph(vsapi, core).OutputView(vssapi->getOutputNode(script, 0), project.dump());
+	Y4MExporter exporter;
+	if (exporter.Start(vsapi, core, node, output, requests)) {
+		while (exporter.IsRunning()) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(500));
+			fprintf(stderr, "\rFrame %d/%d (%.2f fps)", exporter.GetFramesWritten(), exporter.GetTotalFrames(), exporter.GetFps());
+		}
+		exporter.Wait();
+		fprintf(stderr, "\rFrame %d/%d (%.2f fps) in %.2f s\n", exporter.GetFramesWritten(), exporter.GetTotalFrames(), exporter.GetFps(), exporter.GetElapsedSeconds());
+	}
+	vsapi->freeNode(node);
+	vssapi->freeScript(script);
+	if (!exporter.Succeeded()) {
+		fprintf(stderr, "%s\n", exporter.GetError().c_str());
+		return COMMAND_ERROR;
+	}
+	return COMMAND_SUCCESS;
+}
+
+// Writes a synthetic clip's script and its ground truth project, which needs no source or VapourSynth to produce
+static int Synth(int argc, char** argv) {
+	SyntheticClip clip;
+	std::string scriptPath;
+	for (int i = 2; i < argc; i++) {
+		const bool hasValue = i + 1 < argc;
+		if (strcmp(argv[i], "--width") == 0 && hasValue) {
+			clip.width = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "--height") == 0 && hasValue) {
+			clip.height = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "--format") == 0 && hasValue) {
+			clip.format = argv[++i];
+		} else if (strcmp(argv[i], "--cycles") == 0 && hasValue) {
+			clip.cycles = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "--pattern-breaks") == 0 && hasValue) {
+			clip.patternBreakInterval = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "--orphans") == 0 && hasValue) {
+			clip.orphanInterval = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "--scene-length") == 0 && hasValue) {
+			clip.sceneLength = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "--seed") == 0 && hasValue) {
+			clip.seed = (uint32_t)strtoul(argv[++i], nullptr, 10);
+		} else if (scriptPath.empty()) {
+			scriptPath = argv[i];
+		} else {
+			PrintUsage();
+			return COMMAND_ERROR;
+		}
+	}
+	if (scriptPath.empty()) {
+		PrintUsage();
+		return COMMAND_ERROR;
+	}
+	const std::string clipError = clip.Validate();
+	if (!clipError.empty()) {
+		fprintf(stderr, "%s\n", clipError.c_str());
+		return COMMAND_ERROR;
+	}
+
+	// Projects are opened from anywhere, so they refer to their script by absolute path
+	const std::filesystem::path script = std::filesystem::absolute(scriptPath);
+	std::filesystem::path projectPath = script;
+	projectPath.replace_extension(".ivtc");
+	std::ofstream scriptOutput(script, std::ios::binary);
+	scriptOutput << clip.Script();
+	const std::string project = clip.Project(script.string()).dump();
+	const std::string compressed = gzip::compress(project.c_str(), project.size());
+	std::ofstream projectOutput(projectPath, std::ios::binary);
+	projectOutput << compressed;
+	if (!scriptOutput || !projectOutput) {
+		fprintf(stderr, "Failed to write %s or %s\n", script.string().c_str(), projectPath.string().c_str());
+		return COMMAND_ERROR;
+	}
+	printf("%s\n%s\n", script.string().c_str(), projectPath.string().c_str());
+	return COMMAND_SUCCESS;
+}
+
+int RunCommandLine(int argc, char** argv) {
+	if (argc < 2) {
+		return -1;
+	}
+	const std::string command = argv[1];
+	if (command != "info" && command != "validate" && command != "stats" && command != "export" && command != "synth" && command != "help" && command != "--help") {
+		return -1;
+	}
+
+#if defined(_WIN32) && defined(WL_DIST)
+	// Dist builds are windowed applications, borrow the console of whoever started us
+	if (AttachConsole(ATTACH_PARENT_PROCESS)) {
+		freopen("CONOUT$", "w", stdout);
+		freopen("CONOUT$", "w", stderr);
+	}
+#endif
+
+	if (command == "export") {
+		return Export(argc, argv);
+	} else if (command == "synth") {
+		return Synth(argc, argv);
+	}
+
+	bool asJson = false;
+	std::vector<std::string> paths;
+	for (int i = 2; i < argc; i++) {
+		if (strcmp(argv[i], "--json") == 0) {
+			asJson = true;
+		} else {
+			paths.push_back(argv[i]);
+		}
+	}
+	if (command == "help" || command == "--help") {
+		PrintUsage();
+		return COMMAND_SUCCESS;
+	}
+	if (paths.empty()) {
+		PrintUsage();
+		return COMMAND_ERROR;
+	}
+
+	if (command == "info") {
+		return Info(paths, asJson);
+	} else if (command == "validate") {
+		return Validate(paths, asJson);
+	}
+	return Stats(paths, asJson);
+}
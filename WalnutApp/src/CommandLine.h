@@ -0,0 +1,5 @@
+#pragma once
+
+// Runs a headless subcommand (info, validate, stats, export or synth) without creating a window. Returns the process
+// exit code, or -1 when the arguments don't name a subcommand and the GUI should start as normal.
+int RunCommandLine(int argc, char** argv);
@@ -0,0 +1,151 @@
+#include "CoreGovernor.h"
+
+#include "vapoursynth/VapourSynth4.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#endif
+
+using json = nlohmann::json;
+
+static const int64_t MB = 1024 * 1024;
+static const int SAMPLE_INTERVAL_MS = 500;
+// Adaptive mode never goes below this, a few fields' worth of frames per filter is needed just to navigate
+static const int64_t MIN_ADAPTIVE_BUDGET = 512 * MB;
+// Growing only starts above the reserve plus this much, so available memory hovering around the reserve doesn't flap
+static const int64_t GROW_HYSTERESIS = 512 * MB;
+
+static int64_t NowMilliseconds() {
+	return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+json CoreSettings::ToJson() const {
+	return {
+		{"threads", threads},
+		{"cache_mb", cacheMB},
+		{"adaptive", adaptive},
+		{"reserve_mb", reserveMB},
+	};
+}
+
+CoreSettings CoreSettings::FromJson(const json& object, const CoreSettings& defaults) {
+	CoreSettings settings = defaults;
+	if (!object.is_object()) {
+		return settings;
+	}
+	settings.threads = std::max(0, object.value("threads", defaults.threads));
+	settings.cacheMB = std::max(0, object.value("cache_mb", defaults.cacheMB));
+	settings.adaptive = object.value("adaptive", defaults.adaptive);
+	settings.reserveMB = std::max(0, object.value("reserve_mb", defaults.reserveMB));
+	return settings;
+}
+
+#ifdef _WIN32
+
+bool QuerySystemMemory(SystemMemory& memory) {
+	MEMORYSTATUSEX status = {};
+	status.dwLength = sizeof(status);
+	if (!GlobalMemoryStatusEx(&status)) {
+		return false;
+	}
+	memory.total = (int64_t)status.ullTotalPhys;
+	memory.available = (int64_t)status.ullAvailPhys;
+	return true;
+}
+
+#else
+
+bool QuerySystemMemory(SystemMemory& memory) {
+	FILE* file = fopen("/proc/meminfo", "r");
+	if (!file) {
+		return false;
+	}
+	bool hasTotal = false;
+	bool hasAvailable = false;
+	char line[256];
+	while (fgets(line, sizeof(line), file)) {
+		long long kb = 0;
+		if (sscanf(line, "MemTotal: %lld kB", &kb) == 1) {
+			memory.total = kb * 1024;
+			hasTotal = true;
+		} else if (sscanf(line, "MemAvailable: %lld kB", &kb) == 1) {
+			memory.available = kb * 1024;
+			hasAvailable = true;
+		}
+	}
+	fclose(file);
+	return hasTotal && hasAvailable;
+}
+
+#endif
+
+void CoreGovernor::Attach(const VSAPI* vsapi, VSCore* core, const CoreSettings& settings) {
+	if (core != m_Core) {
+		VSCoreInfo info;
+		vsapi->getCoreInfo(core, &info);
+		m_DefaultBudgetBytes = info.maxFramebufferSize;
+	}
+	m_VSAPI = vsapi;
+	m_Core = core;
+	m_Settings = settings;
+	m_Threads = vsapi->setThreadCount(settings.threads, core);
+	m_BudgetBytes = vsapi->setMaxCacheSize(settings.cacheMB > 0 ? settings.cacheMB * MB : m_DefaultBudgetBytes, core);
+	m_LastSample = 0;
+	Update();
+}
+
+void CoreGovernor::Detach() {
+	m_VSAPI = nullptr;
+	m_Core = nullptr;
+	m_UsedBytes = 0;
+	m_BudgetBytes = 0;
+	m_Threads = 0;
+}
+
+void CoreGovernor::Update() {
+	if (!m_Core) {
+		return;
+	}
+	const int64_t now = NowMilliseconds();
+	if (now - m_LastSample < SAMPLE_INTERVAL_MS) {
+		return;
+	}
+	m_LastSample = now;
+
+	VSCoreInfo info;
+	m_VSAPI->getCoreInfo(m_Core, &info);
+	m_Threads = info.numThreads;
+	m_UsedBytes = info.usedFramebufferSize;
+	m_BudgetBytes = info.maxFramebufferSize;
+	m_HasSystemMemory = QuerySystemMemory(m_System);
+
+	if (m_Settings.adaptive && m_HasSystemMemory) {
+		Adapt();
+	}
+}
+
+void CoreGovernor::Adapt() {
+	const int64_t reserve = m_Settings.reserveMB * MB;
+	const int64_t ceiling = m_Settings.cacheMB > 0 ? m_Settings.cacheMB * MB : std::max(MIN_ADAPTIVE_BUDGET, m_System.total - reserve);
+
+	int64_t budget = m_BudgetBytes;
+	if (m_System.available < reserve) {
+		// Give back the shortfall, starting from what's actually cached since the budget may be far above it
+		budget = std::min(budget, m_UsedBytes) - (reserve - m_System.available);
+	} else if (m_UsedBytes >= budget - budget / 8 && m_System.available > reserve + GROW_HYSTERESIS) {
+		// The cache is at its limit, let it have a quarter more or whatever's spare above the reserve
+		budget += std::min(budget / 4, m_System.available - reserve - GROW_HYSTERESIS);
+	}
+	budget = std::clamp(budget, std::min(MIN_ADAPTIVE_BUDGET, ceiling), ceiling);
+
+	// The core trims its cache on its own once it's over the new budget
+	if (std::abs(budget - m_BudgetBytes) >= 16 * MB) {
+		m_BudgetBytes = m_VSAPI->setMaxCacheSize(budget, m_Core);
+	}
+}
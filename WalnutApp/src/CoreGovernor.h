@@ -0,0 +1,63 @@
+#pragma once
+
+#include "json.hpp"
+
+#include <cstdint>
+
+struct VSAPI;
+struct VSCore;
+
+// Thread count and frame cache budget of the script's core. 0 keeps VapourSynth's own default for either.
+struct CoreSettings {
+	int threads = 0;
+	int cacheMB = 0;
+	// Moves the cache budget (up to cacheMB, when set) to keep reserveMB of system memory available
+	bool adaptive = false;
+	int reserveMB = 4096;
+
+	nlohmann::json ToJson() const;
+	// Missing attributes keep the values in defaults
+	static CoreSettings FromJson(const nlohmann::json& object, const CoreSettings& defaults);
+};
+
+struct SystemMemory {
+	int64_t total = 0;
+	int64_t available = 0;
+};
+
+// Physical memory of the machine, false where it can't be queried
+bool QuerySystemMemory(SystemMemory& memory);
+
+// Samples the core's framebuffer usage and the system's available memory for display, and in adaptive mode shrinks the
+// cache budget when other processes need the memory or grows it while the cache is full and memory is plentiful.
+class CoreGovernor {
+public:
+	// Applies the settings to the core, which can be the one already attached (or a new one still using its defaults)
+	void Attach(const VSAPI* vsapi, VSCore* core, const CoreSettings& settings);
+	void Detach();
+	// Cheap to call every frame, only samples a few times a second
+	void Update();
+
+	bool IsAttached() const { return m_Core != nullptr; }
+	const CoreSettings& GetSettings() const { return m_Settings; }
+	int GetThreads() const { return m_Threads; }
+	int64_t GetUsedBytes() const { return m_UsedBytes; }
+	int64_t GetBudgetBytes() const { return m_BudgetBytes; }
+	const SystemMemory& GetSystemMemory() const { return m_System; }
+	bool HasSystemMemory() const { return m_HasSystemMemory; }
+private:
+	void Adapt();
+
+	const VSAPI* m_VSAPI = nullptr;
+	VSCore* m_Core = nullptr;
+	CoreSettings m_Settings;
+	int64_t m_LastSample = 0;
+	// The core's own budget, restored when cacheMB goes back to 0
+	int64_t m_DefaultBudgetBytes = 0;
+
+	int m_Threads = 0;
+	int64_t m_UsedBytes = 0;
+	int64_t m_BudgetBytes = 0;
+	SystemMemory m_System;
+	bool m_HasSystemMemory = false;
+};
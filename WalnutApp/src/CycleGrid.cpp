@@ -0,0 +1,176 @@
+#include "CycleGrid.h"
+#include "FramePacking.h"
+
+#include <cstdio>
+
+CycleGrid::~CycleGrid() {
+	Close();
+}
+
+void CycleGrid::Open(const VSAPI* vsapi, VSNode* fieldsNode, VSNode* framesNode, const int cellWidth, const int cellHeight) {
+	Close();
+	m_VSAPI = vsapi;
+	m_FieldsNode = vsapi->addNodeRef(fieldsNode);
+	m_FieldCount = vsapi->getVideoInfo(fieldsNode)->numFrames;
+	m_CellWidth = cellWidth;
+	m_CellHeight = cellHeight;
+	SetFramesNode(framesNode);
+}
+
+void CycleGrid::Close() {
+	if (!m_VSAPI) {
+		return;
+	}
+	{
+		std::unique_lock<std::mutex> lock(m_Mutex);
+		m_Condition.wait(lock, [&]() { return m_Outstanding == 0; });
+	}
+	m_VSAPI->freeNode(m_FieldsNode);
+	m_VSAPI->freeNode(m_FramesNode);
+	m_FieldsNode = nullptr;
+	m_FramesNode = nullptr;
+	m_FieldCount = 0;
+	m_FrameCount = 0;
+	for (Slot& slot : m_Slots) {
+		slot = Slot();
+	}
+}
+
+void CycleGrid::SetFramesNode(VSNode* framesNode) {
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	// Requests in flight keep their own reference to the node they were made on
+	m_VSAPI->freeNode(m_FramesNode);
+	m_FramesNode = framesNode ? m_VSAPI->addNodeRef(framesNode) : nullptr;
+	m_FrameCount = framesNode ? m_VSAPI->getVideoInfo(framesNode)->numFrames : 0;
+	m_FramesGeneration++;
+}
+
+void CycleGrid::BeginFrame() {
+	m_FrameCounter++;
+}
+
+int CycleGrid::Request(const int cycle) {
+	if (!IsOpen()) {
+		return -1;
+	}
+	std::vector<GridRequest> requests;
+	int found = -1;
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		for (int i = 0; i < MAX_ROWS; i++) {
+			if (m_Slots[i].cycle == cycle) {
+				found = i;
+				break;
+			}
+		}
+		if (found >= 0) {
+			m_Hits++;
+			Slot& slot = m_Slots[found];
+			slot.lastRequested = m_FrameCounter;
+			if (slot.framesGeneration != m_FramesGeneration && slot.outstanding == 0) {
+				Fill(found, false, requests);
+			}
+		} else {
+			// Reuse whichever row went out of view longest ago, rows still loading or drawn this frame are off limits
+			for (int i = 0; i < MAX_ROWS; i++) {
+				const Slot& slot = m_Slots[i];
+				if (slot.outstanding == 0 && slot.lastRequested < m_FrameCounter && (found < 0 || slot.lastRequested < m_Slots[found].lastRequested)) {
+					found = i;
+				}
+			}
+			if (found >= 0) {
+				m_Misses++;
+				Slot& slot = m_Slots[found];
+				slot.cycle = cycle;
+				slot.lastRequested = m_FrameCounter;
+				slot.updated = false;
+				slot.pixels.assign((size_t)GetRowWidth() * m_CellHeight * 4, 0);
+				Fill(found, true, requests);
+			}
+		}
+	}
+	// Outside the lock, since a request that fails straight away may call back on this thread
+	for (const GridRequest& request : requests) {
+		m_VSAPI->getFrameAsync(request.n, request.node, FrameDoneCallback, request.pending);
+	}
+	return found;
+}
+
+void CycleGrid::Fill(const int index, const bool fields, std::vector<GridRequest>& requests) {
+	Slot& slot = m_Slots[index];
+	slot.framesGeneration = m_FramesGeneration;
+	const int cycle = slot.cycle;
+	const size_t first = requests.size();
+	if (fields) {
+		for (int i = 0; i < 10 && cycle * 10 + i < m_FieldCount; i++) {
+			const int x = (i / 2) * m_CellWidth;
+			const int y = (i % 2) * (m_CellHeight / 2);
+			requests.push_back({ m_FieldsNode, cycle * 10 + i, new Pending{ this, index, x, y } });
+		}
+	}
+	if (m_FramesNode) {
+		for (int i = 0; i < GRID_FRAME_COLUMNS && cycle * 4 + i < m_FrameCount; i++) {
+			const int x = (GRID_FIELD_COLUMNS + i) * m_CellWidth;
+			requests.push_back({ m_FramesNode, cycle * 4 + i, new Pending{ this, index, x, 0 } });
+		}
+	}
+	slot.outstanding += (int)(requests.size() - first);
+	m_Outstanding += (int)(requests.size() - first);
+}
+
+void VS_CC CycleGrid::FrameDoneCallback(void* userData, const VSFrame* frame, int n, VSNode*, const char* errorMsg) {
+	Pending* pending = (Pending*)userData;
+	CycleGrid* grid = pending->grid;
+	const VSAPI* vsapi = grid->m_VSAPI;
+	if (!frame) {
+		fprintf(stderr, "Grid frame %d: %s\n", n, errorMsg ? errorMsg : "unknown error");
+	}
+
+	// Notified under the lock, Close() may free everything as soon as the last request is accounted for
+	std::lock_guard<std::mutex> lock(grid->m_Mutex);
+	Slot& slot = grid->m_Slots[pending->slot];
+	if (frame) {
+		const int rowStride = grid->GetRowWidth() * 4;
+		const int width = vsapi->getFrameWidth(frame, 0);
+		const int height = vsapi->getFrameHeight(frame, 0);
+		// Cells are sized from the nodes, but a script changing size mid-clip mustn't write outside the row
+		if (pending->x + width <= grid->GetRowWidth() && pending->y + height <= grid->m_CellHeight) {
+			PackRGBA32(vsapi, frame, slot.pixels.data() + (size_t)pending->y * rowStride + (size_t)pending->x * 4, rowStride);
+			slot.updated = true;
+		}
+		vsapi->freeFrame(frame);
+	}
+	delete pending;
+	slot.outstanding--;
+	grid->m_Outstanding--;
+	grid->m_Condition.notify_all();
+}
+
+bool CycleGrid::TakeUpdate(const int index, std::vector<uint8_t>& pixels) {
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	Slot& slot = m_Slots[index];
+	if (!slot.updated) {
+		return false;
+	}
+	pixels = slot.pixels;
+	slot.updated = false;
+	return true;
+}
+
+CycleGrid::Stats CycleGrid::GetStats() const {
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	Stats stats;
+	for (const Slot& slot : m_Slots) {
+		stats.rows += slot.cycle >= 0;
+		stats.bytes += slot.pixels.capacity();
+	}
+	stats.hits = m_Hits;
+	stats.misses = m_Misses;
+	stats.nodes = (m_FieldsNode != nullptr) + (m_FramesNode != nullptr);
+	return stats;
+}
+
+bool CycleGrid::IsBusy() const {
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	return m_Outstanding > 0;
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "vapoursynth/VapourSynth4.h"
+
+static const int GRID_CELL_WIDTH = 160;
+static const int GRID_FIELD_COLUMNS = 5;
+static const int GRID_FRAME_COLUMNS = 4;
+
+// Reduced resolution rows for the grid view, one per cycle: its 10 fields as 5 columns of first over second field,
+// followed by its 4 output frames, composed into a single RGBA row so a whole cycle is one texture. Rows live in a
+// bounded pool of slots which are filled with getFrameAsync as they're requested, the least recently requested slot
+// being reused for a row scrolling into view. Output frames are refetched whenever the frames node is replaced.
+class CycleGrid {
+public:
+	static const int MAX_ROWS = 48;
+
+	~CycleGrid();
+
+	// Takes its own references. fieldsNode must be RGB24 separated fields of cellWidth x cellHeight / 2, framesNode
+	// RGB24 output frames of cellWidth x cellHeight.
+	void Open(const VSAPI* vsapi, VSNode* fieldsNode, VSNode* framesNode, int cellWidth, int cellHeight);
+	// Blocks until requests in flight have come back, which must happen before the nodes' core is freed
+	void Close();
+	// Takes its own reference, rows keep their fields and refetch their output frames when next requested
+	void SetFramesNode(VSNode* framesNode);
+
+	// Call once per UI frame before requesting rows, slots requested in the previous frame aren't reused until then
+	void BeginFrame();
+	// Returns the slot holding the cycle's row (filling it in the background if it isn't already), or -1 when every
+	// slot is in use by a visible or still loading row
+	int Request(int cycle);
+	// Copies the row into pixels (GetRowWidth() * GetCellHeight() * 4 bytes) if anything arrived since the last call
+	bool TakeUpdate(int slot, std::vector<uint8_t>& pixels);
+
+	bool IsOpen() const { return m_FieldsNode != nullptr; }
+	bool IsBusy() const;
+	int GetCellWidth() const { return m_CellWidth; }
+	int GetCellHeight() const { return m_CellHeight; }
+	int GetRowWidth() const { return m_CellWidth * (GRID_FIELD_COLUMNS + GRID_FRAME_COLUMNS); }
+
+	struct Stats {
+		int rows = 0;
+		size_t bytes = 0;
+		// Requests for rows already in a slot, and for rows that had to be (re)filled
+		uint64_t hits = 0;
+		uint64_t misses = 0;
+		int nodes = 0;
+	};
+	Stats GetStats() const;
+private:
+	struct Slot {
+		int cycle = -1;
+		uint64_t framesGeneration = 0;
+		uint64_t lastRequested = 0;
+		int outstanding = 0;
+		bool updated = false;
+		std::vector<uint8_t> pixels;
+	};
+
+	struct Pending {
+		CycleGrid* grid;
+		int slot;
+		int x;
+		int y;
+	};
+
+	struct GridRequest {
+		VSNode* node;
+		int n;
+		Pending* pending;
+	};
+
+	// Queues requests for the slot's fields (when asked) and output frames, to be made once the lock is released
+	void Fill(int slot, bool fields, std::vector<GridRequest>& requests);
+	static void VS_CC FrameDoneCallback(void* userData, const VSFrame* frame, int n, VSNode* node, const char* errorMsg);
+
+	const VSAPI* m_VSAPI = nullptr;
+	VSNode* m_FieldsNode = nullptr;
+	VSNode* m_FramesNode = nullptr;
+	int m_FieldCount = 0;
+	int m_FrameCount = 0;
+	int m_CellWidth = 0;
+	int m_CellHeight = 0;
+	uint64_t m_FramesGeneration = 0;
+	uint64_t m_FrameCounter = 0;
+
+	mutable std::mutex m_Mutex;
+	std::condition_variable m_Condition;
+	int m_Outstanding = 0;
+	Slot m_Slots[MAX_ROWS];
+	uint64_t m_Hits = 0;
+	uint64_t m_Misses = 0;
+};
@@ -0,0 +1,269 @@
+#include "CycleStatus.h"
+
+#include <algorithm>
+#include <iterator>
+
+static const int8_t ACTION_DROP = 8;
+static const int8_t ACTION_COMPLETE_PREVIOUS_CYCLE = 9;
+
+static std::vector<int> SceneStarts(std::vector<int> sceneChanges, const int fieldCount) {
+	sceneChanges.push_back(0);
+	std::sort(sceneChanges.begin(), sceneChanges.end());
+	sceneChanges.erase(std::unique(sceneChanges.begin(), sceneChanges.end()), sceneChanges.end());
+	sceneChanges.erase(std::remove_if(sceneChanges.begin(), sceneChanges.end(), [fieldCount](int field) {
+		return field < 0 || (field > 0 && field >= fieldCount);
+	}), sceneChanges.end());
+	return sceneChanges;
+}
+
+static std::vector<uint8_t> FrameBits(const std::vector<int>& frames, const int cycleCount) {
+	std::vector<uint8_t> bits(cycleCount, 0);
+	for (int frame : frames) {
+		if (frame >= 0 && frame / 4 < cycleCount) {
+			bits[frame / 4] |= 1 << (frame % 4);
+		}
+	}
+	return bits;
+}
+
+void CycleStatus::Rebuild(std::vector<int8_t> actions, std::vector<char> notes, std::vector<int> sceneChanges, const std::vector<int>& noMatchFrames, const std::vector<int>& extraAttributeFrames) {
+	m_Actions = std::move(actions);
+	const int fieldCount = (int)m_Actions.size();
+	const int cycleCount = (fieldCount + 9) / 10;
+	m_Notes = std::move(notes);
+	m_Notes.resize(fieldCount, 0);
+	m_SceneStarts = SceneStarts(std::move(sceneChanges), fieldCount);
+	m_NoMatchFrames = FrameBits(noMatchFrames, cycleCount);
+	m_ExtraAttributeFrames = FrameBits(extraAttributeFrames, cycleCount);
+
+	m_Levels.clear();
+	if (cycleCount == 0) {
+		return;
+	}
+	m_Levels.emplace_back(cycleCount, 0);
+	for (int size = cycleCount; size > 1;) {
+		size = (size + 1) / 2;
+		m_Levels.emplace_back(size, 0);
+	}
+	RefreshCycles(0, cycleCount - 1);
+}
+
+void CycleStatus::Clear() {
+	m_Actions.clear();
+	m_Notes.clear();
+	m_SceneStarts.clear();
+	m_NoMatchFrames.clear();
+	m_ExtraAttributeFrames.clear();
+	m_Levels.clear();
+}
+
+void CycleStatus::SetAction(const int field, const int action) {
+	SetActions(field, std::vector<int8_t>(1, (int8_t)action));
+}
+
+void CycleStatus::SetActions(const int firstField, const std::vector<int8_t>& actions) {
+	const int lastField = std::min(firstField + (int)actions.size(), (int)m_Actions.size()) - 1;
+	if (firstField < 0 || lastField < firstField) {
+		return;
+	}
+	std::copy(actions.begin(), actions.begin() + (lastField - firstField + 1), m_Actions.begin() + firstField);
+	RefreshFields(firstField, lastField);
+}
+
+void CycleStatus::SetNote(const int field, const char note) {
+	SetNotes(field, std::vector<char>(1, note));
+}
+
+void CycleStatus::SetNotes(const int firstField, const std::vector<char>& notes) {
+	const int lastField = std::min(firstField + (int)notes.size(), (int)m_Notes.size()) - 1;
+	if (firstField < 0 || lastField < firstField) {
+		return;
+	}
+	std::copy(notes.begin(), notes.begin() + (lastField - firstField + 1), m_Notes.begin() + firstField);
+	RefreshFields(firstField, lastField);
+}
+
+void CycleStatus::RefreshFields(const int firstField, const int lastField) {
+	// A field completing the previous cycle changes that cycle's output
+	int firstCycle = std::max(0, firstField / 10 - (firstField % 10 == 0 ? 1 : 0));
+	int lastCycle = lastField / 10;
+	// Changing a scene's reference cycle can change the status of every cycle in the scene
+	for (int scene = SceneIndex(firstField); scene <= SceneIndex(lastField); scene++) {
+		const int reference = ReferenceCycle(scene);
+		if (reference >= 0 && reference * 10 <= lastField && reference * 10 + 9 >= firstField) {
+			firstCycle = std::min(firstCycle, m_SceneStarts[scene] / 10);
+			lastCycle = std::max(lastCycle, (SceneEnd(scene) - 1) / 10);
+		}
+	}
+	RefreshCycles(firstCycle, lastCycle);
+}
+
+void CycleStatus::SetSceneChanges(std::vector<int> sceneChanges) {
+	if (m_Levels.empty()) {
+		return;
+	}
+	const int fieldCount = (int)m_Actions.size();
+	std::vector<int> sceneStarts = SceneStarts(std::move(sceneChanges), fieldCount);
+	std::vector<int> changed;
+	std::set_symmetric_difference(m_SceneStarts.begin(), m_SceneStarts.end(), sceneStarts.begin(), sceneStarts.end(), std::back_inserter(changed));
+	if (changed.empty()) {
+		return;
+	}
+
+	// Scenes on either side of a boundary which appeared or disappeared get new reference cycles
+	std::vector<int> boundaries;
+	std::set_union(m_SceneStarts.begin(), m_SceneStarts.end(), sceneStarts.begin(), sceneStarts.end(), std::back_inserter(boundaries));
+	boundaries.push_back(fieldCount);
+	m_SceneStarts = std::move(sceneStarts);
+	for (int boundary : changed) {
+		auto it = std::lower_bound(boundaries.begin(), boundaries.end(), boundary);
+		const int start = it == boundaries.begin() ? 0 : *(it - 1);
+		const int end = *(it + 1);
+		RefreshCycles(start / 10, (end - 1) / 10);
+	}
+}
+
+void CycleStatus::SetNoMatchOverride(const int frame, const bool overridden) {
+	SetFrameBit(m_NoMatchFrames, frame, overridden);
+}
+
+void CycleStatus::SetExtraAttributes(const int frame, const bool present) {
+	SetFrameBit(m_ExtraAttributeFrames, frame, present);
+}
+
+void CycleStatus::SetFrameBit(std::vector<uint8_t>& frames, const int frame, const bool set) {
+	const int cycle = frame / 4;
+	if (frame < 0 || cycle >= (int)frames.size()) {
+		return;
+	}
+	if (set) {
+		frames[cycle] |= 1 << (frame % 4);
+	} else {
+		frames[cycle] &= ~(1 << (frame % 4));
+	}
+	RefreshCycles(cycle, cycle);
+}
+
+int CycleStatus::FindFirst(int begin, const int end, const uint8_t mask) const {
+	begin = std::max(begin, 0);
+	while (begin < std::min(end, GetCycleCount())) {
+		// Skip the largest aligned run starting here which has none of the flags
+		int level = 0;
+		while (level + 1 < GetLevelCount() && (begin & ((2 << level) - 1)) == 0 && (begin + (2 << level)) <= end) {
+			level++;
+		}
+		while (level > 0 && (m_Levels[level][begin >> level] & mask)) {
+			level--;
+		}
+		if (level == 0 && (m_Levels[0][begin] & mask)) {
+			return begin;
+		}
+		begin += 1 << level;
+	}
+	return -1;
+}
+
+int CycleStatus::FindLast(int begin, int end, const uint8_t mask) const {
+	begin = std::max(begin, 0);
+	end = std::min(end, GetCycleCount());
+	while (end > begin) {
+		// Skip the largest aligned run ending here which has none of the flags
+		int level = 0;
+		while (level + 1 < GetLevelCount() && (end & ((2 << level) - 1)) == 0 && end - (2 << level) >= begin) {
+			level++;
+		}
+		while (level > 0 && (m_Levels[level][(end - 1) >> level] & mask)) {
+			level--;
+		}
+		if (level == 0 && (m_Levels[0][end - 1] & mask)) {
+			return end - 1;
+		}
+		end -= 1 << level;
+	}
+	return -1;
+}
+
+int CycleStatus::SceneIndex(const int field) const {
+	return (int)(std::upper_bound(m_SceneStarts.begin(), m_SceneStarts.end(), field) - m_SceneStarts.begin()) - 1;
+}
+
+int CycleStatus::SceneEnd(const int scene) const {
+	return scene + 1 < (int)m_SceneStarts.size() ? m_SceneStarts[scene + 1] : (int)m_Actions.size();
+}
+
+int CycleStatus::ReferenceCycle(const int scene) const {
+	const int cycle = (m_SceneStarts[scene] + 9) / 10;
+	return cycle * 10 + 10 <= SceneEnd(scene) ? cycle : -1;
+}
+
+uint8_t CycleStatus::ComputeFlags(const int cycle) const {
+	const int fieldCount = (int)m_Actions.size();
+	const int first = cycle * 10;
+	const int last = std::min(first + 10, fieldCount);
+	uint8_t flags = m_NoMatchFrames[cycle] ? CYCLE_NO_MATCH_OVERRIDE : 0;
+	if (m_ExtraAttributeFrames[cycle]) {
+		flags |= CYCLE_EXTRA_ATTRIBUTES;
+	}
+
+	int fields[4] = {};
+	for (int field = first; field < last; field++) {
+		if (m_Actions[field] >= 0 && m_Actions[field] < ACTION_DROP) {
+			fields[m_Actions[field] / 2]++;
+		}
+	}
+	if (last < fieldCount && m_Actions[last] == ACTION_COMPLETE_PREVIOUS_CYCLE) {
+		fields[3]++;
+	}
+	const int frames = (last - first) * 4 / 10;
+	for (int frame = 0; frame < frames; frame++) {
+		if (fields[frame] == 0) {
+			flags |= CYCLE_FREEZE_FRAME;
+		} else if (fields[frame] == 1) {
+			flags |= CYCLE_SINGLE_FIELD;
+		}
+	}
+
+	for (int field = first, scene = SceneIndex(first); field < last; field++) {
+		if (scene + 1 < (int)m_SceneStarts.size() && field >= m_SceneStarts[scene + 1]) {
+			scene++;
+		}
+		const int reference = ReferenceCycle(scene);
+		if (reference < 0) {
+			continue;
+		}
+		if (m_Actions[field] != m_Actions[reference * 10 + field % 10]) {
+			flags |= CYCLE_PATTERN_DEVIATION;
+		}
+		if (m_Notes[field] != m_Notes[reference * 10 + field % 10]) {
+			flags |= CYCLE_NOTE_DEVIATION;
+		}
+	}
+	return flags;
+}
+
+void CycleStatus::RefreshCycles(int firstCycle, int lastCycle) {
+	firstCycle = std::max(firstCycle, 0);
+	lastCycle = std::min(lastCycle, GetCycleCount() - 1);
+	if (lastCycle < firstCycle) {
+		return;
+	}
+	for (int cycle = firstCycle; cycle <= lastCycle; cycle++) {
+		m_Levels[0][cycle] = ComputeFlags(cycle);
+	}
+	for (int level = 1; level < GetLevelCount(); level++) {
+		firstCycle >>= 1;
+		lastCycle >>= 1;
+		const std::vector<uint8_t>& below = m_Levels[level - 1];
+		for (int i = firstCycle; i <= lastCycle; i++) {
+			m_Levels[level][i] = below[i * 2] | (i * 2 + 1 < (int)below.size() ? below[i * 2 + 1] : 0);
+		}
+	}
+}
+
+size_t CycleStatus::GetMemoryBytes() const {
+	size_t bytes = m_Actions.capacity() * sizeof(int8_t) + m_Notes.capacity() + m_SceneStarts.capacity() * sizeof(int) + m_NoMatchFrames.capacity() + m_ExtraAttributeFrames.capacity();
+	for (const std::vector<uint8_t>& level : m_Levels) {
+		bytes += sizeof(level) + level.capacity();
+	}
+	return bytes;
+}
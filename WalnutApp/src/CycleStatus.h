@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+enum CycleStatusFlags : uint8_t {
+	CYCLE_PATTERN_DEVIATION = 1 << 0, // Actions differ from the first full cycle of the scene
+	CYCLE_SINGLE_FIELD = 1 << 1,      // An output frame is built from a single (line-doubled) field
+	CYCLE_FREEZE_FRAME = 1 << 2,      // An output frame has no fields and repeats a neighbour
+	CYCLE_NO_MATCH_OVERRIDE = 1 << 3, // An output frame overrides the default no match handling
+	CYCLE_NOTE_DEVIATION = 1 << 4,    // Notes differ from the first full cycle of the scene
+	CYCLE_EXTRA_ATTRIBUTES = 1 << 5,  // An output frame has extra attributes
+};
+
+static const int CYCLE_STATUS_FLAG_COUNT = 6;
+
+// Status flags of every cycle derived from the project's actions, notes, scene changes, no match overrides and extra
+// attributes.
+// Edits only recompute the cycles they can affect, and the flags are kept in an OR pyramid where level k
+// holds the flags of aligned runs of 2^k cycles, so any zoom level of an overview is a direct lookup.
+class CycleStatus {
+public:
+	// notes holds the letter of each field's note, or 0 where it has none
+	void Rebuild(std::vector<int8_t> actions, std::vector<char> notes, std::vector<int> sceneChanges, const std::vector<int>& noMatchFrames, const std::vector<int>& extraAttributeFrames);
+	void Clear();
+
+	void SetAction(int field, int action);
+	void SetActions(int firstField, const std::vector<int8_t>& actions);
+	void SetNote(int field, char note);
+	void SetNotes(int firstField, const std::vector<char>& notes);
+	void SetSceneChanges(std::vector<int> sceneChanges);
+	void SetNoMatchOverride(int frame, bool overridden);
+	void SetExtraAttributes(int frame, bool present);
+
+	int GetCycleCount() const { return m_Levels.empty() ? 0 : (int)m_Levels[0].size(); }
+	int GetLevelCount() const { return (int)m_Levels.size(); }
+	uint8_t GetFlags(int cycle) const { return m_Levels[0][cycle]; }
+	// Flags of cycles [index << level, (index + 1) << level)
+	uint8_t GetFlags(int level, int index) const { return m_Levels[level][index]; }
+	// First cycle in [begin, end) with any of the flags in mask, or -1
+	int FindFirst(int begin, int end, uint8_t mask) const;
+	// Last cycle in [begin, end) with any of the flags in mask, or -1
+	int FindLast(int begin, int end, uint8_t mask) const;
+	// Bytes held by the actions, scenes and flag pyramid
+	size_t GetMemoryBytes() const;
+private:
+	int SceneIndex(int field) const;
+	int SceneEnd(int scene) const;
+	int ReferenceCycle(int scene) const;
+	uint8_t ComputeFlags(int cycle) const;
+	// Refreshes every cycle whose output or scene pattern depends on fields [firstField, lastField]
+	void RefreshFields(int firstField, int lastField);
+	void RefreshCycles(int firstCycle, int lastCycle);
+	void SetFrameBit(std::vector<uint8_t>& frames, int frame, bool set);
+
+	std::vector<int8_t> m_Actions;
+	std::vector<char> m_Notes;
+	// Sorted, always starting with 0
+	std::vector<int> m_SceneStarts;
+	// Bit per output frame of the cycle with a no match override
+	std::vector<uint8_t> m_NoMatchFrames;
+	// Bit per output frame of the cycle with extra attributes
+	std::vector<uint8_t> m_ExtraAttributeFrames;
+	std::vector<std::vector<uint8_t>> m_Levels;
+};
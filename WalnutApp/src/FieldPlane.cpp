@@ -0,0 +1,16 @@
+#include "FieldPlane.h"
+
+FieldPlane LumaPlane(const VSAPI* vsapi, const VSFrame* frame) {
+	const VSVideoFormat* format = vsapi->getVideoFrameFormat(frame);
+	FieldPlane field;
+	if (format->sampleType != stInteger) {
+		return field;
+	}
+	const int plane = format->colorFamily == cfRGB ? 1 : 0;
+	field.data = vsapi->getReadPtr(frame, plane);
+	field.stride = vsapi->getStride(frame, plane);
+	field.width = vsapi->getFrameWidth(frame, plane);
+	field.height = vsapi->getFrameHeight(frame, plane);
+	field.bitsPerSample = format->bitsPerSample;
+	return field;
+}
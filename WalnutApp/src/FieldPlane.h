@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "vapoursynth/VapourSynth4.h"
+
+// One plane of a single field, as returned by getReadPtr/getStride on a SeparateFields clip
+struct FieldPlane {
+	const uint8_t* data = nullptr;
+	ptrdiff_t stride = 0;
+	int width = 0;
+	int height = 0;
+	int bitsPerSample = 8;
+};
+
+// Luma plane of an integer format frame (green for RGB, which has no luma), or an empty plane for float formats
+FieldPlane LumaPlane(const VSAPI* vsapi, const VSFrame* frame);
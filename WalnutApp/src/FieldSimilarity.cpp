@@ -0,0 +1,121 @@
+#include "FieldSimilarity.h"
+#include "Simd.h"
+
+#include <cstdlib>
+
+namespace {
+
+template <typename T>
+void CompareRowScalar(const T* a, const T* b, int start, int width, FieldDifference& total) {
+	for (int x = start; x < width; x++) {
+		const uint64_t d = (uint64_t)std::abs((int)a[x] - (int)b[x]);
+		total.sad += d;
+		total.ssd += d * d;
+	}
+}
+
+uint64_t HorizontalSum(__m128i v) {
+	return (uint64_t)_mm_cvtsi128_si64(v) + (uint64_t)_mm_cvtsi128_si64(_mm_unpackhi_epi64(v, v));
+}
+
+void CompareRowSSE2(const uint8_t* a, const uint8_t* b, int width, FieldDifference& total) {
+	const __m128i zero = _mm_setzero_si128();
+	__m128i sad = zero;
+	// Each 32-bit lane gets two squares per 16 pixels, so a row would have to be ~33k pixels wide to overflow
+	__m128i ssd = zero;
+	const int vectorWidth = width & ~15;
+	for (int x = 0; x < vectorWidth; x += 16) {
+		const __m128i va = _mm_loadu_si128((const __m128i*)(a + x));
+		const __m128i vb = _mm_loadu_si128((const __m128i*)(b + x));
+		sad = _mm_add_epi64(sad, _mm_sad_epu8(va, vb));
+		const __m128i d = _mm_or_si128(_mm_subs_epu8(va, vb), _mm_subs_epu8(vb, va));
+		const __m128i lo = _mm_unpacklo_epi8(d, zero);
+		const __m128i hi = _mm_unpackhi_epi8(d, zero);
+		ssd = _mm_add_epi32(ssd, _mm_add_epi32(_mm_madd_epi16(lo, lo), _mm_madd_epi16(hi, hi)));
+	}
+	total.sad += HorizontalSum(sad);
+	total.ssd += HorizontalSum(_mm_add_epi64(_mm_unpacklo_epi32(ssd, zero), _mm_unpackhi_epi32(ssd, zero)));
+	CompareRowScalar(a, b, vectorWidth, width, total);
+}
+
+IVTCDN_TARGET_AVX2
+void CompareRowAVX2(const uint8_t* a, const uint8_t* b, int width, FieldDifference& total) {
+	const __m256i zero = _mm256_setzero_si256();
+	__m256i sad = zero;
+	__m256i ssd = zero;
+	const int vectorWidth = width & ~31;
+	for (int x = 0; x < vectorWidth; x += 32) {
+		const __m256i va = _mm256_loadu_si256((const __m256i*)(a + x));
+		const __m256i vb = _mm256_loadu_si256((const __m256i*)(b + x));
+		sad = _mm256_add_epi64(sad, _mm256_sad_epu8(va, vb));
+		const __m256i d = _mm256_or_si256(_mm256_subs_epu8(va, vb), _mm256_subs_epu8(vb, va));
+		const __m256i lo = _mm256_unpacklo_epi8(d, zero);
+		const __m256i hi = _mm256_unpackhi_epi8(d, zero);
+		ssd = _mm256_add_epi32(ssd, _mm256_add_epi32(_mm256_madd_epi16(lo, lo), _mm256_madd_epi16(hi, hi)));
+	}
+	const __m256i ssd64 = _mm256_add_epi64(_mm256_unpacklo_epi32(ssd, zero), _mm256_unpackhi_epi32(ssd, zero));
+	total.sad += HorizontalSum(_mm_add_epi64(_mm256_castsi256_si128(sad), _mm256_extracti128_si256(sad, 1)));
+	total.ssd += HorizontalSum(_mm_add_epi64(_mm256_castsi256_si128(ssd64), _mm256_extracti128_si256(ssd64, 1)));
+	CompareRowSSE2(a + vectorWidth, b + vectorWidth, width - vectorWidth, total);
+}
+
+void CompareRowSSE2(const uint16_t* a, const uint16_t* b, int width, FieldDifference& total) {
+	const __m128i zero = _mm_setzero_si128();
+	__m128i sad = zero;
+	__m128i ssd = zero;
+	const int vectorWidth = width & ~7;
+	for (int x = 0; x < vectorWidth; x += 8) {
+		const __m128i va = _mm_loadu_si128((const __m128i*)(a + x));
+		const __m128i vb = _mm_loadu_si128((const __m128i*)(b + x));
+		const __m128i d = _mm_or_si128(_mm_subs_epu16(va, vb), _mm_subs_epu16(vb, va));
+		const __m128i lo = _mm_unpacklo_epi16(d, zero);
+		const __m128i hi = _mm_unpackhi_epi16(d, zero);
+		const __m128i d32 = _mm_add_epi32(lo, hi);
+		sad = _mm_add_epi64(sad, _mm_add_epi64(_mm_unpacklo_epi32(d32, zero), _mm_unpackhi_epi32(d32, zero)));
+		// Differences can be up to 16 bits, so square them as 64-bit products of the even and odd 32-bit lanes
+		ssd = _mm_add_epi64(ssd, _mm_mul_epu32(lo, lo));
+		ssd = _mm_add_epi64(ssd, _mm_mul_epu32(_mm_srli_epi64(lo, 32), _mm_srli_epi64(lo, 32)));
+		ssd = _mm_add_epi64(ssd, _mm_mul_epu32(hi, hi));
+		ssd = _mm_add_epi64(ssd, _mm_mul_epu32(_mm_srli_epi64(hi, 32), _mm_srli_epi64(hi, 32)));
+	}
+	total.sad += HorizontalSum(sad);
+	total.ssd += HorizontalSum(ssd);
+	CompareRowScalar(a, b, vectorWidth, width, total);
+}
+
+template <typename T>
+FieldDifference CompareFieldsImpl(const FieldPlane& a, const FieldPlane& b, Simd::Level level) {
+	FieldDifference total;
+	for (int y = 0; y < a.height; y++) {
+		const T* rowA = (const T*)(a.data + y * a.stride);
+		const T* rowB = (const T*)(b.data + y * b.stride);
+		if constexpr (sizeof(T) == 1) {
+			if (level == Simd::Level::AVX2) {
+				CompareRowAVX2(rowA, rowB, a.width, total);
+			} else if (level == Simd::Level::SSE2) {
+				CompareRowSSE2(rowA, rowB, a.width, total);
+			} else {
+				CompareRowScalar(rowA, rowB, 0, a.width, total);
+			}
+		} else {
+			if (level != Simd::Level::Scalar) {
+				CompareRowSSE2(rowA, rowB, a.width, total);
+			} else {
+				CompareRowScalar(rowA, rowB, 0, a.width, total);
+			}
+		}
+	}
+	return total;
+}
+
+}
+
+FieldDifference CompareFields(const FieldPlane& a, const FieldPlane& b) {
+	if (!a.data || !b.data || a.width != b.width || a.height != b.height) {
+		return {};
+	}
+	if (a.bitsPerSample <= 8) {
+		return CompareFieldsImpl<uint8_t>(a, b, Simd::ActiveLevel());
+	}
+	return CompareFieldsImpl<uint16_t>(a, b, Simd::ActiveLevel());
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+#include "FieldPlane.h"
+
+// Total absolute and squared differences between two planes of the same size and bit depth
+struct FieldDifference {
+	uint64_t sad = 0;
+	uint64_t ssd = 0;
+};
+
+FieldDifference CompareFields(const FieldPlane& a, const FieldPlane& b);
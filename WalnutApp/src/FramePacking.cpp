@@ -0,0 +1,54 @@
+#include "FramePacking.h"
+#include "Walnut/JobSystem.h"
+
+#include <algorithm>
+#include <thread>
+
+// Below this many rows per band the per-task overhead stops paying for itself
+static const unsigned MIN_ROWS_PER_BAND = 64;
+
+static bool HasSubsampledRows(const enum p2p_packing packing) {
+	return packing >= p2p_nv12_be && packing <= p2p_p016;
+}
+
+void PackFrameParallel(const p2p_buffer_param& param, const unsigned long flags) {
+	const unsigned maxBands = param.height / MIN_ROWS_PER_BAND;
+	const bool singleCore = std::thread::hardware_concurrency() < 2;
+	if ((size_t)param.width * param.height < PARALLEL_PACK_MIN_PIXELS || maxBands < 2 || singleCore || HasSubsampledRows(param.packing)) {
+		p2p_pack_frame(&param, flags);
+		return;
+	}
+
+	// Interactive so packing never queues behind background jobs. The calling thread works through bands too.
+	const unsigned bands = std::min(maxBands, Walnut::JobSystem::GetWorkerCount() + 1);
+	const int rowsPerBand = (int)((param.height + bands - 1) / bands);
+	Walnut::JobSystem::ParallelFor(Walnut::JobPriority::Interactive, 0, (int)param.height, rowsPerBand, [&param, flags](int begin, int end) {
+		p2p_buffer_param band = param;
+		band.height = end - begin;
+		for (int plane = 0; plane < 4; plane++) {
+			if (band.src[plane]) {
+				band.src[plane] = (const uint8_t*)band.src[plane] + band.src_stride[plane] * begin;
+			}
+			if (band.dst[plane]) {
+				band.dst[plane] = (uint8_t*)band.dst[plane] + band.dst_stride[plane] * begin;
+			}
+		}
+		p2p_pack_frame(&band, flags);
+	});
+}
+
+void PackRGBA32(const VSAPI* vsapi, const VSFrame* frame, uint8_t* dst, const ptrdiff_t dstStride) {
+	const int width = vsapi->getFrameWidth(frame, 0);
+	const int height = vsapi->getFrameHeight(frame, 0);
+	p2p_buffer_param p = {};
+	p.packing = p2p_rgba32_be;
+	p.width = width;
+	p.height = height;
+	p.dst[0] = dst;
+	p.dst_stride[0] = dstStride ? dstStride : (ptrdiff_t)width * 4;
+	for (int plane = 0; plane < 3; plane++) {
+		p.src[plane] = vsapi->getReadPtr(frame, plane);
+		p.src_stride[plane] = vsapi->getStride(frame, plane);
+	}
+	PackFrameParallel(p, P2P_ALPHA_SET_ONE);
+}
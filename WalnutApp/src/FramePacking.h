@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "p2p_api.h"
+#include "vapoursynth/VapourSynth4.h"
+
+// Frames with fewer pixels than this are packed on the calling thread, below it waking the pool costs more than it saves
+static const unsigned PARALLEL_PACK_MIN_PIXELS = 1280 * 720;
+
+// p2p_pack_frame, split into bands of rows packed on a shared pool (with the calling thread helping) when the frame is
+// large enough. Packings with vertically subsampled chroma (NV12, P010, P016) are always packed on the calling thread.
+void PackFrameParallel(const p2p_buffer_param& param, unsigned long flags);
+
+// Interleaves a planar RGB24 frame into the RGBA32 layout Walnut images are uploaded from, with opaque alpha.
+// dst must hold height rows of dstStride bytes, a dstStride of 0 meaning rows of exactly width * 4 bytes.
+void PackRGBA32(const VSAPI* vsapi, const VSFrame* frame, uint8_t* dst, ptrdiff_t dstStride = 0);
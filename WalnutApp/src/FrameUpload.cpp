@@ -0,0 +1,206 @@
+#include "FrameUpload.h"
+#include "FramePacking.h"
+#include "ScriptGraph.h"
+#include "vapoursynth/VSConstants4.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+Walnut::ImageFormat ImageFormatFor(const VSVideoFormat& format) {
+	if (!ScriptGraph::IsUploadableYUV(format)) {
+		return Walnut::ImageFormat::RGBA;
+	}
+	const bool wide = format.bytesPerSample == 2;
+	if (format.subSamplingH == 1) {
+		return wide ? Walnut::ImageFormat::YUV420P16 : Walnut::ImageFormat::YUV420P8;
+	} else if (format.subSamplingW == 1) {
+		return wide ? Walnut::ImageFormat::YUV422P16 : Walnut::ImageFormat::YUV422P8;
+	}
+	return wide ? Walnut::ImageFormat::YUV444P16 : Walnut::ImageFormat::YUV444P8;
+}
+
+static Walnut::YUVColorimetry ColorimetryFor(const VSAPI* vsapi, const VSFrame* frame) {
+	Walnut::YUVColorimetry colorimetry;
+	colorimetry.BitDepth = vsapi->getVideoFrameFormat(frame)->bitsPerSample;
+
+	const VSMap* props = vsapi->getFramePropertiesRO(frame);
+	int err = 0;
+	const int64_t matrix = vsapi->mapGetInt(props, "_Matrix", 0, &err);
+	if (!err && matrix == VSC_MATRIX_BT709) {
+		colorimetry.Matrix = Walnut::YUVMatrix::BT709;
+	} else if (!err && matrix == VSC_MATRIX_BT2020_NCL) {
+		colorimetry.Matrix = Walnut::YUVMatrix::BT2020;
+	}
+	// The property is 0 for full range whichever API version's VSColorRange is in use
+	const int64_t range = vsapi->mapGetInt(props, "_ColorRange", 0, &err);
+	colorimetry.FullRange = !err && range == 0;
+	return colorimetry;
+}
+
+void UploadFrame(Walnut::Image& image, const VSAPI* vsapi, const VSFrame* frame) {
+	if (ImageFormatFor(*vsapi->getVideoFrameFormat(frame)) == Walnut::ImageFormat::RGBA) {
+		std::vector<uint8_t> imageBuffer((size_t)image.GetWidth() * image.GetHeight() * 4);
+		PackRGBA32(vsapi, frame, imageBuffer.data());
+		image.SetData(imageBuffer.data());
+		return;
+	}
+
+	// Planes go up exactly as VapourSynth holds them, 1.5 bytes a pixel for 8 bit 4:2:0 against 4 for packed RGBA
+	const void* planes[3];
+	size_t strides[3];
+	for (int plane = 0; plane < 3; plane++) {
+		planes[plane] = vsapi->getReadPtr(frame, plane);
+		strides[plane] = (size_t)vsapi->getStride(frame, plane);
+	}
+	image.SetPlanes(planes, strides, ColorimetryFor(vsapi, frame));
+}
+
+size_t UploadFrameBytes(const VSAPI* vsapi, const VSFrame* frame) {
+	const VSVideoFormat* format = vsapi->getVideoFrameFormat(frame);
+	if (ImageFormatFor(*format) == Walnut::ImageFormat::RGBA) {
+		return (size_t)vsapi->getFrameWidth(frame, 0) * vsapi->getFrameHeight(frame, 0) * 4;
+	}
+	size_t bytes = 0;
+	for (int plane = 0; plane < 3; plane++) {
+		bytes += (size_t)vsapi->getFrameWidth(frame, plane) * vsapi->getFrameHeight(frame, plane) * format->bytesPerSample;
+	}
+	return bytes;
+}
+
+// Reference conversion straight from the matrix and range definitions, rounded to 8 bit RGB
+static void ReferenceRGB(const Walnut::YUVColorimetry& colorimetry, const int y, const int u, const int v, uint8_t rgb[3]) {
+	double kr = 0.299, kb = 0.114;
+	if (colorimetry.Matrix == Walnut::YUVMatrix::BT709) {
+		kr = 0.2126;
+		kb = 0.0722;
+	} else if (colorimetry.Matrix == Walnut::YUVMatrix::BT2020) {
+		kr = 0.2627;
+		kb = 0.0593;
+	}
+	const double kg = 1.0 - kr - kb;
+
+	const int shift = (int)colorimetry.BitDepth - 8;
+	const double max = (double)((1 << colorimetry.BitDepth) - 1);
+	double luma, cb, cr;
+	if (colorimetry.FullRange) {
+		luma = y / max;
+		cb = (u - (1 << (colorimetry.BitDepth - 1))) / max;
+		cr = (v - (1 << (colorimetry.BitDepth - 1))) / max;
+	} else {
+		luma = (y - (16 << shift)) / (double)(219 << shift);
+		cb = (u - (128 << shift)) / (double)(224 << shift);
+		cr = (v - (128 << shift)) / (double)(224 << shift);
+	}
+	const double values[3] = {
+		luma + 2.0 * (1.0 - kr) * cr,
+		luma - 2.0 * kb * (1.0 - kb) / kg * cb - 2.0 * kr * (1.0 - kr) / kg * cr,
+		luma + 2.0 * (1.0 - kb) * cb,
+	};
+	for (int i = 0; i < 3; i++) {
+		rgb[i] = (uint8_t)std::lround(std::clamp(values[i], 0.0, 1.0) * 255.0);
+	}
+}
+
+int CheckYUVConversion() {
+	struct Format {
+		Walnut::ImageFormat format;
+		const char* name;
+		int shiftW, shiftH;
+		std::vector<int> bitDepths;
+	};
+	const Format formats[] = {
+		{Walnut::ImageFormat::YUV420P8, "YUV420P8", 1, 1, {8}},
+		{Walnut::ImageFormat::YUV422P8, "YUV422P8", 1, 0, {8}},
+		{Walnut::ImageFormat::YUV444P8, "YUV444P8", 0, 0, {8}},
+		{Walnut::ImageFormat::YUV420P16, "YUV420P16", 1, 1, {10, 16}},
+		{Walnut::ImageFormat::YUV422P16, "YUV422P16", 1, 0, {10, 16}},
+		{Walnut::ImageFormat::YUV444P16, "YUV444P16", 0, 0, {10, 16}},
+	};
+	const Walnut::YUVMatrix matrices[] = {Walnut::YUVMatrix::BT601, Walnut::YUVMatrix::BT709, Walnut::YUVMatrix::BT2020};
+	// GPU arithmetic is single precision and may round the other way at .5
+	const int tolerance = 1;
+
+	// Luma ramps along each row, chroma is constant within bands of BAND rows. Only rows in the middle of a band are
+	// compared, since subsampled chroma is interpolated across band edges.
+	const int WIDTH = 64;
+	const int BAND = 8;
+	const int CHROMA_STEPS = 3;
+	const int HEIGHT = BAND * CHROMA_STEPS * CHROMA_STEPS;
+
+	bool passed = true;
+	for (const Format& format : formats) {
+		if (!Walnut::Image::IsSupported(format.format)) {
+			printf("%-10s unsupported, skipped\n", format.name);
+			continue;
+		}
+		const size_t sampleSize = format.bitDepths.back() > 8 ? 2 : 1;
+		const int widths[3] = {WIDTH, WIDTH >> format.shiftW, WIDTH >> format.shiftW};
+		const int heights[3] = {HEIGHT, HEIGHT >> format.shiftH, HEIGHT >> format.shiftH};
+		for (const int bitDepth : format.bitDepths) {
+			const int max = (1 << bitDepth) - 1;
+			auto sampleAt = [max](const int step, const int steps) { return (max * (1 + 3 * step)) / (3 * steps - 1); };
+
+			std::vector<std::vector<uint8_t>> planes(3);
+			for (int plane = 0; plane < 3; plane++) {
+				planes[plane].resize((size_t)widths[plane] * heights[plane] * sampleSize);
+				for (int y = 0; y < heights[plane]; y++) {
+					const int band = (y << (plane ? format.shiftH : 0)) / BAND;
+					for (int x = 0; x < widths[plane]; x++) {
+						int value;
+						if (plane == 0) {
+							value = x * max / (WIDTH - 1);
+						} else {
+							value = sampleAt(plane == 1 ? band % CHROMA_STEPS : band / CHROMA_STEPS, CHROMA_STEPS);
+						}
+						const size_t index = (size_t)y * widths[plane] + x;
+						if (sampleSize == 2) {
+							((uint16_t*)planes[plane].data())[index] = (uint16_t)value;
+						} else {
+							planes[plane][index] = (uint8_t)value;
+						}
+					}
+				}
+			}
+			const void* data[3] = {planes[0].data(), planes[1].data(), planes[2].data()};
+			const size_t strides[3] = {widths[0] * sampleSize, widths[1] * sampleSize, widths[2] * sampleSize};
+
+			int worst = 0;
+			Walnut::Image image(WIDTH, HEIGHT, format.format);
+			std::vector<uint8_t> rgba((size_t)WIDTH * HEIGHT * 4);
+			for (const Walnut::YUVMatrix matrix : matrices) {
+				for (const bool fullRange : {false, true}) {
+					Walnut::YUVColorimetry colorimetry;
+					colorimetry.Matrix = matrix;
+					colorimetry.FullRange = fullRange;
+					colorimetry.BitDepth = bitDepth;
+					image.SetPlanes(data, strides, colorimetry);
+					image.ReadPixels(rgba.data());
+
+					for (int y = 0; y < HEIGHT; y++) {
+						if (y % BAND < 2 || y % BAND >= BAND - 2) {
+							continue;
+						}
+						const int band = y / BAND;
+						const int u = sampleAt(band % CHROMA_STEPS, CHROMA_STEPS);
+						const int v = sampleAt(band / CHROMA_STEPS, CHROMA_STEPS);
+						for (int x = 0; x < WIDTH; x++) {
+							uint8_t expected[3];
+							ReferenceRGB(colorimetry, x * max / (WIDTH - 1), u, v, expected);
+							const uint8_t* actual = &rgba[((size_t)y * WIDTH + x) * 4];
+							for (int c = 0; c < 3; c++) {
+								worst = std::max(worst, std::abs(actual[c] - expected[c]));
+							}
+						}
+					}
+				}
+			}
+			printf("%-10s %2d bit: largest difference %d\n", format.name, bitDepth, worst);
+			passed &= worst <= tolerance;
+		}
+	}
+	puts(passed ? "GPU and CPU conversions agree" : "GPU and CPU conversions differ");
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include "Walnut/Image.h"
+#include "vapoursynth/VapourSynth4.h"
+
+// The format to create images in for frames of this format: planar YUV the GPU converts when the frame is one of
+// ScriptGraph::IsUploadableYUV(), otherwise RGBA packed from RGB24 on the CPU
+Walnut::ImageFormat ImageFormatFor(const VSVideoFormat& format);
+
+// Uploads a frame to an image created with ImageFormatFor() its format. YUV frames are read according to their
+// _Matrix and _ColorRange, falling back to BT.601 limited range like the RGB conversions in ScriptGraph.
+void UploadFrame(Walnut::Image& image, const VSAPI* vsapi, const VSFrame* frame);
+
+// Bytes UploadFrame() sends to the GPU for the frame: packed RGBA, or its planes as they are
+size_t UploadFrameBytes(const VSAPI* vsapi, const VSFrame* frame);
+
+// Converts test patterns of every YUV format the device supports on the GPU, reads them back and compares them with
+// the same conversion done on the CPU, printing the largest difference of each. Returns 0 if they all agree to within
+// rounding, 1 otherwise. Needs the application's Vulkan device.
+int CheckYUVConversion();
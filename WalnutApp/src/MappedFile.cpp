@@ -0,0 +1,122 @@
+#include "MappedFile.h"
+
+#include <cstdio>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile() {
+	Close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::Open(const std::string& path, size_t size) {
+	Close();
+	m_File = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (m_File == INVALID_HANDLE_VALUE) {
+		m_File = nullptr;
+		fprintf(stderr, "Failed to open %s\n", path.c_str());
+		return false;
+	}
+	// Mapping with an explicit size grows the file, but never shrinks it
+	LARGE_INTEGER current;
+	if (GetFileSizeEx(m_File, &current) && (uint64_t)current.QuadPart > size) {
+		LARGE_INTEGER target;
+		target.QuadPart = size;
+		SetFilePointerEx(m_File, target, nullptr, FILE_BEGIN);
+		SetEndOfFile(m_File);
+	}
+	m_Mapping = CreateFileMappingA(m_File, nullptr, PAGE_READWRITE, (DWORD)((uint64_t)size >> 32), (DWORD)(size & 0xFFFFFFFF), nullptr);
+	if (!m_Mapping) {
+		fprintf(stderr, "Failed to map %s\n", path.c_str());
+		Close();
+		return false;
+	}
+	m_Data = (uint8_t*)MapViewOfFile(m_Mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+	if (!m_Data) {
+		fprintf(stderr, "Failed to map %s\n", path.c_str());
+		Close();
+		return false;
+	}
+	m_Size = size;
+	return true;
+}
+
+void MappedFile::Close() {
+	if (m_Data) {
+		UnmapViewOfFile(m_Data);
+		m_Data = nullptr;
+	}
+	if (m_Mapping) {
+		CloseHandle(m_Mapping);
+		m_Mapping = nullptr;
+	}
+	if (m_File) {
+		CloseHandle(m_File);
+		m_File = nullptr;
+	}
+	m_Size = 0;
+}
+
+void MappedFile::Flush() {
+	if (m_Data) {
+		FlushViewOfFile(m_Data, m_Size);
+	}
+}
+
+#else
+
+bool MappedFile::Open(const std::string& path, size_t size) {
+	Close();
+	m_File = open(path.c_str(), O_RDWR | O_CREAT, 0644);
+	if (m_File < 0) {
+		perror(path.c_str());
+		return false;
+	}
+	struct stat info;
+	if (fstat(m_File, &info) != 0 || (size_t)info.st_size != size) {
+		// Sparse on most filesystems, so thumbnails which were never generated cost no disk space
+		if (ftruncate(m_File, (off_t)size) != 0) {
+			perror(path.c_str());
+			Close();
+			return false;
+		}
+	}
+	void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, m_File, 0);
+	if (data == MAP_FAILED) {
+		perror(path.c_str());
+		Close();
+		return false;
+	}
+	m_Data = (uint8_t*)data;
+	m_Size = size;
+	return true;
+}
+
+void MappedFile::Close() {
+	if (m_Data) {
+		munmap(m_Data, m_Size);
+		m_Data = nullptr;
+	}
+	if (m_File >= 0) {
+		close(m_File);
+		m_File = -1;
+	}
+	m_Size = 0;
+}
+
+void MappedFile::Flush() {
+	if (m_Data) {
+		msync(m_Data, m_Size, MS_ASYNC);
+	}
+}
+
+#endif
@@ -0,0 +1,118 @@
+#include "MatchMetrics.h"
+#include "CombMetric.h"
+
+#include <cstdio>
+#include <map>
+
+MatchMetricLoader::State::~State() {
+	if (node) {
+		vsapi->freeNode(node);
+	}
+}
+
+MatchMetricLoader::~MatchMetricLoader() {
+	if (m_State) {
+		m_State->progress->cancelled = true;
+	}
+}
+
+void MatchMetricLoader::Open(const VSAPI* vsapi, VSNode* fieldsNode) {
+	if (m_State) {
+		m_State->progress->cancelled = true;
+	}
+	auto state = std::make_shared<State>();
+	state->vsapi = vsapi;
+	state->node = vsapi->addNodeRef(fieldsNode);
+	m_State = state;
+	m_InFlight.clear();
+	m_Generation++;
+}
+
+void MatchMetricLoader::CancelAndWait(WorkerPool& pool) {
+	std::shared_ptr<State> state = m_State;
+	if (!state) {
+		return;
+	}
+	state->progress->cancelled = true;
+	m_State = nullptr;
+	m_InFlight.clear();
+	pool.Wait(state->progress);
+	// Finished tasks may still hold the state, so the node is released here rather than by whichever lets go last
+	state->vsapi->freeNode(state->node);
+	state->node = nullptr;
+}
+
+void MatchMetricLoader::Invalidate() {
+	m_InFlight.clear();
+	m_Generation++;
+}
+
+void MatchMetricLoader::Request(const std::vector<MatchRequest>& requests, WorkerPool& pool) {
+	if (!m_State) {
+		return;
+	}
+	std::vector<MatchRequest> queued;
+	for (const MatchRequest& request : requests) {
+		if (m_InFlight.insert(MatchMetricKey(request.field, request.partner)).second) {
+			queued.push_back(request);
+		}
+	}
+	if (queued.empty()) {
+		return;
+	}
+
+	const int count = (int)queued.size();
+	pool.ParallelFor(0, count, count, m_State->progress, [state = m_State, queued = std::move(queued), generation = m_Generation](int begin, int end) {
+		char error_message[1024];
+		std::map<int, const VSFrame*> frames;
+		auto getField = [&](const int n) -> const VSFrame* {
+			auto it = frames.find(n);
+			if (it != frames.end()) {
+				return it->second;
+			}
+			const VSFrame* frame = state->vsapi->getFrame(n, state->node, error_message, sizeof(error_message));
+			if (!frame) {
+				fprintf(stderr, "%s\n", error_message);
+			}
+			frames[n] = frame;
+			return frame;
+		};
+
+		for (int i = begin; i < end && !state->progress->cancelled; i++) {
+			const MatchRequest& request = queued[i];
+			const VSFrame* fieldFrame = getField(request.field);
+			const VSFrame* partnerFrame = getField(request.partner);
+			int metric = -1;
+			if (fieldFrame && partnerFrame) {
+				metric = CombMetric(
+					LumaPlane(state->vsapi, request.fieldIsTop ? fieldFrame : partnerFrame),
+					LumaPlane(state->vsapi, request.fieldIsTop ? partnerFrame : fieldFrame));
+			}
+			std::lock_guard<std::mutex> lock(state->mutex);
+			state->results.emplace_back(MatchMetricKey(request.field, request.partner), metric, generation);
+			state->progress->completed++;
+		}
+		for (auto& [n, frame] : frames) {
+			if (frame) {
+				state->vsapi->freeFrame(frame);
+			}
+		}
+	});
+}
+
+void MatchMetricLoader::Collect(std::unordered_map<uint64_t, int>& cache) {
+	if (!m_State) {
+		return;
+	}
+	std::vector<std::tuple<uint64_t, int, uint64_t>> results;
+	{
+		std::lock_guard<std::mutex> lock(m_State->mutex);
+		results.swap(m_State->results);
+	}
+	for (const auto& [key, metric, generation] : results) {
+		if (generation == m_Generation) {
+			cache[key] = metric;
+			m_InFlight.erase(key);
+		}
+	}
+}
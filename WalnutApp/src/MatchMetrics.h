@@ -0,0 +1,60 @@
+#pragma once
+
+#include "WorkerPool.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "vapoursynth/VapourSynth4.h"
+
+// Order independent key for the pair of fields a metric weaves
+inline uint64_t MatchMetricKey(const int a, const int b) {
+	return ((uint64_t)std::min(a, b) << 32) | (uint32_t)std::max(a, b);
+}
+
+struct MatchRequest {
+	int field = 0;
+	int partner = 0;
+	bool fieldIsTop = true;
+};
+
+// Computes comb metrics of candidate field matches on a worker pool, so fetching the fields never blocks the UI. Each
+// Request is one task, fetching the fields its matches share once.
+class MatchMetricLoader {
+public:
+	~MatchMetricLoader();
+
+	// Takes its own reference to fieldsNode, which must be a SeparateFields clip in the native format
+	void Open(const VSAPI* vsapi, VSNode* fieldsNode);
+	// Blocks until tasks already running have finished and releases the node, which must happen before its core is freed
+	void CancelAndWait(WorkerPool& pool);
+	// Results of requests made before this are dropped, for when what they'd be stored under has changed meaning
+	void Invalidate();
+
+	// Queues the requests which aren't already in flight
+	void Request(const std::vector<MatchRequest>& requests, WorkerPool& pool);
+	bool IsInFlight(uint64_t key) const { return m_InFlight.contains(key); }
+	// Moves metrics finished since the last call into cache, -1 where a field couldn't be fetched
+	void Collect(std::unordered_map<uint64_t, int>& cache);
+private:
+	struct State {
+		const VSAPI* vsapi = nullptr;
+		VSNode* node = nullptr;
+		std::shared_ptr<JobProgress> progress = std::make_shared<JobProgress>();
+		std::mutex mutex;
+		// Key, metric and the generation the request was made in
+		std::vector<std::tuple<uint64_t, int, uint64_t>> results;
+
+		~State();
+	};
+
+	std::shared_ptr<State> m_State;
+	std::unordered_set<uint64_t> m_InFlight;
+	uint64_t m_Generation = 0;
+};
@@ -0,0 +1,200 @@
+#include "NoteAnalysis.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <map>
+
+// Fields fetched sequentially by one task, large enough that refetching field n - 2 at chunk starts is negligible
+static const int ANALYSIS_CHUNK_SIZE = 500;
+
+// The best duplicate position must score below this fraction of the runner-up to be trusted
+static const float DUPLICATE_CONFIDENCE = 0.5f;
+
+NoteAnalyser::State::~State() {
+	if (node) {
+		vsapi->freeNode(node);
+	}
+}
+
+NoteAnalyser::~NoteAnalyser() {
+	Cancel();
+}
+
+void NoteAnalyser::Start(const VSAPI* vsapi, VSNode* fieldsNode, WorkerPool& pool) {
+	Cancel();
+	auto state = std::make_shared<State>();
+	state->vsapi = vsapi;
+	state->node = vsapi->addNodeRef(fieldsNode);
+	const VSVideoInfo* vi = vsapi->getVideoInfo(fieldsNode);
+	state->fieldCount = vi->numFrames;
+	state->pixelsPerField = (uint64_t)vi->width * vi->height;
+	state->bitsPerSample = vi->format.bitsPerSample;
+	state->differences.resize(state->fieldCount);
+	state->valid.resize(state->fieldCount);
+	m_State = state;
+
+	pool.ParallelFor(0, state->fieldCount, ANALYSIS_CHUNK_SIZE, state->progress, [state](int begin, int end) {
+		char error_message[1024];
+		// Sliding window of the last two fields so every field is only fetched once per chunk
+		std::map<int, const VSFrame*> frames;
+		for (int n = std::max(0, begin - 2); n < end && !state->progress->cancelled; n++) {
+			const VSFrame* frame = state->vsapi->getFrame(n, state->node, error_message, sizeof(error_message));
+			if (!frame) {
+				fprintf(stderr, "%s\n", error_message);
+			}
+			frames[n] = frame;
+			auto previous = frames.find(n - 2);
+			if (n >= begin && frame && previous != frames.end() && previous->second) {
+				// Only worker for this chunk writes these indices
+				state->differences[n] = CompareFields(LumaPlane(state->vsapi, previous->second), LumaPlane(state->vsapi, frame));
+				state->valid[n] = true;
+			}
+			if (previous != frames.end()) {
+				if (previous->second) {
+					state->vsapi->freeFrame(previous->second);
+				}
+				frames.erase(previous);
+			}
+			if (n >= begin) {
+				state->progress->completed++;
+			}
+		}
+		for (auto& [n, frame] : frames) {
+			if (frame) {
+				state->vsapi->freeFrame(frame);
+			}
+		}
+	});
+}
+
+void NoteAnalyser::Cancel() {
+	if (m_State) {
+		m_State->progress->cancelled = true;
+		m_State = nullptr;
+	}
+}
+
+void NoteAnalyser::CancelAndWait(WorkerPool& pool) {
+	std::shared_ptr<State> state = m_State;
+	if (!state) {
+		return;
+	}
+	Cancel();
+	pool.Wait(state->progress);
+	// Finished chunks may still hold the state, so the node is released here rather than by whichever lets go last
+	state->vsapi->freeNode(state->node);
+	state->node = nullptr;
+}
+
+float NoteAnalyser::MeanAbsoluteDifference(int field) const {
+	if (!HasResults() || field < 0 || field >= m_State->fieldCount || !m_State->valid[field]) {
+		return -1.0f;
+	}
+	const float scale = (float)(1 << (m_State->bitsPerSample - 8));
+	return (float)((double)m_State->differences[field].sad / m_State->pixelsPerField) / scale;
+}
+
+float NoteAnalyser::MeanSquaredDifference(int field) const {
+	if (!HasResults() || field < 0 || field >= m_State->fieldCount || !m_State->valid[field]) {
+		return -1.0f;
+	}
+	const float scale = (float)(1 << (m_State->bitsPerSample - 8));
+	return (float)((double)m_State->differences[field].ssd / m_State->pixelsPerField) / (scale * scale);
+}
+
+int NoteAnalyser::DuplicatePosition(int cycle) const {
+	float scores[5];
+	for (int position = 0; position < 5; position++) {
+		const float first = MeanSquaredDifference(cycle * 10 + position);
+		const float second = MeanSquaredDifference(cycle * 10 + position + 5);
+		if (first < 0 || second < 0) {
+			return -1;
+		}
+		scores[position] = first + second;
+	}
+	const int best = (int)(std::min_element(scores, scores + 5) - scores);
+	float runnerUp = -1;
+	for (int position = 0; position < 5; position++) {
+		if (position != best && (runnerUp < 0 || scores[position] < runnerUp)) {
+			runnerUp = scores[position];
+		}
+	}
+	return scores[best] < runnerUp * DUPLICATE_CONFIDENCE ? best : -1;
+}
+
+std::vector<char> NoteAnalyser::SuggestNotes(const std::vector<int>& sceneChanges) const {
+	std::vector<char> suggestions;
+	if (!HasResults()) {
+		return suggestions;
+	}
+	const int fieldCount = m_State->fieldCount;
+	suggestions.resize(fieldCount, 0);
+
+	const int cycleCount = (fieldCount + 9) / 10;
+	std::vector<int> duplicatePositions(cycleCount);
+	for (int cycle = 0; cycle < cycleCount; cycle++) {
+		duplicatePositions[cycle] = DuplicatePosition(cycle);
+	}
+
+	std::vector<int> boundaries = sceneChanges;
+	boundaries.push_back(0);
+	boundaries.push_back(fieldCount);
+	std::sort(boundaries.begin(), boundaries.end());
+	boundaries.erase(std::unique(boundaries.begin(), boundaries.end()), boundaries.end());
+
+	for (size_t scene = 0; scene + 1 < boundaries.size(); scene++) {
+		const int start = boundaries[scene];
+		const int end = std::min(boundaries[scene + 1], fieldCount);
+		if (start >= end) {
+			continue;
+		}
+		// Cycles without a clear duplicate (e.g. static shots) follow the most common pattern of the scene
+		int votes[5] = {};
+		for (int cycle = start / 10; cycle <= (end - 1) / 10; cycle++) {
+			if (duplicatePositions[cycle] >= 0) {
+				votes[duplicatePositions[cycle]]++;
+			}
+		}
+		const int dominant = (int)(std::max_element(votes, votes + 5) - votes);
+		const bool hasDominant = votes[dominant] > 0;
+
+		for (int field = start; field < end; field++) {
+			int position = duplicatePositions[field / 10];
+			if (position < 0) {
+				if (!hasDominant) {
+					continue;
+				}
+				position = dominant;
+			}
+			// Rotate NOTE_PATTERN so its duplicates (positions 4 and 9) land on position and position + 5
+			const int rotation = (position + 6) % 10;
+			suggestions[field] = NOTE_PATTERN[(field % 10 - rotation + 10) % 10];
+		}
+	}
+	return suggestions;
+}
+
+std::vector<SceneSuggestion> SummariseSuggestions(const std::vector<char>& suggestions, const std::vector<std::string>& notes, std::vector<int> sceneChanges) {
+	const int fieldCount = (int)suggestions.size();
+	sceneChanges.push_back(0);
+	sceneChanges.push_back(fieldCount);
+	std::sort(sceneChanges.begin(), sceneChanges.end());
+	sceneChanges.erase(std::unique(sceneChanges.begin(), sceneChanges.end()), sceneChanges.end());
+
+	std::vector<SceneSuggestion> scenes;
+	for (size_t i = 0; i + 1 < sceneChanges.size(); i++) {
+		SceneSuggestion scene;
+		scene.start = sceneChanges[i];
+		scene.end = std::min(sceneChanges[i + 1], fieldCount);
+		for (int field = scene.start; field < scene.end; field++) {
+			const char suggestion = suggestions[field];
+			if (suggestion && (field >= (int)notes.size() || notes[field].size() != 1 || notes[field][0] != suggestion)) {
+				scene.changedFields++;
+			}
+		}
+		if (scene.changedFields > 0) {
+			scenes.push_back(scene);
+		}
+	}
+	return scenes;
+}
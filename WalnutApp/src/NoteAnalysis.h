@@ -0,0 +1,65 @@
+#pragma once
+
+#include "FieldSimilarity.h"
+#include "WorkerPool.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+// Note pattern new projects are seeded with; the duplicated (third) fields of B and D are at positions 4 and 9
+static const char NOTE_PATTERN[10] = { 'A', 'A', 'B', 'B', 'B', 'C', 'C', 'D', 'D', 'D' };
+
+// A range of fields [start, end) between scene changes, with how many fields a suggestion would change
+struct SceneSuggestion {
+	int start = 0;
+	int end = 0;
+	int changedFields = 0;
+};
+
+// Compares every field with the previous field of the same parity (n - 2) on a worker pool, then proposes notes
+// so that a duplicated field shares the letter of the field it duplicates.
+class NoteAnalyser {
+public:
+	~NoteAnalyser();
+
+	// Takes its own reference to fieldsNode, which must be a SeparateFields clip in the native format
+	void Start(const VSAPI* vsapi, VSNode* fieldsNode, WorkerPool& pool);
+	void Cancel();
+	// Cancels and blocks until chunks already running have finished and the node is released, which must happen
+	// before the core the node belongs to is freed
+	void CancelAndWait(WorkerPool& pool);
+
+	bool IsRunning() const { return m_State && m_State->progress->IsRunning(); }
+	bool HasResults() const { return m_State && !m_State->progress->IsRunning() && !m_State->progress->cancelled; }
+	float GetProgress() const { return m_State ? m_State->progress->Fraction() : 0.0f; }
+
+	// Mean absolute/squared difference per pixel to field n - 2, in 8-bit units. Negative if unknown. Only valid once HasResults().
+	float MeanAbsoluteDifference(int field) const;
+	float MeanSquaredDifference(int field) const;
+
+	// One letter per field (0 where there is no confident suggestion). sceneChanges need not be sorted.
+	std::vector<char> SuggestNotes(const std::vector<int>& sceneChanges) const;
+private:
+	struct State {
+		const VSAPI* vsapi = nullptr;
+		VSNode* node = nullptr;
+		int fieldCount = 0;
+		uint64_t pixelsPerField = 0;
+		int bitsPerSample = 8;
+		std::vector<FieldDifference> differences;
+		// Not vector<bool>, workers write neighbouring elements concurrently
+		std::vector<uint8_t> valid;
+		std::shared_ptr<JobProgress> progress = std::make_shared<JobProgress>();
+
+		~State();
+	};
+
+	// Duplicate position (0-4, the other is 5 later) of the cycle, or -1 when no position clearly stands out
+	int DuplicatePosition(int cycle) const;
+
+	std::shared_ptr<State> m_State;
+};
+
+// Splits the clip at the scene changes and counts the fields where suggestions differ from notes
+std::vector<SceneSuggestion> SummariseSuggestions(const std::vector<char>& suggestions, const std::vector<std::string>& notes, std::vector<int> sceneChanges);
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <map>
+#include <vector>
+
+// Per field values (actions or notes) stored as runs of fields which follow a 10 field pattern, plus the individual
+// fields which differ from their run's pattern. Patterns are indexed by position in the cycle (field % 10) so a run
+// starting mid cycle keeps its phase. Reads and single field writes are O(log n), and setting a range of fields to a
+// pattern is one write plus removing the overrides inside it, so a film that follows its pattern costs a few runs
+// rather than a value per field.
+template <typename T>
+class PatternTrack {
+public:
+	using Pattern = std::array<T, 10>;
+
+	// Every field follows pattern
+	void Reset(const int fieldCount, const Pattern& pattern) {
+		Clear();
+		m_Size = fieldCount;
+		m_Runs[0] = pattern;
+	}
+
+	// Starts a new run wherever the pattern most of the next three cycles agree on changes, anything else is an override
+	void Assign(const std::vector<T>& values) {
+		Clear();
+		m_Size = (int)values.size();
+		Pattern* run = nullptr;
+		for (int first = 0; first < m_Size; first += 10) {
+			Pattern pattern;
+			for (int position = 0; position < 10; position++) {
+				// A value at least two of the cycles share, otherwise this cycle's, fields past the end follow the run
+				T candidates[3];
+				int count = 0;
+				for (int field = first + position; field < m_Size && count < 3; field += 10) {
+					candidates[count++] = values[field];
+				}
+				if (count == 0) {
+					pattern[position] = run ? (*run)[position] : T();
+				} else if (count == 3 && candidates[1] == candidates[2]) {
+					pattern[position] = candidates[1];
+				} else {
+					pattern[position] = candidates[0];
+				}
+			}
+			if (!run || pattern != *run) {
+				run = &(m_Runs[first] = pattern);
+			}
+			for (int field = first; field < std::min(first + 10, m_Size); field++) {
+				if (values[field] != (*run)[field % 10]) {
+					m_Overrides[field] = values[field];
+				}
+			}
+		}
+	}
+
+	void Clear() {
+		m_Size = 0;
+		m_Runs.clear();
+		m_Overrides.clear();
+	}
+
+	int Size() const { return m_Size; }
+
+	T Get(const int field) const {
+		auto it = m_Overrides.find(field);
+		return it != m_Overrides.end() ? it->second : GetPattern(field)[field % 10];
+	}
+
+	void Set(const int field, const T& value) {
+		if (field < 0 || field >= m_Size) {
+			return;
+		}
+		if (value == GetPattern(field)[field % 10]) {
+			m_Overrides.erase(field);
+		} else {
+			m_Overrides[field] = value;
+		}
+	}
+
+	// Every field in [first, end) follows pattern, dropping their overrides
+	void SetPattern(int first, int end, const Pattern& pattern) {
+		first = std::max(first, 0);
+		end = std::min(end, m_Size);
+		if (first >= end) {
+			return;
+		}
+		if (end < m_Size && !m_Runs.contains(end)) {
+			m_Runs[end] = GetPattern(end);
+		}
+		m_Runs.erase(m_Runs.lower_bound(first), m_Runs.lower_bound(end));
+		m_Overrides.erase(m_Overrides.lower_bound(first), m_Overrides.lower_bound(end));
+		m_Runs[first] = pattern;
+
+		// Merge with neighbouring runs of the same pattern
+		auto next = m_Runs.find(end);
+		if (next != m_Runs.end() && next->second == pattern) {
+			m_Runs.erase(next);
+		}
+		auto run = m_Runs.find(first);
+		if (run != m_Runs.begin() && std::prev(run)->second == pattern) {
+			m_Runs.erase(run);
+		}
+	}
+
+	// The pattern of the run containing field, ignoring overrides. An empty track has no runs and reads as T().
+	const Pattern& GetPattern(const int field) const {
+		static const Pattern EMPTY = {};
+		if (m_Runs.empty()) {
+			return EMPTY;
+		}
+		auto it = m_Runs.upper_bound(field);
+		return it == m_Runs.begin() ? it->second : std::prev(it)->second;
+	}
+
+	std::vector<T> ToVector() const {
+		std::vector<T> values;
+		values.reserve(m_Size);
+		for (auto run = m_Runs.begin(); run != m_Runs.end(); run++) {
+			const int end = std::next(run) == m_Runs.end() ? m_Size : std::next(run)->first;
+			for (int field = run->first; field < end; field++) {
+				values.push_back(run->second[field % 10]);
+			}
+		}
+		for (const auto& [field, value] : m_Overrides) {
+			values[field] = value;
+		}
+		return values;
+	}
+
+	size_t GetRunCount() const { return m_Runs.size(); }
+	size_t GetOverrideCount() const { return m_Overrides.size(); }
+	// Approximate, counting a node of each map per run and override but not heap storage owned by the values
+	size_t GetMemoryBytes() const {
+		static const size_t NODE_BYTES = 4 * sizeof(void*);
+		return m_Runs.size() * (NODE_BYTES + sizeof(int) + sizeof(Pattern)) + m_Overrides.size() * (NODE_BYTES + sizeof(int) + sizeof(T));
+	}
+private:
+	int m_Size = 0;
+	// Keyed by first field, there is always a run at 0 once there are fields
+	std::map<int, Pattern> m_Runs;
+	std::map<int, T> m_Overrides;
+};
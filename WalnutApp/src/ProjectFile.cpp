@@ -0,0 +1,82 @@
+#include "ProjectFile.h"
+#include "gzip/decompress.hpp"
+
+#include <fstream>
+#include <vector>
+
+bool ReadProjectFile(const std::string& path, nlohmann::json& project, std::string& error) {
+	std::ifstream input(path, std::ios::binary | std::ios::ate);
+	if (!input) {
+		error = "Failed to open " + path;
+		return false;
+	}
+	const std::streamoff inputSize = input.tellg();
+	input.seekg(0, std::ios::beg);
+
+	std::vector<char> compressed;
+	compressed.resize((size_t)inputSize);
+	input.read(compressed.data(), inputSize);
+	std::string decompressed;
+	try {
+		decompressed = gzip::decompress(compressed.data(), compressed.size());
+	} catch (const std::exception&) {
+		error = path + ": not a compressed IVTC DN project";
+		return false;
+	}
+	try {
+		project = nlohmann::json::parse(decompressed);
+	} catch (const std::exception& e) {
+		error = path + ": " + e.what();
+		return false;
+	}
+	if (!project.is_object()) {
+		error = path + ": not an IVTC DN project";
+		return false;
+	}
+	return true;
+}
+
+nlohmann::json NewProject(const std::string& scriptFile, const int fieldCount, const bool fieldValues) {
+	static std::string notes[] = { "A", "A", "B", "B", "B", "C", "C", "D", "D", "D" };
+	nlohmann::json project = R"({
+		"ivtc_actions": [],
+		"tff": true,
+		"no_match_handling": {},
+		"no_match_handling_default": "Previous",
+		"project_garbage": {
+			"version": 1,
+			"auto_reload": true,
+			"notes": [],
+			"scene_changes": [],
+			"combed_detection": false,
+			"combed_threshold": 45,
+			"match_metrics": false
+		},
+		"extra_attributes": {}
+	})"_json;
+	project["project_garbage"]["script_file"] = scriptFile;
+	for (int i = 0; fieldValues && i < fieldCount; i++) {
+		project["ivtc_actions"][i] = ACTION_PATTERN[i % 10];
+		project["project_garbage"]["notes"][i] = notes[i % 10];
+	}
+	return project;
+}
+
+size_t JsonFootprint(const nlohmann::json& value) {
+	size_t bytes = sizeof(nlohmann::json);
+	if (value.is_string()) {
+		bytes += value.get_ref<const std::string&>().capacity();
+	} else if (value.is_array()) {
+		bytes += sizeof(nlohmann::json::array_t);
+		for (const nlohmann::json& element : value) {
+			bytes += JsonFootprint(element);
+		}
+	} else if (value.is_object()) {
+		bytes += sizeof(nlohmann::json::object_t);
+		for (auto it = value.begin(); it != value.end(); ++it) {
+			// Tree node overhead of std::map, roughly three pointers and a colour per entry
+			bytes += sizeof(std::string) + it.key().capacity() + 4 * sizeof(void*) + JsonFootprint(it.value());
+		}
+	}
+	return bytes;
+}
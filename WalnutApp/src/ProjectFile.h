@@ -0,0 +1,19 @@
+#pragma once
+
+#include "json.hpp"
+
+#include <cstdint>
+#include <string>
+
+// Reads and parses a gzip compressed .ivtc project. Returns false with a description in error on failure.
+bool ReadProjectFile(const std::string& path, nlohmann::json& project, std::string& error);
+
+// Approximate bytes held by a parsed project, counting every value's node and the heap storage of strings and containers
+size_t JsonFootprint(const nlohmann::json& value);
+
+// Actions new projects are seeded with, the usual 3:2 pulldown pattern
+static const int8_t ACTION_PATTERN[10] = { 0, 1, 2, 3, 8, 5, 4, 8, 6, 7 };
+
+// A fresh project for the script, with every cycle set to ACTION_PATTERN. fieldValues false leaves ivtc_actions and
+// notes empty, for callers which keep them elsewhere until the project is written out.
+nlohmann::json NewProject(const std::string& scriptFile, int fieldCount, bool fieldValues = true);
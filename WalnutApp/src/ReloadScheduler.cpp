@@ -0,0 +1,112 @@
+#include "ReloadScheduler.h"
+
+#include <chrono>
+
+static int64_t NowMilliseconds() {
+	return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+ReloadScheduler::~ReloadScheduler() {
+	// Callbacks still point at this scheduler, anything left over is leaked rather than freed with a VSAPI we don't have
+	std::unique_lock<std::mutex> lock(m_Mutex);
+	m_Condition.wait(lock, [&]() { return m_Outstanding == 0; });
+}
+
+void ReloadScheduler::InvalidateFields() {
+	m_Generations[FETCH_FIELD]++;
+	m_Invalid[FETCH_FIELD] = true;
+}
+
+void ReloadScheduler::InvalidateFrames(const bool rebuildGraph) {
+	m_Generations[FETCH_FRAME]++;
+	m_Invalid[FETCH_FRAME] = true;
+	m_RebuildGraph |= rebuildGraph;
+}
+
+bool ReloadScheduler::ShouldIssue() const {
+	if (!m_Invalid[FETCH_FIELD] && !m_Invalid[FETCH_FRAME]) {
+		return false;
+	}
+	if (IsBusy()) {
+		return false;
+	}
+	return NowMilliseconds() - m_LastIssue >= COALESCE_MS;
+}
+
+ReloadScheduler::Batch ReloadScheduler::BeginBatch() {
+	Batch batch;
+	batch.fields = m_Invalid[FETCH_FIELD];
+	batch.frames = m_Invalid[FETCH_FRAME];
+	batch.rebuildGraph = m_RebuildGraph;
+	m_Invalid[FETCH_FIELD] = false;
+	m_Invalid[FETCH_FRAME] = false;
+	m_RebuildGraph = false;
+	m_LastIssue = NowMilliseconds();
+	return batch;
+}
+
+void ReloadScheduler::Request(const VSAPI* vsapi, VSNode* node, const int n, const FetchKind kind, const int slot) {
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Outstanding++;
+	}
+	vsapi->getFrameAsync(n, node, FrameDoneCallback, new Pending{ this, kind, slot, m_Generations[kind] });
+}
+
+void VS_CC ReloadScheduler::FrameDoneCallback(void* userData, const VSFrame* frame, int n, VSNode*, const char* errorMsg) {
+	Pending* pending = (Pending*)userData;
+	ReloadScheduler* scheduler = pending->scheduler;
+	const uint64_t generation = pending->generation;
+	FetchedFrame fetched;
+	fetched.kind = pending->kind;
+	fetched.slot = pending->slot;
+	fetched.frame = frame;
+	if (!frame) {
+		fetched.error = "Frame " + std::to_string(n) + ": " + (errorMsg ? errorMsg : "unknown error");
+	}
+	delete pending;
+
+	// Notified under the lock, the scheduler may be destroyed as soon as the last request is accounted for
+	std::lock_guard<std::mutex> lock(scheduler->m_Mutex);
+	scheduler->m_Completed.push_back(std::move(fetched));
+	scheduler->m_CompletedGenerations.push_back(generation);
+	scheduler->m_Outstanding--;
+	scheduler->m_Condition.notify_all();
+}
+
+std::vector<FetchedFrame> ReloadScheduler::Collect(const VSAPI* vsapi) {
+	std::vector<FetchedFrame> completed;
+	std::vector<uint64_t> generations;
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		completed.swap(m_Completed);
+		generations.swap(m_CompletedGenerations);
+	}
+	std::vector<FetchedFrame> latest;
+	for (size_t i = 0; i < completed.size(); i++) {
+		if (generations[i] == m_Generations[completed[i].kind]) {
+			latest.push_back(std::move(completed[i]));
+		} else {
+			vsapi->freeFrame(completed[i].frame);
+		}
+	}
+	return latest;
+}
+
+void ReloadScheduler::Drain(const VSAPI* vsapi) {
+	std::vector<FetchedFrame> completed;
+	{
+		std::unique_lock<std::mutex> lock(m_Mutex);
+		m_Condition.wait(lock, [&]() { return m_Outstanding == 0; });
+		completed.swap(m_Completed);
+		m_CompletedGenerations.clear();
+	}
+	for (const FetchedFrame& fetched : completed) {
+		vsapi->freeFrame(fetched.frame);
+	}
+}
+
+bool ReloadScheduler::IsBusy() const {
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	return m_Outstanding > 0;
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "vapoursynth/VapourSynth4.h"
+
+enum FetchKind {
+	FETCH_FIELD,
+	FETCH_FRAME,
+	FETCH_KIND_COUNT,
+};
+
+// A completed request, owned by whoever Collect()ed it
+struct FetchedFrame {
+	FetchKind kind = FETCH_FIELD;
+	int slot = 0;
+	const VSFrame* frame = nullptr;
+	std::string error;
+};
+
+// Decides when the UI fetches the fields and output frames of the active cycle. Every edit or cycle change only
+// invalidates, and a new batch of getFrameAsync requests is issued once the previous batch has come back and at least
+// COALESCE_MS has passed since it was issued, so a burst of edits costs one graph rebuild and holding an arrow key
+// decodes whichever cycle is current when the decoder is free instead of every cycle passed over. Requests are tagged
+// with the generation of their kind at the time they were issued, and anything invalidated since is discarded on
+// arrival so only the latest state is ever uploaded.
+class ReloadScheduler {
+public:
+	static const int COALESCE_MS = 50;
+
+	struct Batch {
+		bool fields = false;
+		bool frames = false;
+		bool rebuildGraph = false;
+	};
+
+	~ReloadScheduler();
+
+	void InvalidateFields();
+	// rebuildGraph when the output depends on edited project state, rather than just being for another cycle
+	void InvalidateFrames(bool rebuildGraph);
+
+	bool ShouldIssue() const;
+	// What the next batch needs to fetch, the requests should follow straight away on the same thread
+	Batch BeginBatch();
+	void Request(const VSAPI* vsapi, VSNode* node, int n, FetchKind kind, int slot);
+
+	// Completed requests of the latest generations, stale ones are freed
+	std::vector<FetchedFrame> Collect(const VSAPI* vsapi);
+	// Blocks until every request in flight has come back and frees them, for before the node's core is freed
+	void Drain(const VSAPI* vsapi);
+
+	bool IsBusy() const;
+private:
+	struct Pending {
+		ReloadScheduler* scheduler;
+		FetchKind kind;
+		int slot;
+		uint64_t generation;
+	};
+
+	static void VS_CC FrameDoneCallback(void* userData, const VSFrame* frame, int n, VSNode* node, const char* errorMsg);
+
+	mutable std::mutex m_Mutex;
+	std::condition_variable m_Condition;
+	int m_Outstanding = 0;
+	std::vector<FetchedFrame> m_Completed;
+	std::vector<uint64_t> m_CompletedGenerations;
+
+	// Only touched on the UI thread
+	uint64_t m_Generations[FETCH_KIND_COUNT] = {};
+	bool m_Invalid[FETCH_KIND_COUNT] = {};
+	bool m_RebuildGraph = false;
+	int64_t m_LastIssue = 0;
+};
@@ -0,0 +1,160 @@
+#include "SceneDetection.h"
+#include "FieldSimilarity.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdio>
+
+static const int SCENE_DETECTION_CHUNK_SIZE = 1000;
+
+// Fields either side of a candidate used to estimate the local noise level
+static const int SCENE_DETECTION_WINDOW = 15;
+
+// Absolute floors so static or near-black scenes don't turn noise into scene changes
+static const float SCENE_MIN_DIFFERENCE = 8.0f;
+static const float SCENE_MIN_HISTOGRAM_DISTANCE = 0.2f;
+
+using Histogram = std::array<float, SCENE_HISTOGRAM_BINS>;
+
+static Histogram LumaHistogram(const FieldPlane& plane) {
+	std::array<uint32_t, SCENE_HISTOGRAM_BINS> counts = {};
+	const int shift = plane.bitsPerSample - 6;
+	for (int y = 0; y < plane.height; y++) {
+		const uint8_t* row = plane.data + y * plane.stride;
+		if (plane.bitsPerSample <= 8) {
+			for (int x = 0; x < plane.width; x++) {
+				counts[row[x] >> shift]++;
+			}
+		} else {
+			for (int x = 0; x < plane.width; x++) {
+				counts[((const uint16_t*)row)[x] >> shift]++;
+			}
+		}
+	}
+	Histogram histogram;
+	const float total = (float)plane.width * plane.height;
+	for (int i = 0; i < SCENE_HISTOGRAM_BINS; i++) {
+		histogram[i] = counts[i] / total;
+	}
+	return histogram;
+}
+
+SceneDetector::State::~State() {
+	if (node) {
+		vsapi->freeNode(node);
+	}
+}
+
+SceneDetector::~SceneDetector() {
+	Cancel();
+}
+
+void SceneDetector::Start(const VSAPI* vsapi, VSNode* fieldsNode, WorkerPool& pool) {
+	Cancel();
+	auto state = std::make_shared<State>();
+	state->vsapi = vsapi;
+	state->node = vsapi->addNodeRef(fieldsNode);
+	state->fieldCount = vsapi->getVideoInfo(fieldsNode)->numFrames;
+	state->differences.resize(state->fieldCount, 0.0f);
+	state->histogramDistances.resize(state->fieldCount, 0.0f);
+	m_State = state;
+
+	pool.ParallelFor(0, state->fieldCount, SCENE_DETECTION_CHUNK_SIZE, state->progress, [state](int begin, int end) {
+		char error_message[1024];
+		const VSFrame* previous = nullptr;
+		Histogram previousHistogram = {};
+		for (int n = std::max(0, begin - 1); n < end && !state->progress->cancelled; n++) {
+			const VSFrame* frame = state->vsapi->getFrame(n, state->node, error_message, sizeof(error_message));
+			if (!frame) {
+				fprintf(stderr, "%s\n", error_message);
+			}
+			Histogram histogram = {};
+			if (frame) {
+				const FieldPlane plane = LumaPlane(state->vsapi, frame);
+				histogram = LumaHistogram(plane);
+				if (n >= begin && previous) {
+					const FieldDifference difference = CompareFields(LumaPlane(state->vsapi, previous), plane);
+					const float scale = (float)(1 << (plane.bitsPerSample - 8));
+					state->differences[n] = (float)((double)difference.sad / ((double)plane.width * plane.height)) / scale;
+					float distance = 0.0f;
+					for (int i = 0; i < SCENE_HISTOGRAM_BINS; i++) {
+						distance += std::fabs(histogram[i] - previousHistogram[i]);
+					}
+					state->histogramDistances[n] = distance;
+				}
+			}
+			if (previous) {
+				state->vsapi->freeFrame(previous);
+			}
+			previous = frame;
+			previousHistogram = histogram;
+			if (n >= begin) {
+				state->progress->completed++;
+			}
+		}
+		if (previous) {
+			state->vsapi->freeFrame(previous);
+		}
+	});
+}
+
+void SceneDetector::Cancel() {
+	if (m_State) {
+		m_State->progress->cancelled = true;
+		m_State = nullptr;
+	}
+}
+
+void SceneDetector::CancelAndWait(WorkerPool& pool) {
+	std::shared_ptr<State> state = m_State;
+	if (!state) {
+		return;
+	}
+	Cancel();
+	pool.Wait(state->progress);
+	// Finished chunks may still hold the state, so the node is released here rather than by whichever lets go last
+	state->vsapi->freeNode(state->node);
+	state->node = nullptr;
+}
+
+std::vector<int> SceneDetector::DetectSceneChanges(float sensitivity) const {
+	std::vector<int> sceneChanges;
+	if (!HasResults()) {
+		return sceneChanges;
+	}
+	const auto& differences = m_State->differences;
+	const int fieldCount = m_State->fieldCount;
+	for (int n = 1; n < fieldCount; n++) {
+		const float difference = differences[n];
+		if (difference < SCENE_MIN_DIFFERENCE || m_State->histogramDistances[n] < SCENE_MIN_HISTOGRAM_DISTANCE) {
+			continue;
+		}
+		double sum = 0.0;
+		double squares = 0.0;
+		int count = 0;
+		bool localMaximum = true;
+		for (int i = std::max(1, n - SCENE_DETECTION_WINDOW); i <= std::min(fieldCount - 1, n + SCENE_DETECTION_WINDOW); i++) {
+			if (i == n) {
+				continue;
+			}
+			// Only the strongest field of a burst (e.g. a cut followed by a flash) is reported
+			if (differences[i] > difference || (differences[i] == difference && i < n)) {
+				localMaximum = false;
+				break;
+			}
+			sum += differences[i];
+			squares += (double)differences[i] * differences[i];
+			count++;
+		}
+		if (!localMaximum || count == 0) {
+			continue;
+		}
+		const double mean = sum / count;
+		const double deviation = std::sqrt(std::max(0.0, squares / count - mean * mean));
+		if (difference > mean + sensitivity * deviation + SCENE_MIN_DIFFERENCE * 0.5) {
+			sceneChanges.push_back(n);
+		}
+	}
+	return sceneChanges;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "FieldPlane.h"
+#include "WorkerPool.h"
+
+#include <memory>
+#include <vector>
+
+// Fields the detector is run on are downscaled to roughly this width, full resolution adds nothing but decode time
+static const int SCENE_DETECTION_WIDTH = 160;
+
+static const int SCENE_HISTOGRAM_BINS = 64;
+
+// Scans a low resolution luma clip of fields on a worker pool, measuring how much every field differs from the one before it.
+// Scene changes are then picked out with an adaptive threshold, which is cheap enough to re-run whenever the threshold changes.
+class SceneDetector {
+public:
+	~SceneDetector();
+
+	// Takes its own reference to fieldsNode, which should be a small GRAY clip of separated fields
+	void Start(const VSAPI* vsapi, VSNode* fieldsNode, WorkerPool& pool);
+	void Cancel();
+	// Cancels and blocks until chunks already running have finished and the node is released, which must happen
+	// before the core the node belongs to is freed
+	void CancelAndWait(WorkerPool& pool);
+
+	bool IsRunning() const { return m_State && m_State->progress->IsRunning(); }
+	bool HasResults() const { return m_State && !m_State->progress->IsRunning() && !m_State->progress->cancelled; }
+	float GetProgress() const { return m_State ? m_State->progress->Fraction() : 0.0f; }
+
+	// Fields where a new scene starts. A field is a scene change when its difference to the previous field stands out from
+	// the surrounding fields by more than `sensitivity` standard deviations and its luma histogram changes noticeably.
+	std::vector<int> DetectSceneChanges(float sensitivity) const;
+private:
+	struct State {
+		const VSAPI* vsapi = nullptr;
+		VSNode* node = nullptr;
+		int fieldCount = 0;
+		// Mean absolute difference to the previous field (8-bit units) and L1 distance of normalised histograms [0, 2]
+		std::vector<float> differences;
+		std::vector<float> histogramDistances;
+		std::shared_ptr<JobProgress> progress = std::make_shared<JobProgress>();
+
+		~State();
+	};
+
+	std::shared_ptr<State> m_State;
+};
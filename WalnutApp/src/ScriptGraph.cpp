@@ -0,0 +1,161 @@
+#include "ScriptGraph.h"
+
+#include <cstdio>
+
+VSNode* ScriptGraph::Invoke(const char* pluginId, const char* function, VSMap* argument_map) const {
+	VSPlugin* plugin = m_VSAPI->getPluginByID(pluginId, m_Core);
+	if (!plugin) {
+		fprintf(stderr, "%s: plugin %s is not installed\n", function, pluginId);
+		m_VSAPI->freeMap(argument_map);
+		return nullptr;
+	}
+	VSMap* result_map = m_VSAPI->invoke(plugin, function, argument_map);
+
+	const char* result_error = m_VSAPI->mapGetError(result_map);
+	if (result_error) {
+		fprintf(stderr, "%s\n", result_error);
+	}
+
+	VSNode* output = m_VSAPI->mapGetNode(result_map, "clip", 0, nullptr);
+	m_VSAPI->freeMap(argument_map);
+	m_VSAPI->freeMap(result_map);
+	return output;
+}
+
+VSNode* ScriptGraph::SeparateFields(VSNode* node) const {
+	if (!node) {
+		return nullptr;
+	}
+	VSMap* argument_map = m_VSAPI->createMap();
+	m_VSAPI->mapConsumeNode(argument_map, "clip", node, maReplace);
+	return Invoke("com.vapoursynth.std", "SeparateFields", argument_map);
+}
+
+VSNode* ScriptGraph::ConvertToYUV420P8(VSNode* node) const {
+	if (!node) {
+		return nullptr;
+	}
+	VSMap* argument_map = m_VSAPI->createMap();
+	m_VSAPI->mapConsumeNode(argument_map, "clip", node, maReplace);
+	m_VSAPI->mapSetInt(argument_map, "format", pfYUV420P8, maReplace);
+	return Invoke("com.vapoursynth.resize", "Spline36", argument_map);
+}
+
+VSNode* ScriptGraph::ConvertToRGB(VSNode* node) const {
+	if (!node) {
+		return nullptr;
+	}
+	VSMap* argument_map = m_VSAPI->createMap();
+	m_VSAPI->mapConsumeNode(argument_map, "clip", node, maReplace);
+	m_VSAPI->mapSetInt(argument_map, "format", pfRGB24, maReplace);
+	m_VSAPI->mapSetInt(argument_map, "matrix_in", 5, maReplace);
+	return Invoke("com.vapoursynth.resize", "Spline36", argument_map);
+}
+
+VSNode* ScriptGraph::ConvertToSmallGray(VSNode* node, const int width, const int height) const {
+	if (!node) {
+		return nullptr;
+	}
+	const bool rgb = m_VSAPI->getVideoInfo(node)->format.colorFamily == cfRGB;
+	VSMap* argument_map = m_VSAPI->createMap();
+	m_VSAPI->mapConsumeNode(argument_map, "clip", node, maReplace);
+	m_VSAPI->mapSetInt(argument_map, "width", width, maReplace);
+	m_VSAPI->mapSetInt(argument_map, "height", height, maReplace);
+	m_VSAPI->mapSetInt(argument_map, "format", pfGray8, maReplace);
+	if (rgb) {
+		m_VSAPI->mapSetData(argument_map, "matrix_s", "709", -1, dtUtf8, maReplace);
+	}
+	return Invoke("com.vapoursynth.resize", "Bilinear", argument_map);
+}
+
+VSNode* ScriptGraph::ConvertToThumbnail(VSNode* node, const int width, const int height) const {
+	if (!node) {
+		return nullptr;
+	}
+	const bool yuv = m_VSAPI->getVideoInfo(node)->format.colorFamily == cfYUV;
+	VSMap* argument_map = m_VSAPI->createMap();
+	m_VSAPI->mapConsumeNode(argument_map, "clip", node, maReplace);
+	m_VSAPI->mapSetInt(argument_map, "width", width, maReplace);
+	m_VSAPI->mapSetInt(argument_map, "height", height, maReplace);
+	m_VSAPI->mapSetInt(argument_map, "format", pfRGB24, maReplace);
+	if (yuv) {
+		m_VSAPI->mapSetInt(argument_map, "matrix_in", 5, maReplace);
+	}
+	return Invoke("com.vapoursynth.resize", "Bilinear", argument_map);
+}
+
+VSNode* ScriptGraph::IVTCDN(VSNode* node, const std::string& rawProject) const {
+	if (!node) {
+		return nullptr;
+	}
+	VSMap* argument_map = m_VSAPI->createMap();
+	m_VSAPI->mapConsumeNode(argument_map, "clip", node, maReplace);
+	m_VSAPI->mapSetData(argument_map, "projectfile", rawProject.c_str(), (int)rawProject.size(), dtUtf8, maReplace);
+	m_VSAPI->mapSetInt(argument_map, "rawproject", 1, maReplace);
+	return Invoke("tools.mike.ivtc", "IVTC", argument_map);
+}
+
+VSNode* ScriptGraph::DMetrics(VSNode* node) const {
+	if (!node) {
+		return nullptr;
+	}
+	VSMap* argument_map = m_VSAPI->createMap();
+	m_VSAPI->mapConsumeNode(argument_map, "clip", node, maReplace);
+	return Invoke("com.vapoursynth.dmetrics", "DMetrics", argument_map);
+}
+
+bool ScriptGraph::IsUploadableYUV(const VSVideoFormat& format) {
+	if (format.colorFamily != cfYUV || format.sampleType != stInteger || format.bitsPerSample < 8 || format.bitsPerSample > 16) {
+		return false;
+	}
+	return format.subSamplingH <= format.subSamplingW && format.subSamplingW <= 1;
+}
+
+bool YUVUploadSupport::Accepts(const VSVideoFormat& format) const {
+	return ScriptGraph::IsUploadableYUV(format) && (format.bytesPerSample == 2 ? sixteenBit : eightBit);
+}
+
+VSNode* ScriptGraph::FieldsView(VSNode* output, const YUVUploadSupport& keepYUV) const {
+	if (!output) {
+		return nullptr;
+	}
+	const VSVideoFormat& format = m_VSAPI->getVideoInfo(output)->format;
+	const int colorFamily = format.colorFamily;
+	if (keepYUV.Accepts(format)) {
+		return SeparateFields(output);
+	} else if (colorFamily == cfYUV) {
+		// Convert to RGB & pack
+		return ConvertToRGB(SeparateFields(output));
+	} else if (colorFamily == cfRGB) {
+		return SeparateFields(output);
+	}
+	// Hope for the best?
+	return output;
+}
+
+VSNode* ScriptGraph::FramesView(VSNode* output, const std::string& rawProject, const bool combedDetection, const YUVUploadSupport& keepYUV) const {
+	if (!output) {
+		return nullptr;
+	}
+	const int colorFamily = m_VSAPI->getVideoInfo(output)->format.colorFamily;
+	if (colorFamily == cfYUV) {
+		// Convert to RGB & pack
+		VSNode* node = IVTCDN(SeparateFields(output), rawProject);
+		if (combedDetection) {
+			node = DMetrics(ConvertToYUV420P8(node));
+		}
+		if (node && keepYUV.Accepts(m_VSAPI->getVideoInfo(node)->format)) {
+			return node;
+		}
+		return ConvertToRGB(node);
+	} else if (colorFamily == cfRGB) {
+		// Doesn't support DMetrics
+		return IVTCDN(SeparateFields(output), rawProject);
+	}
+	// Hope for the best?
+	return output;
+}
+
+VSNode* ScriptGraph::OutputView(VSNode* output, const std::string& rawProject) const {
+	return IVTCDN(SeparateFields(output), rawProject);
+}
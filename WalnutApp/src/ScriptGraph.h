@@ -0,0 +1,47 @@
+#pragma once
+
+#include "vapoursynth/VapourSynth4.h"
+
+#include <string>
+
+// Which of the ScriptGraph::IsUploadableYUV() formats a display converts on the GPU. Devices may sample 8 bit planes
+// but not 16 bit ones, so support is by sample size, which is what decides the format planes are uploaded in.
+struct YUVUploadSupport {
+	bool eightBit = false;
+	bool sixteenBit = false;
+
+	bool Accepts(const VSVideoFormat& format) const;
+};
+
+// Builds the filter chains behind the fields and frames views on top of a script's output. Every function consumes
+// the reference to the node it is given and returns a new one, or nullptr after printing the error (passing nullptr along).
+// Shared with the benchmarks so they measure exactly the graph the GUI navigates.
+class ScriptGraph {
+public:
+	ScriptGraph(const VSAPI* vsapi, VSCore* core) : m_VSAPI(vsapi), m_Core(core) {}
+
+	VSNode* SeparateFields(VSNode* node) const;
+	VSNode* ConvertToYUV420P8(VSNode* node) const;
+	VSNode* ConvertToRGB(VSNode* node) const;
+	VSNode* ConvertToSmallGray(VSNode* node, int width, int height) const;
+	VSNode* ConvertToThumbnail(VSNode* node, int width, int height) const;
+	VSNode* IVTCDN(VSNode* node, const std::string& rawProject) const;
+	VSNode* DMetrics(VSNode* node) const;
+
+	// Separated fields of the script output, as RGB24 ready for packing. Formats keepYUV accepts are left as they
+	// are, for displays converting them on the GPU.
+	VSNode* FieldsView(VSNode* output, const YUVUploadSupport& keepYUV = {}) const;
+	// Separated fields of the script output through IVTC DN (and DMetrics with combed detection), as RGB24 ready for
+	// packing, or as they are when keepYUV accepts the format
+	VSNode* FramesView(VSNode* output, const std::string& rawProject, bool combedDetection, const YUVUploadSupport& keepYUV = {}) const;
+	// Separated fields of the script output through IVTC DN in the script's own format, the project's final output
+	VSNode* OutputView(VSNode* output, const std::string& rawProject) const;
+
+	// 8 to 16 bit integer YUV with 4:2:0, 4:2:2 or 4:4:4 chroma, which can be uploaded plane by plane
+	static bool IsUploadableYUV(const VSVideoFormat& format);
+private:
+	VSNode* Invoke(const char* pluginId, const char* function, VSMap* argument_map) const;
+
+	const VSAPI* m_VSAPI;
+	VSCore* m_Core;
+};
@@ -0,0 +1,123 @@
+#include "ScriptLoader.h"
+#include "ScriptGraph.h"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+static int64_t NowMilliseconds() {
+	return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void LoadedScript::Free(const VSSCRIPTAPI* vssapi) {
+	const VSAPI* vsapi = vssapi->getVSAPI(VAPOURSYNTH_API_VERSION);
+	vsapi->freeNode(fieldsNode);
+	vsapi->freeNode(nativeFieldsNode);
+	if (script) {
+		vssapi->freeScript(script);
+	}
+	fieldsNode = nullptr;
+	nativeFieldsNode = nullptr;
+	script = nullptr;
+}
+
+ScriptLoader::~ScriptLoader() {
+	Cancel();
+}
+
+void ScriptLoader::Start(const VSSCRIPTAPI* vssapi, const std::string& path, const int firstField, const int threads, const YUVUploadSupport keepYUV) {
+	Cancel();
+	auto job = std::make_shared<Job>();
+	job->vssapi = vssapi;
+	m_Job = job;
+	m_Path = path;
+	m_StartTime = NowMilliseconds();
+	// Detached since an abandoned evaluation may outlive the loader, the job is kept alive by the thread's reference
+	std::thread(&ScriptLoader::Run, job, path, firstField, threads, keepYUV).detach();
+}
+
+void ScriptLoader::Cancel() {
+	if (!m_Job) {
+		return;
+	}
+	std::lock_guard<std::mutex> lock(m_Job->mutex);
+	m_Job->abandoned = true;
+	if (m_Job->stage == STAGE_DONE) {
+		m_Job->result.Free(m_Job->vssapi);
+	}
+	m_Job = nullptr;
+}
+
+LoadedScript ScriptLoader::Take() {
+	LoadedScript result;
+	if (!IsReady()) {
+		return result;
+	}
+	{
+		std::lock_guard<std::mutex> lock(m_Job->mutex);
+		result = std::move(m_Job->result);
+		m_Job->result = LoadedScript();
+	}
+	m_Job = nullptr;
+	return result;
+}
+
+const char* ScriptLoader::StageName(const Stage stage) {
+	switch (stage) {
+		case STAGE_EVALUATING:     return "Evaluating script";
+		case STAGE_BUILDING_GRAPH: return "Building filter graph";
+		case STAGE_FETCHING_FRAME: return "Fetching first frame";
+		case STAGE_DONE:           return "Done";
+	}
+	return "";
+}
+
+double ScriptLoader::GetElapsedSeconds() const {
+	return m_Job ? (NowMilliseconds() - m_StartTime) / 1000.0 : 0.0;
+}
+
+void ScriptLoader::Run(std::shared_ptr<Job> job, std::string path, const int firstField, const int threads, const YUVUploadSupport keepYUV) {
+	const VSSCRIPTAPI* vssapi = job->vssapi;
+	const VSAPI* vsapi = vssapi->getVSAPI(VAPOURSYNTH_API_VERSION);
+	LoadedScript result;
+
+	result.script = vssapi->createScript(nullptr);
+	// Before evaluation, so sources that size their own thread pools from the core see the limit
+	vsapi->setThreadCount(threads, vssapi->getCore(result.script));
+	vssapi->evalSetWorkingDir(result.script, 1);
+	if (vssapi->evaluateFile(result.script, path.c_str()) != 0) {
+		result.error = vssapi->getError(result.script);
+	} else {
+		job->stage = STAGE_BUILDING_GRAPH;
+		const ScriptGraph graph(vsapi, vssapi->getCore(result.script));
+		result.fieldsNode = graph.FieldsView(vssapi->getOutputNode(result.script, 0), keepYUV);
+		result.nativeFieldsNode = graph.SeparateFields(vssapi->getOutputNode(result.script, 0));
+		if (!result.fieldsNode || !result.nativeFieldsNode) {
+			result.error = "The script has no usable output";
+		}
+	}
+
+	if (result.error.empty() && !job->abandoned) {
+		job->stage = STAGE_FETCHING_FRAME;
+		const int fieldCount = vsapi->getVideoInfo(result.fieldsNode)->numFrames;
+		char error_message[1024];
+		const VSFrame* frame = vsapi->getFrame(std::max(0, std::min(firstField, fieldCount - 1)), result.fieldsNode, error_message, sizeof(error_message));
+		if (frame) {
+			vsapi->freeFrame(frame);
+		} else {
+			result.error = error_message;
+		}
+	}
+
+	if (!result.error.empty()) {
+		result.Free(vssapi);
+	}
+
+	std::lock_guard<std::mutex> lock(job->mutex);
+	if (job->abandoned) {
+		result.Free(vssapi);
+	} else {
+		job->result = std::move(result);
+	}
+	job->stage = STAGE_DONE;
+}
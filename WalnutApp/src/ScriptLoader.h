@@ -0,0 +1,63 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "ScriptGraph.h"
+#include "vapoursynth/VSScript4.h"
+
+// A script evaluated off the UI thread, with the nodes SetActiveFields needs built on top of it
+struct LoadedScript {
+	VSScript* script = nullptr;
+	VSNode* fieldsNode = nullptr;
+	VSNode* nativeFieldsNode = nullptr;
+	std::string error;
+
+	void Free(const VSSCRIPTAPI* vssapi);
+};
+
+// Evaluates a script, builds the fields graphs and fetches a first field on a background thread. Evaluation can't be
+// interrupted (indexing sources can take minutes), so cancelling or starting another load abandons the running one,
+// whose thread frees everything it made when it eventually finishes.
+class ScriptLoader {
+public:
+	enum Stage {
+		STAGE_EVALUATING,
+		STAGE_BUILDING_GRAPH,
+		STAGE_FETCHING_FRAME,
+		STAGE_DONE,
+	};
+
+	~ScriptLoader();
+
+	// Replaces any pending load. firstField is fetched once the graph is built so the decoder has seeked there, by a
+	// core limited to threads (0 for automatic). keepYUV is passed on to ScriptGraph::FieldsView.
+	void Start(const VSSCRIPTAPI* vssapi, const std::string& path, int firstField, int threads = 0, YUVUploadSupport keepYUV = {});
+	void Cancel();
+
+	bool IsLoading() const { return m_Job != nullptr; }
+	bool IsReady() const { return m_Job && m_Job->stage == STAGE_DONE; }
+	// Hands the finished load to the caller, who owns the script and nodes from then on
+	LoadedScript Take();
+
+	const std::string& GetPath() const { return m_Path; }
+	Stage GetStage() const { return m_Job ? (Stage)m_Job->stage.load() : STAGE_DONE; }
+	static const char* StageName(Stage stage);
+	double GetElapsedSeconds() const;
+private:
+	struct Job {
+		const VSSCRIPTAPI* vssapi = nullptr;
+		std::atomic<int> stage = STAGE_EVALUATING;
+		std::mutex mutex;
+		std::atomic<bool> abandoned = false;
+		LoadedScript result;
+	};
+
+	static void Run(std::shared_ptr<Job> job, std::string path, int firstField, int threads, YUVUploadSupport keepYUV);
+
+	std::shared_ptr<Job> m_Job;
+	std::string m_Path;
+	int64_t m_StartTime = 0;
+};
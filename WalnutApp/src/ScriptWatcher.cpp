@@ -0,0 +1,122 @@
+#include "ScriptWatcher.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <regex>
+#include <set>
+#include <sstream>
+
+static int64_t NowMilliseconds() {
+	return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Each dotted module name imported by the source, the `import` and `from` forms both
+static std::vector<std::string> ImportedModules(const std::filesystem::path& path) {
+	static const std::regex import_line(R"(^\s*import\s+([\w.,\s]+?)\s*(#.*)?$)");
+	static const std::regex from_line(R"(^\s*from\s+(\.*[\w.]*)\s+import\b)");
+	static const std::regex module_name(R"(^\s*([\w.]+)(\s+as\s+\w+)?\s*$)");
+
+	std::vector<std::string> modules;
+	std::ifstream file(path);
+	std::string line;
+	std::smatch match;
+	while (std::getline(file, line)) {
+		if (std::regex_search(line, match, from_line)) {
+			modules.push_back(match[1]);
+		} else if (std::regex_search(line, match, import_line)) {
+			// import a, b.c as d
+			std::stringstream names(match[1].str());
+			std::string name;
+			std::smatch name_match;
+			while (std::getline(names, name, ',')) {
+				if (std::regex_match(name, name_match, module_name)) {
+					modules.push_back(name_match[1]);
+				}
+			}
+		}
+	}
+	return modules;
+}
+
+std::vector<std::filesystem::path> FindLocalImports(const std::filesystem::path& scriptPath) {
+	std::vector<std::filesystem::path> files = { scriptPath };
+	std::set<std::filesystem::path> seen = { scriptPath };
+	const std::filesystem::path directory = scriptPath.parent_path();
+	for (size_t i = 0; i < files.size(); i++) {
+		for (std::string module : ImportedModules(files[i])) {
+			// Relative imports are resolved against the script's directory too, which is all a script can import from
+			module.erase(0, module.find_first_not_of('.'));
+			if (module.empty()) {
+				continue;
+			}
+			std::filesystem::path relative = directory;
+			size_t start = 0;
+			while (start <= module.size()) {
+				const size_t end = std::min(module.find('.', start), module.size());
+				relative /= module.substr(start, end - start);
+				start = end + 1;
+			}
+			std::error_code error;
+			const std::filesystem::path candidates[] = { std::filesystem::path(relative).concat(".py"), relative / "__init__.py" };
+			for (const std::filesystem::path& candidate : candidates) {
+				if (std::filesystem::is_regular_file(candidate, error) && seen.insert(candidate).second) {
+					files.push_back(candidate);
+					break;
+				}
+			}
+		}
+	}
+	return files;
+}
+
+void ScriptWatcher::Watch(const std::string& scriptPath) {
+	m_ScriptPath = scriptPath;
+	m_Files = FindLocalImports(scriptPath);
+	m_Stamps = Stamps();
+	m_PendingStamps.clear();
+	m_LastPoll = NowMilliseconds();
+}
+
+void ScriptWatcher::Stop() {
+	m_ScriptPath.clear();
+	m_Files.clear();
+	m_Stamps.clear();
+	m_PendingStamps.clear();
+}
+
+std::vector<uint64_t> ScriptWatcher::Stamps() const {
+	std::vector<uint64_t> stamps;
+	for (const std::filesystem::path& file : m_Files) {
+		std::error_code error;
+		const auto time = std::filesystem::last_write_time(file, error);
+		// A file that's missing mid-save reads as 0, which is a change like any other
+		stamps.push_back(error ? 0 : (uint64_t)time.time_since_epoch().count());
+	}
+	return stamps;
+}
+
+bool ScriptWatcher::Poll() {
+	if (m_Files.empty()) {
+		return false;
+	}
+	const int64_t now = NowMilliseconds();
+	if (now - m_LastPoll < POLL_MS) {
+		return false;
+	}
+	m_LastPoll = now;
+
+	const std::vector<uint64_t> stamps = Stamps();
+	if (stamps == m_Stamps) {
+		m_PendingStamps.clear();
+		return false;
+	}
+	if (stamps != m_PendingStamps) {
+		// Still changing, wait for the next poll to see the same stamps again
+		m_PendingStamps = stamps;
+		return false;
+	}
+	// Edits may have added or removed imports
+	Watch(m_ScriptPath);
+	return true;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// Notices edits to a script and to the modules it imports from alongside it. Files are polled for their modification
+// time rather than watched with inotify or ReadDirectoryChangesW, which works the same on every platform and through
+// editors that save by replacing the file. A change is only reported once the files have stopped changing for a whole
+// poll interval, so a save in progress isn't evaluated half written.
+class ScriptWatcher {
+public:
+	static const int POLL_MS = 500;
+
+	// Starts watching the script and the local modules it imports now, replacing anything watched before
+	void Watch(const std::string& scriptPath);
+	void Stop();
+
+	// Call once per UI frame, true once for each settled change. The imports are rescanned when it returns true.
+	bool Poll();
+
+	bool IsWatching() const { return !m_Files.empty(); }
+	const std::vector<std::filesystem::path>& GetFiles() const { return m_Files; }
+private:
+	std::vector<uint64_t> Stamps() const;
+
+	std::string m_ScriptPath;
+	std::vector<std::filesystem::path> m_Files;
+	std::vector<uint64_t> m_Stamps;
+	std::vector<uint64_t> m_PendingStamps;
+	int64_t m_LastPoll = 0;
+};
+
+// The script followed by the files of the modules it imports (recursively) that resolve to a .py file or package
+// relative to the script's directory. Anything else is assumed to be installed and not worth watching.
+std::vector<std::filesystem::path> FindLocalImports(const std::filesystem::path& scriptPath);
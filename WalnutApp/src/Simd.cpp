@@ -0,0 +1,42 @@
+#include "Simd.h"
+#include "simd/cpuinfo_x86.h"
+
+#include <cstdlib>
+#include <cstring>
+
+namespace Simd {
+
+// Shares libp2p's detection, which checks the OS saves the YMM registers too
+static bool CpuHasAVX2() {
+	const p2p::detail::x86_capabilities caps = p2p::detail::query_x86_capabilities();
+	return caps.avx2 && caps.popcnt;
+}
+
+Level DetectLevel() {
+	Level level = CpuHasAVX2() ? Level::AVX2 : Level::SSE2;
+	const char* override = getenv("IVTCDN_SIMD");
+	if (override) {
+		if (!strcmp(override, "scalar")) {
+			level = Level::Scalar;
+		} else if (!strcmp(override, "sse2") && level > Level::SSE2) {
+			level = Level::SSE2;
+		}
+	}
+	return level;
+}
+
+Level ActiveLevel() {
+	static const Level level = DetectLevel();
+	return level;
+}
+
+const char* LevelName(Level level) {
+	switch (level) {
+		case Level::Scalar: return "scalar";
+		case Level::SSE2:   return "SSE2";
+		case Level::AVX2:   return "AVX2";
+	}
+	return "unknown";
+}
+
+}
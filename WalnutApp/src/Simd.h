@@ -0,0 +1,30 @@
+#pragma once
+
+// Runtime CPU feature detection for the hand-vectorised kernels. x64 always has SSE2, so only AVX2 needs checking.
+// Functions using AVX2 intrinsics must be marked IVTCDN_TARGET_AVX2 so gcc/clang will emit them without -mavx2.
+
+#include <immintrin.h>
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#define IVTCDN_TARGET_AVX2
+#else
+#define IVTCDN_TARGET_AVX2 __attribute__((target("avx2,popcnt")))
+#endif
+
+namespace Simd {
+
+enum class Level {
+	Scalar,
+	SSE2,
+	AVX2
+};
+
+// Highest level supported by the CPU, capped by the IVTCDN_SIMD environment variable ("scalar", "sse2" or "avx2") if set
+Level DetectLevel();
+
+// Cached result of DetectLevel()
+Level ActiveLevel();
+
+const char* LevelName(Level level);
+
+}
@@ -0,0 +1,214 @@
+#include "SyntheticClip.h"
+#include "ProjectFile.h"
+
+#include <algorithm>
+#include <cctype>
+
+// Source fields of each group of 4 frames (8 fields) in telecined order, AA BB BC CD DD
+static const int TELECINE_PATTERN[10] = { 0, 1, 2, 3, 2, 5, 4, 7, 6, 7 };
+static const int ACTION_DROP = 8;
+static const int ACTION_COMPLETE_PREVIOUS_CYCLE = 9;
+// Expr works in single precision, which holds every integer up to 2^24 exactly
+static const int MAX_CYCLES = 1000000;
+
+// Source field at position k of the film telecined from start to end
+static int TelecinedField(const int64_t k) {
+	return (int)(8 * (k / 10) + TELECINE_PATTERN[k % 10]);
+}
+
+// A fixed LCG rather than <random>, whose distributions may differ between standard libraries
+static uint32_t NextRandom(uint32_t& state) {
+	state = state * 1664525u + 1013904223u;
+	return state >> 8;
+}
+
+static std::string PairList(const std::vector<std::pair<int, int>>& pairs) {
+	std::string list = "[";
+	for (size_t i = 0; i < pairs.size(); i++) {
+		list += (i ? ", (" : "(") + std::to_string(pairs[i].first) + ", " + std::to_string(pairs[i].second) + ")";
+	}
+	return list + "]";
+}
+
+SyntheticClip::Plan SyntheticClip::MakePlan() const {
+	Plan plan;
+	const int fieldCount = FieldCount();
+	uint32_t state = seed;
+
+	// Where each cut falls, and how many telecined fields it skips
+	std::vector<std::pair<int, int>> cuts;
+	for (int cycle = patternBreakInterval; patternBreakInterval > 0 && cycle < cycles; cycle += patternBreakInterval) {
+		const int at = cycle * 10 + (int)(NextRandom(state) % 10);
+		cuts.push_back({ at, 2 * (1 + (int)(NextRandom(state) % 4)) });
+	}
+
+	plan.sourceFields.resize(fieldCount);
+	plan.segments.push_back({ 0, 0 });
+	int64_t k = 0;
+	size_t nextCut = 0;
+	for (int field = 0; field < fieldCount; field++) {
+		if (nextCut < cuts.size() && cuts[nextCut].first == field) {
+			k += cuts[nextCut++].second;
+			plan.segments.push_back({ field, (int)k });
+		}
+		plan.sourceFields[field] = TelecinedField(k++);
+	}
+
+	// Orphans come from frames after the film, one each, so their partners appear nowhere
+	int filmFrames = 0;
+	for (const int source : plan.sourceFields) {
+		filmFrames = std::max(filmFrames, source / 2 + 1);
+	}
+	plan.progressiveFrames = filmFrames;
+	for (int cycle = orphanInterval; orphanInterval > 0 && cycle < cycles; cycle += orphanInterval) {
+		const int field = cycle * 10 + (int)(NextRandom(state) % 10);
+		const int source = 2 * plan.progressiveFrames++ + field % 2;
+		plan.orphans.push_back({ field, source });
+		plan.sourceFields[field] = source;
+	}
+	return plan;
+}
+
+std::string SyntheticClip::Script() const {
+	const Plan plan = MakePlan();
+	const int block = width / ID_BITS;
+	// The scene index, and a gradient mirrored horizontally in odd scenes which moves on every frame
+	const std::string scene = sceneLength > 0 ? "N " + std::to_string(sceneLength) + " / floor" : "0";
+	const std::string gradient = "X " + scene + " 2 % " + std::to_string(width - 1) + " X 2 * - * + Y + N 4 * + " + scene + " 97 * + 256 % {peak} 255 / *";
+	// Bit X / block of 2N on even lines and 2N + 1 on odd ones
+	const std::string bit = "N 2 * Y 2 % + 2 X " + std::to_string(block) + " / floor pow / floor 2 %";
+	const std::string expr = "Y " + std::to_string(ID_ROWS) + " < X " + std::to_string(block * ID_BITS) + " < " + bit + " {peak} * 0 ? " + gradient + " ?";
+	return
+		"import vapoursynth as vs\n"
+		"core = vs.core\n"
+		"\n"
+		"# Synthetic telecined clip generated by IVTC DN\n"
+		"field_count = " + std::to_string(FieldCount()) + "\n"
+		"# (field, position in the telecined film) where the clip starts or continues after a cut\n"
+		"segments = " + PairList(plan.segments) + "\n"
+		"# (field, source field) of fields replaced by an orphan\n"
+		"orphans = " + PairList(plan.orphans) + "\n"
+		"pattern = [0, 1, 2, 3, 2, 5, 4, 7, 6, 7]\n"
+		"\n"
+		"offsets = []\n"
+		"for (start, position), (end, _) in zip(segments, segments[1:] + [(field_count, 0)]):\n"
+		"    offsets += [8 * (k // 10) + pattern[k % 10] for k in range(position, position + end - start)]\n"
+		"for field, source in orphans:\n"
+		"    offsets[field] = source\n"
+		"\n"
+		"clip = core.std.BlankClip(format=vs." + format +
+		", width=" + std::to_string(width) +
+		", height=" + std::to_string(height) +
+		", length=" + std::to_string(plan.progressiveFrames) + ", fpsnum=24000, fpsden=1001)\n"
+		"peak = (1 << clip.format.bits_per_sample) - 1 if clip.format.sample_type == vs.INTEGER else 1\n"
+		"clip = core.std.Expr(clip, ['" + expr + "'.format(peak=peak), ''])\n"
+		"fields = core.std.SeparateFields(clip, tff=True)\n"
+		"fields = core.std.SelectEvery(fields, cycle=fields.num_frames, offsets=offsets, modify_duration=False)\n"
+		"fields = core.std.AssumeFPS(fields, fpsnum=60000, fpsden=1001)\n"
+		"clip = core.std.DoubleWeave(fields, tff=True)[::2]\n"
+		"clip = core.std.SetFieldBased(clip, 2)\n"
+		"clip.set_output()\n";
+}
+
+std::string SyntheticClip::Validate() const {
+	if (width < ID_BITS * 2 || height < 16) {
+		return "width must be at least " + std::to_string(ID_BITS * 2) + " and height at least 16";
+	}
+	// Fields of 4:2:0 clips must still have an even height
+	if (width % 2 || height % 4) {
+		return "width must be a multiple of 2 and height a multiple of 4";
+	}
+	if (cycles < 1 || cycles > MAX_CYCLES) {
+		return "clip must have between 1 and " + std::to_string(MAX_CYCLES) + " cycles";
+	}
+	if (patternBreakInterval < 0 || orphanInterval < 0 || sceneLength < 0) {
+		return "intervals and scene length can't be negative";
+	}
+	if (format.empty() || !std::all_of(format.begin(), format.end(), [](char c) { return std::isalnum((unsigned char)c); })) {
+		return "format must be a VapourSynth preset name such as YUV420P8";
+	}
+	return "";
+}
+
+nlohmann::json SyntheticClip::Project(const std::string& scriptFile) const {
+	const Plan plan = MakePlan();
+	const int fieldCount = FieldCount();
+	nlohmann::json project = NewProject(scriptFile, fieldCount);
+	nlohmann::json& actions = project["ivtc_actions"];
+	nlohmann::json& notes = project["project_garbage"]["notes"];
+
+	struct Frame {
+		int frame;
+		// First field of each parity within the cycle, -1 if it has none
+		int fields[2];
+	};
+	bool completedPrevious = false;
+	for (int first = 0; first < fieldCount; first += 10) {
+		std::vector<Frame> frames;
+		for (int field = first; field < first + 10; field++) {
+			const int frame = plan.sourceFields[field] / 2;
+			auto it = std::find_if(frames.begin(), frames.end(), [frame](const Frame& f) { return f.frame == frame; });
+			if (it == frames.end()) {
+				it = frames.insert(frames.end(), { frame, { -1, -1 } });
+			}
+			notes[field] = std::string(1, (char)('A' + std::min((int)(it - frames.begin()), 25)));
+			if (field == first && completedPrevious) {
+				continue;
+			}
+			int& slot = it->fields[plan.sourceFields[field] % 2];
+			slot = slot < 0 ? field : slot;
+			actions[field] = ACTION_DROP;
+		}
+
+		// Whole frames in the order they appear, fields without a partner (or beyond the 4th frame) are dropped
+		int output = 0;
+		for (const Frame& frame : frames) {
+			if (frame.fields[0] >= 0 && frame.fields[1] >= 0 && output < 4) {
+				actions[frame.fields[0]] = 2 * output;
+				actions[frame.fields[1]] = 2 * output + 1;
+				output++;
+			}
+		}
+
+		// The last frame can take its top field from the first field of the next cycle
+		completedPrevious = false;
+		const Frame& last = frames.back();
+		if (output == 3 && first + 10 < fieldCount && last.fields[0] < 0 && last.fields[1] >= 0 && plan.sourceFields[first + 10] == last.frame * 2) {
+			actions[last.fields[1]] = 7;
+			actions[first + 10] = ACTION_COMPLETE_PREVIOUS_CYCLE;
+			completedPrevious = true;
+		}
+	}
+
+	// Orphans are single frames of their own and don't interrupt a scene
+	nlohmann::json& sceneChanges = project["project_garbage"]["scene_changes"];
+	const int filmFrames = plan.progressiveFrames - (int)plan.orphans.size();
+	int previousScene = 0;
+	for (int field = 0; sceneLength > 0 && field < fieldCount; field++) {
+		const int frame = plan.sourceFields[field] / 2;
+		if (frame >= filmFrames) {
+			continue;
+		}
+		const int scene = frame / sceneLength;
+		if (scene != previousScene) {
+			sceneChanges.push_back(field);
+			previousScene = scene;
+		}
+	}
+	return project;
+}
+
+int SyntheticClip::ReadFieldId(const uint8_t* row, const int width, const int pixelStride) {
+	const int block = width / ID_BITS;
+	if (block < 2) {
+		return -1;
+	}
+	int id = 0;
+	for (int bit = 0; bit < ID_BITS; bit++) {
+		// The middle of each block, clear of any ringing from scaling or chroma conversion at its edges
+		if (row[(size_t)(bit * block + block / 2) * pixelStride] >= 128) {
+			id |= 1 << bit;
+		}
+	}
+	return id;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "json.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// A generated 3:2 telecined clip, so benchmarks and regression checks don't depend on any source on disk. Everything
+// about it follows from its parameters, the same parameters always give the same clip.
+//
+// Each progressive frame is a diagonal gradient (mirrored every other scene) with a band of ID_ROWS lines at the top
+// holding its field IDs as ID_BITS black or white blocks, least significant first: 2 * frame on the top field's lines
+// and 2 * frame + 1 on the bottom field's. The clip's fields follow the usual AA BB BC CD DD pattern, cut every so often
+// to shift its phase as an edit would, and with the odd field replaced by one from a frame that appears nowhere else.
+struct SyntheticClip {
+	static const int ID_BITS = 24;
+	static const int ID_ROWS = 8;
+
+	int width = 720;
+	int height = 480;
+	std::string format = "YUV420P8";
+	int cycles = 2000;
+	// Cycles between cuts in the pattern, which skip an even number of telecined fields so field parity still
+	// alternates (0 for none)
+	int patternBreakInterval = 0;
+	// Cycles between orphan fields (0 for none)
+	int orphanInterval = 0;
+	// Progressive frames per scene (0 for one scene)
+	int sceneLength = 0;
+	// Decides where breaks and orphans fall within their cycles, and how far breaks skip
+	uint32_t seed = 1;
+
+	// Output frames of the telecined clip, each cycle is 10 fields
+	int FrameCount() const { return cycles * 5; }
+	int FieldCount() const { return cycles * 10; }
+
+	// Python for VSScript's evaluateBuffer, or to save as a .vpy
+	std::string Script() const;
+	// Returns an error message for parameters the script can't be built from, empty if they're fine
+	std::string Validate() const;
+
+	struct Plan {
+		// ID of the source field shown as each field of the clip
+		std::vector<int> sourceFields;
+		// Fields of the clip from which sourceFields continues the telecined stream at a position, pattern breaks
+		// start a new segment
+		std::vector<std::pair<int, int>> segments;
+		// Fields of the clip replaced by an orphan, and the orphan's ID
+		std::vector<std::pair<int, int>> orphans;
+		// Frames of the progressive clip, orphans come from the last ones
+		int progressiveFrames = 0;
+	};
+	Plan MakePlan() const;
+
+	// A project for the clip holding the right answer: actions pairing each frame's fields into output frames (with
+	// freeze frames where a cycle has fewer than 4 whole frames), notes lettering each cycle's source frames and the
+	// scene changes
+	nlohmann::json Project(const std::string& scriptFile) const;
+
+	// The field ID held by a row of the ID band of a field (or any row of a frame's band, for the field that row came
+	// from) in 8 bit samples pixelStride apart: luma, or the first channel of packed RGB. -1 for a clip too narrow to
+	// decode.
+	static int ReadFieldId(const uint8_t* row, int width, int pixelStride);
+};
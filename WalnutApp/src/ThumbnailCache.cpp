@@ -0,0 +1,236 @@
+#include "ThumbnailCache.h"
+#include "p2p_api.h"
+#include "vapoursynth/VapourSynth4.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+static const char THUMBNAIL_MAGIC[8] = {'I', 'V', 'T', 'C', 'T', 'H', 'M', 'B'};
+static const uint32_t THUMBNAIL_CACHE_VERSION = 1;
+
+// How long generation stays paused after the UI last requested frames, and the breather between thumbnails
+static const int64_t THUMBNAIL_INTERACTION_PAUSE_MS = 300;
+static const int THUMBNAIL_THROTTLE_MS = 2;
+
+struct ThumbnailHeader {
+	char magic[8];
+	uint32_t version;
+	uint32_t width;
+	uint32_t height;
+	uint32_t cycleCount;
+	uint64_t sourceStamp;
+};
+
+static int64_t NowMilliseconds() {
+	return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+ThumbnailCache::~ThumbnailCache() {
+	Close();
+}
+
+bool ThumbnailCache::Open(const std::string& path, int cycleCount, int width, int height, uint64_t sourceStamp) {
+	Close();
+	const size_t readyOffset = sizeof(ThumbnailHeader);
+	const size_t thumbnailsOffset = (readyOffset + cycleCount + 63) & ~(size_t)63;
+	const size_t size = thumbnailsOffset + (size_t)cycleCount * width * height * 3;
+	if (cycleCount <= 0) {
+		return false;
+	}
+	if (path.empty()) {
+		// Zeroed, so the header never matches and everything is generated
+		m_Memory.assign(size, 0);
+		m_Data = m_Memory.data();
+	} else if (m_File.Open(path, size)) {
+		m_Data = m_File.GetData();
+	} else {
+		return false;
+	}
+	m_Size = size;
+
+	ThumbnailHeader* header = (ThumbnailHeader*)m_Data;
+	const bool valid = memcmp(header->magic, THUMBNAIL_MAGIC, sizeof(THUMBNAIL_MAGIC)) == 0
+		&& header->version == THUMBNAIL_CACHE_VERSION
+		&& header->width == (uint32_t)width
+		&& header->height == (uint32_t)height
+		&& header->cycleCount == (uint32_t)cycleCount
+		&& header->sourceStamp == sourceStamp;
+	m_Ready = m_Data + readyOffset;
+	if (!valid) {
+		memcpy(header->magic, THUMBNAIL_MAGIC, sizeof(THUMBNAIL_MAGIC));
+		header->version = THUMBNAIL_CACHE_VERSION;
+		header->width = width;
+		header->height = height;
+		header->cycleCount = cycleCount;
+		header->sourceStamp = sourceStamp;
+		memset(m_Ready, 0, cycleCount);
+	}
+
+	m_ThumbnailsOffset = thumbnailsOffset;
+	m_CycleCount = cycleCount;
+	m_Width = width;
+	m_Height = height;
+	int ready = 0;
+	for (int cycle = 0; cycle < cycleCount; cycle++) {
+		ready += m_Ready[cycle] != 0;
+	}
+	m_ReadyCount = ready;
+	m_Failed.assign(cycleCount, 0);
+	m_FailedCount = 0;
+	return true;
+}
+
+void ThumbnailCache::Close() {
+	Stop();
+	m_File.Close();
+	m_Memory = std::vector<uint8_t>();
+	m_Data = nullptr;
+	m_Size = 0;
+	m_Ready = nullptr;
+	m_CycleCount = 0;
+	m_ReadyCount = 0;
+	m_Failed.clear();
+	m_FailedCount = 0;
+}
+
+bool ThumbnailCache::MoveToFile(const std::string& path) {
+	if (!IsInMemory()) {
+		return false;
+	}
+	// The generator writes through m_Data, so it's paused while the contents move
+	const bool generating = m_Thread.joinable();
+	JoinGenerator();
+	const bool moved = m_File.Open(path, m_Size);
+	if (moved) {
+		memcpy(m_File.GetData(), m_Memory.data(), m_Size);
+		m_Ready = m_File.GetData() + (m_Ready - m_Data);
+		m_Data = m_File.GetData();
+		m_Memory = std::vector<uint8_t>();
+		m_File.Flush();
+	}
+	if (generating && m_Node) {
+		m_StopRequested = false;
+		m_Thread = std::thread(&ThumbnailCache::Generate, this);
+	}
+	return moved;
+}
+
+void ThumbnailCache::StartGenerating(const VSAPI* vsapi, VSNode* thumbnailNode) {
+	Stop();
+	if (!IsOpen() || m_ReadyCount + m_FailedCount == m_CycleCount) {
+		return;
+	}
+	m_VSAPI = vsapi;
+	m_Node = vsapi->addNodeRef(thumbnailNode);
+	m_StopRequested = false;
+	m_ScanCursor = 0;
+	m_Thread = std::thread(&ThumbnailCache::Generate, this);
+}
+
+void ThumbnailCache::JoinGenerator() {
+	m_StopRequested = true;
+	if (m_Thread.joinable()) {
+		m_Thread.join();
+	}
+}
+
+void ThumbnailCache::Stop() {
+	JoinGenerator();
+	if (m_Node) {
+		m_VSAPI->freeNode(m_Node);
+		m_Node = nullptr;
+	}
+	if (m_File.IsOpen()) {
+		m_File.Flush();
+	}
+}
+
+void ThumbnailCache::NotifyInteraction() {
+	m_LastInteraction = NowMilliseconds();
+}
+
+void ThumbnailCache::Prioritise(int firstCycle, int lastCycle, int step) {
+	std::lock_guard<std::mutex> lock(m_PriorityMutex);
+	m_Priority.clear();
+	for (int cycle = std::max(firstCycle, 0); cycle <= lastCycle && cycle < m_CycleCount; cycle += step) {
+		if (!IsReady(cycle)) {
+			m_Priority.push_back(cycle);
+		}
+	}
+	// Consumed from the back, left to right
+	std::reverse(m_Priority.begin(), m_Priority.end());
+}
+
+const uint8_t* ThumbnailCache::GetThumbnail(int cycle) const {
+	if (cycle < 0 || cycle >= m_CycleCount || !IsReady(cycle)) {
+		m_Misses++;
+		return nullptr;
+	}
+	m_Hits++;
+	return ThumbnailData(cycle);
+}
+
+uint8_t* ThumbnailCache::ThumbnailData(int cycle) const {
+	return m_Data + m_ThumbnailsOffset + (size_t)cycle * m_Width * m_Height * 3;
+}
+
+bool ThumbnailCache::IsReady(int cycle) const {
+	return std::atomic_ref<uint8_t>(m_Ready[cycle]).load(std::memory_order_acquire) != 0;
+}
+
+int ThumbnailCache::NextCycle() {
+	std::lock_guard<std::mutex> lock(m_PriorityMutex);
+	while (!m_Priority.empty()) {
+		const int cycle = m_Priority.back();
+		m_Priority.pop_back();
+		if (!IsReady(cycle) && !m_Failed[cycle]) {
+			return cycle;
+		}
+	}
+	while (m_ScanCursor < m_CycleCount && (IsReady(m_ScanCursor) || m_Failed[m_ScanCursor])) {
+		m_ScanCursor++;
+	}
+	return m_ScanCursor < m_CycleCount ? m_ScanCursor : -1;
+}
+
+void ThumbnailCache::Generate() {
+	char error_message[1024];
+	while (!m_StopRequested) {
+		if (NowMilliseconds() - m_LastInteraction < THUMBNAIL_INTERACTION_PAUSE_MS) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(20));
+			continue;
+		}
+		const int cycle = NextCycle();
+		if (cycle < 0) {
+			break;
+		}
+
+		// The first top field stands in for the whole cycle, it's only there to recognise the scene
+		const VSFrame* frame = m_VSAPI->getFrame(cycle * 10, m_Node, error_message, sizeof(error_message));
+		if (!frame) {
+			// Left as a placeholder, one bad frame shouldn't stop the rest of the timeline
+			fprintf(stderr, "Thumbnail for cycle %d: %s\n", cycle, error_message);
+			m_Failed[cycle] = 1;
+			m_FailedCount++;
+			continue;
+		}
+		p2p_buffer_param p = {};
+		p.packing = p2p_rgb24_be;
+		p.width = m_Width;
+		p.height = m_Height;
+		p.dst[0] = ThumbnailData(cycle);
+		p.dst_stride[0] = m_Width * 3;
+		for (int plane = 0; plane < 3; plane++) {
+			p.src[plane] = m_VSAPI->getReadPtr(frame, plane);
+			p.src_stride[plane] = m_VSAPI->getStride(frame, plane);
+		}
+		p2p_pack_frame(&p, 0);
+		m_VSAPI->freeFrame(frame);
+
+		std::atomic_ref<uint8_t>(m_Ready[cycle]).store(1, std::memory_order_release);
+		m_ReadyCount++;
+		std::this_thread::sleep_for(std::chrono::milliseconds(THUMBNAIL_THROTTLE_MS));
+	}
+}
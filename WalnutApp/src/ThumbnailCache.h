@@ -0,0 +1,92 @@
+#pragma once
+
+#include "MappedFile.h"
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct VSAPI;
+struct VSNode;
+
+static const int THUMBNAIL_WIDTH = 48;
+
+// One RGB24 thumbnail per cycle, kept in a memory mapped file next to the project so reopening it doesn't regenerate anything
+// (or in memory until a new project is saved).
+// A single background thread fills in missing thumbnails one frame request at a time, visible cycles first, and backs off
+// whenever the UI is fetching fields itself so the timeline never slows down navigation.
+class ThumbnailCache {
+public:
+	~ThumbnailCache();
+
+	// Maps (creating or resetting as needed) the cache file, or keeps the cache in memory when path is empty. sourceStamp
+	// identifies the script revision the thumbnails were generated from, anything cached for a different stamp or size
+	// is thrown away.
+	bool Open(const std::string& path, int cycleCount, int width, int height, uint64_t sourceStamp);
+	void Close();
+	// Moves an in memory cache to a file once there's somewhere to put it, generation carries on into the file
+	bool MoveToFile(const std::string& path);
+
+	// Takes its own reference to thumbnailNode, which must be a width x height RGB24 clip of separated fields
+	void StartGenerating(const VSAPI* vsapi, VSNode* thumbnailNode);
+	void Stop();
+
+	// Generation pauses for a moment after every call so interactive frame requests get the core to themselves
+	void NotifyInteraction();
+	// Cycles to generate before anything else, replaces any earlier request
+	void Prioritise(int firstCycle, int lastCycle, int step);
+
+	bool IsOpen() const { return m_Data != nullptr; }
+	bool IsInMemory() const { return IsOpen() && !m_File.IsOpen(); }
+	int GetCycleCount() const { return m_CycleCount; }
+	int GetWidth() const { return m_Width; }
+	int GetHeight() const { return m_Height; }
+	int GetReadyCount() const { return m_ReadyCount; }
+	// Cycles whose field couldn't be fetched this session, they stay placeholders rather than being retried
+	int GetFailedCount() const { return m_FailedCount; }
+	size_t GetFileBytes() const { return m_File.GetSize(); }
+	size_t GetMemoryBytes() const { return m_Memory.capacity(); }
+	bool IsGenerating() const { return m_Node != nullptr; }
+	// GetThumbnail() calls which found a thumbnail, and which didn't
+	uint64_t GetHits() const { return m_Hits; }
+	uint64_t GetMisses() const { return m_Misses; }
+
+	// width * height * 3 bytes of packed RGB, or nullptr if the thumbnail hasn't been generated yet
+	const uint8_t* GetThumbnail(int cycle) const;
+private:
+	void Generate();
+	void JoinGenerator();
+	int NextCycle();
+	uint8_t* ThumbnailData(int cycle) const;
+	bool IsReady(int cycle) const;
+
+	MappedFile m_File;
+	std::vector<uint8_t> m_Memory;
+	// The mapped file or m_Memory
+	uint8_t* m_Data = nullptr;
+	size_t m_Size = 0;
+	uint8_t* m_Ready = nullptr;
+	size_t m_ThumbnailsOffset = 0;
+	int m_CycleCount = 0;
+	int m_Width = 0;
+	int m_Height = 0;
+
+	const VSAPI* m_VSAPI = nullptr;
+	VSNode* m_Node = nullptr;
+	std::thread m_Thread;
+	std::atomic<bool> m_StopRequested = false;
+	std::atomic<int64_t> m_LastInteraction = 0;
+	std::atomic<int> m_ReadyCount = 0;
+	std::atomic<int> m_FailedCount = 0;
+	// Only touched by the generator thread, or while it isn't running
+	std::vector<uint8_t> m_Failed;
+	mutable uint64_t m_Hits = 0;
+	mutable uint64_t m_Misses = 0;
+
+	std::mutex m_PriorityMutex;
+	std::vector<int> m_Priority;
+	int m_ScanCursor = 0;
+};
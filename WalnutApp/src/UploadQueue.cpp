@@ -0,0 +1,82 @@
+#include "UploadQueue.h"
+
+#include <algorithm>
+#include <chrono>
+
+using nlohmann::json;
+
+json UploadBudget::ToJson() const {
+	return {
+		{"milliseconds", milliseconds},
+		{"megabytes", megabytes},
+	};
+}
+
+UploadBudget UploadBudget::FromJson(const json& object, const UploadBudget& defaults) {
+	UploadBudget budget = defaults;
+	if (!object.is_object()) {
+		return budget;
+	}
+	budget.milliseconds = std::max(0.0f, object.value("milliseconds", defaults.milliseconds));
+	budget.megabytes = std::max(0, object.value("megabytes", defaults.megabytes));
+	return budget;
+}
+
+void UploadQueue::Push(const int key, const UploadPriority priority, const size_t bytes, std::function<void()>&& upload) {
+	for (auto it = m_Entries.begin(); it != m_Entries.end(); ++it) {
+		if (it->key == key) {
+			m_Entries.erase(it);
+			m_Stats.replaced++;
+			break;
+		}
+	}
+	m_Entries.push_back({ key, priority, m_Sequence++, bytes, std::move(upload) });
+}
+
+void UploadQueue::Run(const UploadBudget& budget) {
+	using Clock = std::chrono::steady_clock;
+	const Clock::time_point start = Clock::now();
+	const double budgetNanoseconds = budget.milliseconds * 1e6;
+	const size_t budgetBytes = (size_t)budget.megabytes << 20;
+
+	m_Stats.uploads = 0;
+	m_Stats.bytes = 0;
+	while (!m_Entries.empty()) {
+		// There are only ever a few dozen slots waiting, a scan is cheaper than keeping them ordered
+		auto next = std::min_element(m_Entries.begin(), m_Entries.end(), [](const Entry& a, const Entry& b) {
+			return a.priority != b.priority ? a.priority < b.priority : a.sequence < b.sequence;
+		});
+		if (m_Stats.uploads > 0) {
+			const double elapsed = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+			const double predicted = m_RecentBytes > 0.0 ? next->bytes * m_RecentNanoseconds / m_RecentBytes : 0.0;
+			if (elapsed + predicted > budgetNanoseconds || m_Stats.bytes + next->bytes > budgetBytes) {
+				break;
+			}
+		}
+
+		const size_t bytes = next->bytes;
+		std::function<void()> upload = std::move(next->upload);
+		m_Entries.erase(next);
+		const Clock::time_point uploadStart = Clock::now();
+		upload();
+		const double nanoseconds = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - uploadStart).count();
+		// Decayed totals rather than an average of rates, so small uploads dominated by fixed costs don't skew it
+		m_RecentNanoseconds = m_RecentNanoseconds * 0.75 + nanoseconds;
+		m_RecentBytes = m_RecentBytes * 0.75 + bytes;
+		m_Stats.uploads++;
+		m_Stats.bytes += bytes;
+	}
+	m_Stats.milliseconds = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count() / 1000.0f;
+}
+
+void UploadQueue::Clear() {
+	m_Entries.clear();
+}
+
+size_t UploadQueue::GetQueuedBytes() const {
+	size_t bytes = 0;
+	for (const Entry& entry : m_Entries) {
+		bytes += entry.bytes;
+	}
+	return bytes;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "json.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// How much of each UI frame the upload queue may spend. The first upload of a frame always runs, so one larger than
+// the whole budget still goes up.
+struct UploadBudget {
+	float milliseconds = 4.0f;
+	int megabytes = 64;
+
+	nlohmann::json ToJson() const;
+	// Missing attributes keep the values in defaults
+	static UploadBudget FromJson(const nlohmann::json& object, const UploadBudget& defaults);
+};
+
+enum UploadPriority {
+	UPLOAD_ON_SCREEN,
+	// Images in hidden windows, which only need to be current once they're shown
+	UPLOAD_OFF_SCREEN,
+	UPLOAD_PRIORITY_COUNT,
+};
+
+// Uploads to GPU images waiting for the UI thread, run a few at a time so a batch of large fields arriving at once is
+// spread over several UI frames instead of stalling one. Uploads run by priority then in the order they were pushed,
+// until the frame's time or byte budget would be exceeded going by how fast recent uploads went. Each upload has a key
+// (the slot it fills) and pushing another for the same key replaces the one waiting, so only the latest contents of a
+// slot are ever uploaded.
+class UploadQueue {
+public:
+	// upload runs on the UI thread, or is destroyed without running when replaced or cleared. It must own whatever it
+	// uploads from.
+	void Push(int key, UploadPriority priority, size_t bytes, std::function<void()>&& upload);
+	// Runs queued uploads within the budget, call once per UI frame
+	void Run(const UploadBudget& budget);
+	void Clear();
+
+	size_t GetQueueLength() const { return m_Entries.size(); }
+	size_t GetQueuedBytes() const;
+
+	struct Stats {
+		// Uploads and bytes of the last Run, and how long they took
+		int uploads = 0;
+		size_t bytes = 0;
+		float milliseconds = 0.0f;
+		// Uploads replaced by a newer one for the same slot before running
+		uint64_t replaced = 0;
+	};
+	const Stats& GetStats() const { return m_Stats; }
+private:
+	struct Entry {
+		int key;
+		UploadPriority priority;
+		uint64_t sequence;
+		size_t bytes;
+		std::function<void()> upload;
+	};
+
+	std::vector<Entry> m_Entries;
+	uint64_t m_Sequence = 0;
+	// Recent upload cost, for deciding whether the next upload still fits in the frame
+	double m_RecentNanoseconds = 0.0;
+	double m_RecentBytes = 0.0;
+	Stats m_Stats;
+};
@@ -0,0 +1,93 @@
+#include "VSScriptLibrary.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <future>
+#include <mutex>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <dlfcn.h>
+#endif
+
+// From vapoursynth sdk's vsscript_example.c
+typedef VS_CC const VSSCRIPTAPI *(*getVSScriptAPIType)(int);
+typedef VS_CC const char *(*getVSScriptAPILastErrorType)();
+
+static getVSScriptAPIType getVSScriptAPIFunc = NULL;
+static getVSScriptAPILastErrorType getVSScriptAPILastErrorFunc = NULL;
+
+static int loadVSScriptLibrary() {
+#ifdef _WIN32
+    const wchar_t *vsscriptPath = _wgetenv(L"VSSCRIPT_PATH");
+    HMODULE lib = LoadLibraryExW(vsscriptPath ? vsscriptPath : L"VSScript.dll", NULL, LOAD_WITH_ALTERED_SEARCH_PATH);
+    if (!lib) {
+        fprintf(stderr, "Failed to load VSScript library");
+        return 1;
+    }
+    getVSScriptAPIFunc = (getVSScriptAPIType)GetProcAddress(lib, "getVSScriptAPI");
+    getVSScriptAPILastErrorFunc = (getVSScriptAPILastErrorType)GetProcAddress(lib, "getVSScriptAPILastError");
+    if (!getVSScriptAPIFunc || !getVSScriptAPILastErrorFunc) {
+        fprintf(stderr, "Failed to locate entry points in VSScript library");
+        return 1;
+    }
+    return 0;
+#else
+    const char *vsscriptPath = getenv("VSSCRIPT_PATH");
+#ifdef __APPLE__
+    const char *defaultLibName = "libvsscript.4.dylib";
+#else
+    const char *defaultLibName = "libvsscript.so.4";
+#endif
+    void *lib = dlopen(vsscriptPath ? vsscriptPath : defaultLibName, RTLD_LAZY | RTLD_GLOBAL);
+    if (!lib) {
+        fprintf(stderr, "Failed to load VSScript library: %s\n", dlerror());
+        return 1;
+    }
+    getVSScriptAPIFunc = (getVSScriptAPIType)dlsym(lib, "getVSScriptAPI");
+    getVSScriptAPILastErrorFunc = (getVSScriptAPILastErrorType)dlsym(lib, "getVSScriptAPILastError");
+    if (!getVSScriptAPIFunc || !getVSScriptAPILastErrorFunc) {
+        fprintf(stderr, "Failed to locate entry points in VSScript library: %s\n", dlerror());
+        return 1;
+    }
+    return 0;
+
+#endif
+}
+
+static std::once_flag s_StartOnce;
+static std::shared_future<const VSSCRIPTAPI*> s_API;
+static double s_LoadMilliseconds = 0.0;
+
+static const VSSCRIPTAPI* LoadVSScriptAPI() {
+	const auto start = std::chrono::steady_clock::now();
+	const VSSCRIPTAPI* api = loadVSScriptLibrary() == 0 ? getVSScriptAPIFunc(VSSCRIPT_API_VERSION) : nullptr;
+	s_LoadMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	return api;
+}
+
+// Whichever of the preload and the first GetVSScriptAPI comes first decides where loading runs
+static void StartLoading(const std::launch policy) {
+	std::call_once(s_StartOnce, [policy]() { s_API = std::async(policy, LoadVSScriptAPI).share(); });
+}
+
+const VSSCRIPTAPI* GetVSScriptAPI() {
+	StartLoading(std::launch::deferred);
+	return s_API.get();
+}
+
+void PreloadVSScriptAPI() {
+	StartLoading(std::launch::async);
+}
+
+bool IsVSScriptAPIReady() {
+	StartLoading(std::launch::deferred);
+	return s_API.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
+double GetVSScriptLoadMilliseconds() {
+	return IsVSScriptAPIReady() ? s_LoadMilliseconds : 0.0;
+}
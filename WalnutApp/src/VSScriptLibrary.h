@@ -0,0 +1,12 @@
+#pragma once
+
+#include "vapoursynth/VSScript4.h"
+
+// Loads the VSScript library on first use (honouring VSSCRIPT_PATH) and returns its API, or nullptr if VapourSynth isn't
+// available. Waits for a load PreloadVSScriptAPI started if it hasn't finished yet.
+const VSSCRIPTAPI* GetVSScriptAPI();
+// Starts loading the library and initialising Python on a background thread, so it overlaps with window setup
+void PreloadVSScriptAPI();
+bool IsVSScriptAPIReady();
+// How long loading took, wherever it ran, once it's ready
+double GetVSScriptLoadMilliseconds();
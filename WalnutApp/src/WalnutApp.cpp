@@ -1,21 +1,42 @@
 #define NOMINMAX
 
-#include "p2p.h"
-#include "p2p_api.h"
+#include "AppSettings.h"
+#include "CommandLine.h"
+#include "CoreGovernor.h"
+#include "CycleGrid.h"
+#include "CycleStatus.h"
+#include "FrameUpload.h"
+#include "MatchMetrics.h"
+#include "NoteAnalysis.h"
+#include "PatternTrack.h"
+#include "ProjectFile.h"
+#include "ReloadScheduler.h"
+#include "SceneDetection.h"
+#include "ScriptGraph.h"
+#include "ScriptLoader.h"
+#include "ScriptWatcher.h"
+#include "ThumbnailCache.h"
+#include "UploadQueue.h"
+#include "VSScriptLibrary.h"
+#include "Y4MExport.h"
 #include "gzip/compress.hpp"
-#include "gzip/decompress.hpp"
 #include "ImGuiFileDialog.h"
 #include "json.hpp"
 #include "vapoursynth/VSScript4.h"
 #include "vapoursynth/VSHelper4.h"
 #include "Walnut/Image.h"
+#include "Walnut/JobSystem.h"
 #include "Walnut/Application.h"
 #include "Walnut/EntryPoint.h"
 
 //#include <format>
+#include <chrono>
+#include <filesystem>
 #include <fstream>
 #include <GLFW/glfw3.h> // For drag-n-drop files
 #include <iostream>
+#include <map>
+#include <unordered_map>
 
 #include "icon.h"
 #include "imgui_stdlib.h"
@@ -24,50 +45,13 @@ using nlohmann::json;
 
 ImFont* g_UbuntuMonoFont = nullptr;
 
-// From vapoursynth sdk's vsscript_example.c
-typedef VS_CC const VSSCRIPTAPI *(*getVSScriptAPIType)(int);
-typedef VS_CC const char *(*getVSScriptAPILastErrorType)();
-
-getVSScriptAPIType getVSScriptAPIFunc = NULL;
-getVSScriptAPILastErrorType getVSScriptAPILastErrorFunc = NULL;
-
-static int loadVSScriptLibrary() {
-#ifdef _WIN32
-    const wchar_t *vsscriptPath = _wgetenv(L"VSSCRIPT_PATH");
-    HMODULE lib = LoadLibraryExW(vsscriptPath ? vsscriptPath : L"VSScript.dll", NULL, LOAD_WITH_ALTERED_SEARCH_PATH);
-    if (!lib) {
-        fprintf(stderr, "Failed to load VSScript library");
-        return 1;
-    }
-    getVSScriptAPIFunc = (getVSScriptAPIType)GetProcAddress(lib, "getVSScriptAPI");
-    getVSScriptAPILastErrorFunc = (getVSScriptAPILastErrorType)GetProcAddress(lib, "getVSScriptAPILastError");
-    if (!getVSScriptAPIFunc || !getVSScriptAPILastErrorFunc) {
-        fprintf(stderr, "Failed to locate entry points in VSScript library");
-        return 1;
-    }
-    return 0;
-#else
-    const char *vsscriptPath = getenv(L"VSSCRIPT_PATH");
-#ifdef __APPLE__
-    const char *defaultLibName = "libvsscript.4.dylib";
-#else
-    const char *defaultLibName = "libvsscript.so.4";
-#endif
-    void *lib = dlopen(vsscriptPath ? vsscriptPath : defaultLibName, RTLD_LAZY | RTLD_GLOBAL);
-    if (!lib) {
-        fprintf(stderr, "Failed to load VSScript library: %s\n", dlerror());
-        return 1;
-    }
-    getVSScriptAPIFunc = (getVSScriptAPIType)dlsym(lib, "getVSScriptAPI");
-    getVSScriptAPILastErrorFunc = (getVSScriptAPILastErrorType)dlsym(lib, "getVSScriptAPILastError");
-    if (!getVSScriptAPIFunc || !getVSScriptAPILastErrorFunc) {
-        fprintf(stderr, "Failed to locate entry points in VSScript library: %s\n", dlerror());
-        return 1;
-    }
-    return 0;
-
-#endif
-}
+// Written by Resources > Memory accounting > Save report, next to IVTCDN.json
+static const char* MEMORY_REPORT_FILE = "IVTCDN-memory.json";
+
+// Upload queue keys, one per image slot: 11 fields, 4 output frames and the grid's rows
+static const int FIELD_UPLOAD_KEY = 0;
+static const int FRAME_UPLOAD_KEY = 16;
+static const int GRID_UPLOAD_KEY = 32;
 
 // Helper to display a little (?) mark which shows a tooltip when hovered.
 // In your own code you may want to display an actual icon if you are using a merged icon fonts (see docs/FONTS.md)
@@ -102,6 +86,30 @@ static ImU32 ColorForAction(const int_fast8_t action) {
 	return map.at(action);
 }
 
+static ImU32 CycleStatusColor(const int lane) {
+	static const ImU32 colors[CYCLE_STATUS_FLAG_COUNT] = {
+		IM_COL32(255, 220, 0, 255), // Pattern deviation
+		IM_COL32(255, 128, 0, 255), // Single field
+		IM_COL32(255, 48, 48, 255), // Freeze frame
+		IM_COL32(80, 160, 255, 255), // No match override
+		IM_COL32(200, 100, 255, 255), // Note deviation
+		IM_COL32(80, 220, 120, 255), // Extra attributes
+	};
+	return colors[lane];
+}
+
+static const char* CycleStatusLabel(const int lane) {
+	static const char* labels[CYCLE_STATUS_FLAG_COUNT] = {
+		"Deviates from scene pattern",
+		"Single field frame",
+		"Freeze frame",
+		"No match override",
+		"Notes deviate from scene pattern",
+		"Extra attributes",
+	};
+	return labels[lane];
+}
+
 struct TextCallbackData {
 	const int activeFrame;
 	void* layer;
@@ -120,10 +128,52 @@ public:
 		io.ConfigFlags &= ~ImGuiConfigFlags_NavEnableKeyboard;
 	}
 
+	// Runs before the application shuts the job system and the device down, so everything using them stops here
+	virtual void OnDetach() override {
+		m_Exporter.Cancel();
+		m_ScriptLoader.Cancel();
+		m_ScriptWatcher.Stop();
+		m_Reloads.Drain(m_VSAPI);
+		m_Uploads.Clear();
+		m_CycleGrid.Close();
+		m_CoreGovernor.Detach();
+		m_MatchMetricLoader.CancelAndWait(m_InteractivePool);
+		m_NoteAnalyser.CancelAndWait(m_WorkerPool);
+		m_SceneDetector.CancelAndWait(m_WorkerPool);
+		m_ThumbnailCache.Close();
+		m_InteractivePool.Stop();
+		m_WorkerPool.Stop();
+
+		for (auto& image : m_Fields) {
+			image = nullptr;
+		}
+		for (auto& image : m_Frames) {
+			image = nullptr;
+		}
+		for (auto& image : m_GridImages) {
+			image = nullptr;
+		}
+		m_TimelineStrip = nullptr;
+	}
+
 	virtual void OnUIRender() override {
 		ImGuiIO& io = ImGui::GetIO();
 		static int error = 0;
-		static char error_message[1024];
+
+		if (m_ScriptLoader.IsReady()) {
+			FinishLoad();
+		}
+		// From the second frame, so it follows the timings Walnut prints once the first one is presented
+		if (m_ReportVSScriptTiming && ImGui::GetFrameCount() > 1 && IsVSScriptAPIReady()) {
+			fprintf(stderr, "  %-22s %8.1f ms (background)\n", "vsscript", GetVSScriptLoadMilliseconds());
+			m_ReportVSScriptTiming = false;
+		}
+		// Polled regardless so edits made while a reload is evaluating restart it rather than being missed
+		if (m_ScriptWatcher.Poll() && m_WatchScript && m_ProjectOpened && (!m_ScriptLoader.IsLoading() || m_PendingReload)) {
+			ReloadScript();
+		}
+		m_CoreGovernor.Update();
+		UpdateBackgroundLimit();
 
 		if (ImGuiFileDialog::Instance()->Display("NewProjectDialog", ImGuiWindowFlags_NoCollapse, ImVec2(500, 400))) {
 			if (ImGuiFileDialog::Instance()->IsOk()) {
@@ -150,13 +200,26 @@ public:
 			ImGuiFileDialog::Instance()->Close();
 		}
 
+		if (ImGuiFileDialog::Instance()->Display("ExportY4MDialog", ImGuiWindowFlags_NoCollapse, ImVec2(500, 400))) {
+			if (ImGuiFileDialog::Instance()->IsOk()) {
+				StartExport(ImGuiFileDialog::Instance()->GetFilePathName());
+			}
+			ImGuiFileDialog::Instance()->Close();
+		}
+
 		if (ImGuiFileDialog::Instance()->IsOpened()) {
 			return;
 		}
 
 		static int last_cycle = -1;
-		m_NeedNewFields |= last_cycle != m_ActiveCycle;
+		if (last_cycle != m_ActiveCycle) {
+			m_Reloads.InvalidateFields();
+			m_Reloads.InvalidateFrames(false);
+		}
 		last_cycle = m_ActiveCycle;
+		if (m_Reloads.IsBusy() || m_CycleGrid.IsBusy() || m_Uploads.GetQueueLength() > 0) {
+			m_ThumbnailCache.NotifyInteraction();
+		}
 
 		int max_cycle = (m_FieldsFrameCount - 1) / 10;
 
@@ -169,6 +232,14 @@ public:
 				m_ActiveCycle--;
 			}
 
+			if (ImGui::IsKeyPressed(ImGuiKey_N) && !io.KeyCtrl) {
+				FindFlaggedCycle(true);
+			}
+
+			if (ImGui::IsKeyPressed(ImGuiKey_P)) {
+				FindFlaggedCycle(false);
+			}
+
 			if (ImGui::IsKeyPressed(ImGuiKey_R)) {
 				LoadFrames();
 			}
@@ -179,46 +250,39 @@ public:
 			}
 		}
 
-		if (m_WantNewFrames) {
-			LoadFrames();
+		if (m_FieldsScriptEnvironment && !error && m_Reloads.ShouldIssue()) {
+			IssueFetches();
 		}
-
-		ImGui::Begin("Fields");
-
-		int remaining_fields = m_FieldsFrameCount - (m_ActiveCycle * 10);
-		int fields_in_cycle = std::min(remaining_fields, 11);
-
-		for (int i = 0; i < fields_in_cycle; i++) {
-			if (m_Fields[i] == nullptr) {
+		for (const FetchedFrame& fetched : m_Reloads.Collect(m_VSAPI)) {
+			if (!fetched.frame) {
+				fprintf(stderr, "%s\n", fetched.error.c_str());
+				error = 1;
 				continue;
 			}
+			QueueFetched(fetched);
+		}
+		m_Uploads.Run(m_UploadBudget);
 
-			if (m_NeedNewFields && !error) {
-				const VSFrame* frame = m_VSAPI->getFrame(m_ActiveCycle * 10 + i, m_FieldsNode, error_message, sizeof(error_message));
-				if (!frame) {
-					fprintf(stderr, error_message);
-					error = 1;
-					continue;
-				}
-				uint8_t* imageBuffer = (uint8_t*)malloc(m_FieldsWidth * m_FieldsHeight * 4);
-				p2p_buffer_param p = {};
-				p.packing = p2p_rgba32_be;
-				p.width = m_FieldsWidth;
-				p.height = m_FieldsHeight;
-				p.dst[0] = imageBuffer;
-				p.dst_stride[0] = m_FieldsWidth * 4;
-				for (int plane = 0; plane < 3; plane++) {
-					p.src[plane] = m_VSAPI->getReadPtr(frame, plane);
-					p.src_stride[plane] = m_VSAPI->getStride(frame, plane);
-				}
-				p2p_pack_frame(&p, P2P_ALPHA_SET_ONE);
+		if (m_MatchMetrics && !error) {
+			LoadMatchMetrics();
+		}
 
-				m_Fields[i]->SetData(imageBuffer);
-				m_VSAPI->freeFrame(frame);
-				free(imageBuffer);
-			}
+		if (m_NoteAnalysisPending && !m_NoteAnalyser.IsRunning()) {
+			m_NoteAnalysisPending = false;
+			m_NoteSuggestions = m_NoteAnalyser.SuggestNotes(SceneChanges());
+			UpdateSceneSuggestions();
 		}
 
+		if (m_SceneDetectionPending && !m_SceneDetector.IsRunning()) {
+			m_SceneDetectionPending = false;
+			UpdateSceneChangeSuggestions();
+		}
+
+		m_FieldsVisible = ImGui::Begin("Fields");
+
+		int remaining_fields = m_FieldsFrameCount - (m_ActiveCycle * 10);
+		int fields_in_cycle = std::min(remaining_fields, 11);
+
 		if (ImGui::BeginTable("field table", 6, ImGuiTableFlags_PadOuterX)) {
 			ImGui::TableNextRow();
 			// Top Fields
@@ -231,6 +295,14 @@ public:
 				}
 			}
 
+			if (m_MatchMetrics) {
+				ImGui::TableNextRow();
+				for (int i = 0; i < fields_in_cycle; i += 2) {
+					ImGui::TableNextColumn();
+					DrawMatchMetrics(i);
+				}
+			}
+
 			ImGui::TableNextRow();
 			// Bottom Fields
 			for (int i = 1; i < std::min(fields_in_cycle, 10); i += 2) {
@@ -246,7 +318,7 @@ public:
 
 		ImGui::End();
 
-		ImGui::Begin("Output");
+		m_OutputVisible = ImGui::Begin("Output");
 
 		int frames_in_cycle = fields_in_cycle * 4 / 10;
 		if (ImGui::BeginTable("frame table", 4, ImGuiTableFlags_PadOuterX)) {
@@ -261,39 +333,6 @@ public:
 					break;
 				}
 
-				if (m_NeedNewFields && !error) {
-					const VSFrame* frame = m_VSAPI->getFrame(activeFrame, m_FramesNode, error_message, sizeof(error_message));
-					if (!frame) {
-						fprintf(stderr, error_message);
-						error = 1;
-						continue;
-					}
-					uint8_t* imageBuffer = (uint8_t*)malloc(m_FramesWidth * m_FramesHeight * 4);
-					p2p_buffer_param p = {};
-					p.packing = p2p_rgba32_be;
-					p.width = m_FramesWidth;
-					p.height = m_FramesHeight;
-					p.dst[0] = imageBuffer;
-					p.dst_stride[0] = m_FramesWidth * 4;
-					for (int plane = 0; plane < 3; plane++) {
-						p.src[plane] = m_VSAPI->getReadPtr(frame, plane);
-						p.src_stride[plane] = m_VSAPI->getStride(frame, plane);
-					}
-					p2p_pack_frame(&p, P2P_ALPHA_SET_ONE);
-					const VSMap* props = m_VSAPI->getFramePropertiesRO(frame);
-					int err = 0;
-					m_FieldCount[i] = m_VSAPI->mapGetInt(props, "IVTCDN_Fields", 0, &err);
-					const char* freezeFrameProp = m_VSAPI->mapGetData(props, "IVTCDN_FreezeFrame", 0, &err);
-					std::string freezeFrame = err ? "" : freezeFrameProp;
-					m_Frames[i]->SetData(imageBuffer);
-					m_FreezeFrames[i] = freezeFrame;
-					if (m_VSAPI->mapNumElements(props, "VMetrics") == 2) {
-						const int64_t* vmetrics = m_VSAPI->mapGetIntArray(props, "VMetrics", &err);
-						m_CombedMetrics[i] = err ? -1 : vmetrics[1];
-					}
-					m_VSAPI->freeFrame(frame);
-					free(imageBuffer);
-				}
 				ImGui::TableNextColumn();
 				float frameDisplayWidth = ImGui::GetContentRegionAvail().x;
 				float frameDisplayHeight = m_FramesWidth ? frameDisplayWidth * ((float)m_FramesHeight / m_FramesWidth) : 0;
@@ -338,6 +377,14 @@ public:
 
 		ImGui::End();
 
+		DrawNoteSuggestions();
+		DrawTimeline();
+		DrawGrid();
+		DrawSceneChangeSuggestions();
+		DrawExport();
+		DrawScriptLoader();
+		DrawResources();
+
 		ImGui::Begin("Navigation");
 		ImGui::SliderInt("Active Cycle", &m_ActiveCycle, 0, max_cycle, nullptr, ImGuiSliderFlags_AlwaysClamp);
 		ImGui::SameLine(); HelpMarker("CTRL+click to input value.");
@@ -357,22 +404,20 @@ public:
 			NewProjectDialog();
 		}
 
-		m_NeedNewFields = false;
 	}
 
-	ExampleLayer() {
-		loadVSScriptLibrary();
-		m_VSSAPI = getVSScriptAPIFunc(VSSCRIPT_API_VERSION);
-		if (!m_VSSAPI) {
-			// VapourSynth probably isn't properly installed at all
-			fprintf(stderr, "Failed to initialize VSScript library\n");
+	// VSScript is loaded in the background from launch (see PreloadVSScriptAPI) and only waited for by the first project
+	// uploadYUV opts in to converting YUV sources on the GPU, which hasn't been verified on enough drivers to replace packing
+	// them on the CPU yet (see --check-yuv)
+	ExampleLayer(const bool startupTiming = false, const bool uploadYUV = false) : m_StartupTiming(startupTiming), m_ReportVSScriptTiming(startupTiming) {
+		const json appSettings = ReadAppSettings();
+		m_DefaultCoreSettings = CoreSettings::FromJson(appSettings.value("core", json::object()), CoreSettings());
+		m_UploadBudget = UploadBudget::FromJson(appSettings.value("upload", json::object()), UploadBudget());
+		// Each sample size on its own, so a device without 16 bit planes still converts 8 bit sources on the GPU
+		if (uploadYUV) {
+			m_UploadYUV.eightBit = Walnut::Image::IsSupported(Walnut::ImageFormat::YUV420P8);
+			m_UploadYUV.sixteenBit = Walnut::Image::IsSupported(Walnut::ImageFormat::YUV420P16);
 		}
-		assert(m_VSSAPI);
-
-		// Get a pointer to the normal api struct, exists so you don't have to link with the VapourSynth core library
-		// Failure only happens on very rare API version mismatches and usually doesn't need to be checked
-		m_VSAPI = m_VSSAPI->getVSAPI(VAPOURSYNTH_API_VERSION);
-		assert(m_VSAPI);
 	}
 
 	int static AttributeCallback(ImGuiInputTextCallbackData* data) {
@@ -387,6 +432,7 @@ public:
 		} else {
 			extra_attributes[activeFrameKey] = text;
 		}
+		layer->m_CycleStatus.SetExtraAttributes(activeFrame, extra_attributes.contains(activeFrameKey));
 
 		return 0;
 	}
@@ -406,6 +452,11 @@ public:
 		ImGuiFileDialog::Instance()->OpenModal("SaveProjectAsDialog", "Choose project file", ".ivtc", path.path + "/.");
 	}
 
+	void ExportY4MDialog() {
+		auto path = IGFD::Utils::ParsePathFileName(m_ProjectFile);
+		ImGuiFileDialog::Instance()->OpenModal("ExportY4MDialog", "Choose output file", ".y4m", path.path + "/.");
+	}
+
 	template <typename ValueType> static ValueType SetDefault(json& object, std::string attribute, ValueType defaultValue) {
 		if (!object.contains(attribute)) {
 			object[attribute] = defaultValue;
@@ -413,17 +464,127 @@ public:
 		return object[attribute];
 	}
 
+	// Waits for the background load of the VSScript library if it hasn't finished, false (with m_LoadError set) if
+	// VapourSynth isn't available
+	bool EnsureVSScript() {
+		if (m_VSSAPI) {
+			return true;
+		}
+		const auto start = std::chrono::steady_clock::now();
+		m_VSSAPI = GetVSScriptAPI();
+		if (!m_VSSAPI) {
+			// VapourSynth probably isn't properly installed at all
+			m_LoadError = "Failed to initialize VSScript library";
+			fprintf(stderr, "%s\n", m_LoadError.c_str());
+			return false;
+		}
+
+		// Get a pointer to the normal api struct, exists so you don't have to link with the VapourSynth core library
+		// Failure only happens on very rare API version mismatches and usually doesn't need to be checked
+		m_VSAPI = m_VSSAPI->getVSAPI(VAPOURSYNTH_API_VERSION);
+		assert(m_VSAPI);
+		if (m_StartupTiming) {
+			fprintf(stderr, "Opening the first project waited %.1f ms for VSScript\n",
+				std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+		}
+		return true;
+	}
+
+	// Reads the project and starts loading its script, the project replaces the current one once FinishLoad runs
 	void OpenProject(const char* project_path_name) {
-		m_ProjectFile = std::string(project_path_name);
-		std::ifstream input(m_ProjectFile, std::ios::binary | std::ios::ate);
-		int inputSize = input.tellg();
-		input.seekg(0, std::ios::beg);
-
-		std::vector<char> compressed;
-		compressed.resize(inputSize);
-		input.read(compressed.data(), inputSize);
-		std::string decompressed = gzip::decompress(compressed.data(), inputSize);
-		m_JsonProps = json::parse(decompressed);
+		if (!EnsureVSScript()) {
+			return;
+		}
+		json project;
+		std::string error;
+		if (!ReadProjectFile(project_path_name, project, error)) {
+			fprintf(stderr, "%s\n", error.c_str());
+			m_LoadError = error;
+			return;
+		}
+		const json project_garbage = project.value("project_garbage", json::object());
+		const std::string script_file = project_garbage.value("script_file", std::string());
+		m_PendingNewProject = false;
+		m_PendingReload = false;
+		m_PendingProjectFile = std::string(project_path_name);
+		m_PendingProject = std::move(project);
+		m_PendingCoreSettings = CoreSettings::FromJson(project_garbage.value("core", json()), m_DefaultCoreSettings);
+		m_LoadError.clear();
+		m_ScriptLoader.Start(m_VSSAPI, script_file, project_garbage.value("active_cycle", 0) * 10, m_PendingCoreSettings.threads, m_UploadYUV);
+	}
+
+	void StartNewProject(const char* script_path_name) {
+		if (!EnsureVSScript()) {
+			return;
+		}
+		m_PendingNewProject = true;
+		m_PendingReload = false;
+		m_PendingProjectFile = "";
+		m_PendingProject = json();
+		m_PendingCoreSettings = m_DefaultCoreSettings;
+		m_LoadError.clear();
+		m_ScriptLoader.Start(m_VSSAPI, script_path_name, 0, m_PendingCoreSettings.threads, m_UploadYUV);
+	}
+
+	// Re-evaluates the project's script in the background, the current one stays up until it's ready
+	void ReloadScript() {
+		m_PendingReload = true;
+		m_PendingCoreSettings = m_CoreGovernor.GetSettings();
+		m_LoadError.clear();
+		const std::string script_file = m_JsonProps["project_garbage"].value("script_file", std::string());
+		m_ScriptLoader.Start(m_VSSAPI, script_file, m_ActiveCycle * 10, m_PendingCoreSettings.threads, m_UploadYUV);
+	}
+
+	void FinishLoad() {
+		const std::string script_file = m_ScriptLoader.GetPath();
+		LoadedScript loaded = m_ScriptLoader.Take();
+		const bool reload = m_PendingReload;
+		m_PendingReload = false;
+		if (!loaded.error.empty()) {
+			// A script that fails to reload leaves the last good one in place
+			fprintf(stderr, "Error loading file: %s\n", loaded.error.c_str());
+			m_LoadError = script_file + "\n\n" + loaded.error;
+			return;
+		}
+		if (reload) {
+			FinishReload(loaded, script_file.c_str());
+			return;
+		}
+		if (m_PendingNewProject) {
+			FinishNewProject(loaded, script_file.c_str());
+		} else {
+			FinishOpenProject(loaded, script_file.c_str());
+		}
+		m_PendingProject = json();
+		m_ScriptWatcher.Watch(script_file);
+	}
+
+	static bool SameFields(const VSVideoInfo* a, const VSVideoInfo* b) {
+		return a->width == b->width && a->height == b->height && a->numFrames == b->numFrames
+			&& a->format.colorFamily == b->format.colorFamily && a->format.sampleType == b->format.sampleType
+			&& a->format.bitsPerSample == b->format.bitsPerSample
+			&& a->format.subSamplingW == b->format.subSamplingW && a->format.subSamplingH == b->format.subSamplingH;
+	}
+
+	// Swaps in a re-evaluated script without leaving the current cycle. Whatever was derived from the old fields is only
+	// thrown away if the fields changed shape. A script with a different number of fields is refused, the project's
+	// actions, notes and cycle status are sized for the old count and wouldn't line up with it.
+	void FinishReload(LoadedScript& loaded, const char* script_file) {
+		const int new_field_count = m_VSAPI->getVideoInfo(loaded.nativeFieldsNode)->numFrames;
+		if (new_field_count != m_FieldsFrameCount) {
+			m_LoadError = std::string(script_file) + "\n\nThe script now has " + std::to_string(new_field_count) + " fields where it had "
+				+ std::to_string(m_FieldsFrameCount) + ", so the project's actions no longer line up with them. The previous script stays loaded.";
+			fprintf(stderr, "%s\n", m_LoadError.c_str());
+			loaded.Free(m_VSSAPI);
+			return;
+		}
+		const bool same_fields = SameFields(m_VSAPI->getVideoInfo(m_NativeFieldsNode), m_VSAPI->getVideoInfo(loaded.nativeFieldsNode));
+		SetActiveFields(loaded, script_file, true, same_fields);
+	}
+
+	void FinishOpenProject(const LoadedScript& loaded, const char* script_file) {
+		m_ProjectFile = m_PendingProjectFile;
+		m_JsonProps = std::move(m_PendingProject);
 		SetDefault(m_JsonProps, "no_match_handling", json::object());
 		SetDefault(m_JsonProps, "no_match_handling_default", std::string("Previous"));
 		if (m_JsonProps["no_match_handling_default"] == "Next") {
@@ -437,6 +598,7 @@ public:
 
 		auto& projectGarbage = m_JsonProps["project_garbage"];
 		m_AutoReload = SetDefault(projectGarbage, "auto_reload", true);
+		m_WatchScript = SetDefault(projectGarbage, "watch_script", true);
 		if (!projectGarbage.contains("version")) {
 			// Support legacy projects with top-level notes and scene changes
 			SetDefault(projectGarbage, "notes", m_JsonProps["notes"]);
@@ -445,47 +607,35 @@ public:
 		}
 		SetDefault(projectGarbage, "notes", json::array());
 		SetDefault(projectGarbage, "scene_changes", json::array());
+		TakeFieldValues();
 		m_ActiveCycle = SetDefault(projectGarbage, "active_cycle", 0);
 		m_CombedDetection = SetDefault(projectGarbage, "combed_detection", false);
 		m_CombedThreshold = SetDefault(projectGarbage, "combed_threshold", 45);
+		m_MatchMetrics = SetDefault(projectGarbage, "match_metrics", false);
+		m_FindFlags = SetDefault(projectGarbage, "find_flags", 0xFF);
 
-		std::string script_file = projectGarbage["script_file"];
-		SetActiveFields(script_file.c_str(), true);
+		SetActiveFields(loaded, script_file, true);
+		RebuildCycleStatus();
 		m_ProjectOpened = true;
 	}
 
-	void StartNewProject(const char* script_path_name) {
-		static int actions[] = { 0, 1, 2, 3, 8, 5, 4, 8, 6, 7 };
-		static std::string notes[] = { "A", "A", "B", "B", "B", "C", "C", "D", "D", "D" };
+	void FinishNewProject(const LoadedScript& loaded, const char* script_path_name) {
 		m_ProjectFile = "";
-		m_JsonProps = R"({
-			"ivtc_actions": [],
-			"tff": true,
-			"no_match_handling": {},
-			"no_match_handling_default": "Previous",
-			"project_garbage": {
-				"version": 1,
-				"auto_reload": true,
-				"notes": [],
-				"scene_changes": [],
-				"combed_detection": false,
-				"combed_threshold": 45
-			},
-			"extra_attributes": {}
-		})"_json;
-		m_JsonProps["project_garbage"]["script_file"] = script_path_name;
-		SetActiveFields(script_path_name, false);
+		SetActiveFields(loaded, script_path_name, false);
 		const VSVideoInfo* vi = m_VSAPI->getVideoInfo(m_FieldsNode);
-		for (int i = 0; i < vi->numFrames; i++) {
-			m_JsonProps["ivtc_actions"][i] = actions[i % 10];
-			m_JsonProps["project_garbage"]["notes"][i] = notes[i % 10];
-		}
+		m_JsonProps = NewProject(script_path_name, vi->numFrames, false);
+		m_Actions.Reset(vi->numFrames, ActionPattern(ACTION_PATTERN));
+		m_Notes.Reset(vi->numFrames, NotePattern(NOTE_PATTERN));
+		RebuildCycleStatus();
 		LoadFrames();
 		// TODO this is increasingly redundant with OpenProject, should probably delegate
 		m_ActiveCycle = 0;
 		m_AutoReload = true;
+		m_WatchScript = true;
 		m_CombedDetection = false;
 		m_CombedThreshold = 45;
+		m_MatchMetrics = false;
+		m_FindFlags = 0xFF;
 		m_NoMatchHandling = NoMatchHandling::PREVIOUS;
 		m_TopFieldFirst = true;
 		m_ProjectOpened = true;
@@ -497,16 +647,23 @@ public:
 		}
 
 		m_JsonProps["project_garbage"]["active_cycle"] = m_ActiveCycle;
-		std::string input = m_JsonProps.dump();
+		std::string input = ProjectDump();
 		std::string compressed = gzip::compress(input.c_str(), input.size());
 		std::ofstream output(m_ProjectFile, std::ios::binary);
 		output << compressed;
+		if (!m_ProjectFile.empty() && m_ThumbnailCache.IsInMemory()) {
+			m_ThumbnailCache.MoveToFile(m_ProjectFile + ".thumbs");
+		}
 	}
 
 	void UpdateAutoReload() {
 		m_JsonProps["project_garbage"]["auto_reload"] = m_AutoReload;
 	}
 
+	void UpdateWatchScript() {
+		m_JsonProps["project_garbage"]["watch_script"] = m_WatchScript;
+	}
+
 	void UpdateCombedDetection() {
 		m_JsonProps["project_garbage"]["combed_detection"] = m_CombedDetection;
 		AutoLoadFrames();
@@ -516,6 +673,14 @@ public:
 		m_JsonProps["project_garbage"]["combed_threshold"] = m_CombedThreshold;
 	}
 
+	void UpdateMatchMetrics() {
+		m_JsonProps["project_garbage"]["match_metrics"] = m_MatchMetrics;
+	}
+
+	void UpdateFindFlags() {
+		m_JsonProps["project_garbage"]["find_flags"] = m_FindFlags;
+	}
+
 	void UpdateNoMatchHandling() {
 		std::string newMatchString;
 		if (m_NoMatchHandling == NoMatchHandling::PREVIOUS) {
@@ -528,30 +693,144 @@ public:
 		auto& oldNoMatchHandling = m_JsonProps["no_match_handling"];
 		// TODO iterate through all cycles and add evaluate every instance where there are no matches
 		m_JsonProps["no_match_handling"] = newNoMatchHandling;
+		RebuildCycleStatus();
 		AutoLoadFrames();
 	}
 
+	// Project settings (when the project has its own) or the global defaults
+	CoreSettings ProjectCoreSettings() {
+		return CoreSettings::FromJson(m_JsonProps["project_garbage"].value("core", json()), m_DefaultCoreSettings);
+	}
+
+	bool HasProjectCoreSettings() {
+		return m_ProjectOpened && m_JsonProps["project_garbage"].contains("core");
+	}
+
+	void UpdateCoreSettings(const CoreSettings& settings, const bool forProject) {
+		if (forProject) {
+			m_JsonProps["project_garbage"]["core"] = settings.ToJson();
+		} else {
+			m_DefaultCoreSettings = settings;
+			json appSettings = ReadAppSettings();
+			appSettings["core"] = settings.ToJson();
+			WriteAppSettings(appSettings);
+		}
+		if (m_CoreGovernor.IsAttached()) {
+			m_CoreGovernor.Attach(m_VSAPI, m_VSSAPI->getCore(m_FieldsScriptEnvironment), ProjectCoreSettings());
+		}
+	}
+
+	void UseProjectCoreSettings(const bool forProject) {
+		if (forProject) {
+			UpdateCoreSettings(m_DefaultCoreSettings, true);
+		} else {
+			m_JsonProps["project_garbage"].erase("core");
+			UpdateCoreSettings(m_DefaultCoreSettings, false);
+		}
+	}
+
+	void RebuildCycleStatus() {
+		std::vector<char> notes;
+		for (const std::string& note : m_Notes.ToVector()) {
+			notes.push_back(NoteLetter(note));
+		}
+		std::vector<int> no_match_frames;
+		for (const auto& [frame, handling] : m_JsonProps["no_match_handling"].items()) {
+			no_match_frames.push_back(std::stoi(frame));
+		}
+		std::vector<int> extra_attribute_frames;
+		for (const auto& [frame, attributes] : m_JsonProps["extra_attributes"].items()) {
+			extra_attribute_frames.push_back(std::stoi(frame));
+		}
+		m_CycleStatus.Rebuild(m_Actions.ToVector(), std::move(notes), SceneChanges(), no_match_frames, extra_attribute_frames);
+	}
+
+	static char NoteLetter(const std::string& note) {
+		return note.empty() ? 0 : note[0];
+	}
+
+	static PatternTrack<int8_t>::Pattern ActionPattern(const int8_t actions[10]) {
+		PatternTrack<int8_t>::Pattern pattern;
+		std::copy(actions, actions + 10, pattern.begin());
+		return pattern;
+	}
+
+	static PatternTrack<std::string>::Pattern NotePattern(const char notes[10]) {
+		PatternTrack<std::string>::Pattern pattern;
+		for (int i = 0; i < 10; i++) {
+			pattern[i] = std::string(1, notes[i]);
+		}
+		return pattern;
+	}
+
+	// Moves the opened project's actions and notes out of the json into their pattern tracks
+	void TakeFieldValues() {
+		std::vector<int8_t> actions;
+		for (const auto& action : m_JsonProps["ivtc_actions"]) {
+			actions.push_back(action.is_number_integer() ? action.get<int8_t>() : 0);
+		}
+		std::vector<std::string> notes;
+		for (const auto& note : m_JsonProps["project_garbage"]["notes"]) {
+			notes.push_back(note.is_string() ? note.get<std::string>() : std::string());
+		}
+		notes.resize(actions.size());
+		m_Actions.Assign(actions);
+		m_Notes.Assign(notes);
+		m_JsonProps.erase("ivtc_actions");
+		m_JsonProps["project_garbage"].erase("notes");
+	}
+
+	// The project as it is saved and read by the plugin, with actions and notes written out per field
+	std::string ProjectDump() {
+		json project = m_JsonProps;
+		json& actions = project["ivtc_actions"] = json::array();
+		for (int8_t action : m_Actions.ToVector()) {
+			actions.push_back(action);
+		}
+		project["project_garbage"]["notes"] = m_Notes.ToVector();
+		return project.dump();
+	}
+
+	// Moves to the nearest cycle after (or before) the active one with any of the flags being searched for
+	void FindFlaggedCycle(const bool forward) {
+		const uint8_t mask = (uint8_t)m_FindFlags;
+		const int cycle = forward ? m_CycleStatus.FindFirst(m_ActiveCycle + 1, m_CycleStatus.GetCycleCount(), mask) : m_CycleStatus.FindLast(0, m_ActiveCycle, mask);
+		if (cycle >= 0) {
+			m_ActiveCycle = cycle;
+		}
+	}
+
 	void UpdateTopFieldFirst() {
 		m_JsonProps["tff"] = m_TopFieldFirst;
+		// Weaving order depends on field parity
+		m_MatchMetricCache.clear();
+		m_MatchMetricLoader.Invalidate();
 		AutoLoadFrames();
 	}
 
 	bool m_AutoReload = true;
+	bool m_WatchScript = true;
 	bool m_ProjectOpened = false;
 	bool m_CombedDetection = false;
 	int m_CombedThreshold = 45;
+	bool m_MatchMetrics = false;
 	int m_NoMatchHandling = NoMatchHandling::PREVIOUS;
 	bool m_TopFieldFirst = true;
 
 private:
 	const VSAPI* m_VSAPI = nullptr;
 	const VSSCRIPTAPI* m_VSSAPI = nullptr;
+	// --startup-timing
+	bool m_StartupTiming = false;
+	bool m_ReportVSScriptTiming = false;
 	std::string m_ProjectFile = "";
 	json m_JsonProps;
 
 	int m_ActiveCycle = 0;
-	bool m_NeedNewFields = false;
-	bool m_WantNewFrames = false;
+	// Fetches of the active cycle's fields and frames, coalesced so only the latest state is uploaded
+	ReloadScheduler m_Reloads;
+	// Display nodes stay in the script's YUV format and are converted on the GPU when the device supports it
+	YUVUploadSupport m_UploadYUV;
 
 	// Fields
 	VSScript* m_FieldsScriptEnvironment = nullptr;
@@ -561,105 +840,101 @@ private:
 	int m_FieldsFrameCount = 0;
 	std::shared_ptr<Walnut::Image> m_Fields[11] = {};
 
+	// Native format fields (before RGB conversion) for the built-in comb metric
+	VSNode* m_NativeFieldsNode = nullptr;
+	// Comb metric of weaving two fields, keyed by MatchMetricKey
+	std::unordered_map<uint64_t, int> m_MatchMetricCache;
+	// Work the UI is waiting on, like the metrics of the active cycle
+	WorkerPool m_InteractivePool{ Walnut::JobPriority::Interactive };
+	MatchMetricLoader m_MatchMetricLoader;
+	uint64_t m_MatchMetricHits = 0;
+	uint64_t m_MatchMetricMisses = 0;
+
+	// Background analysis of the whole clip; the pool must outlive the analysers using it
+	WorkerPool m_WorkerPool{ Walnut::JobPriority::Background };
+	NoteAnalyser m_NoteAnalyser;
+	bool m_NoteAnalysisPending = false;
+	// Pending note per field (0 for none) until accepted or discarded
+	std::vector<char> m_NoteSuggestions;
+	std::vector<SceneSuggestion> m_SceneSuggestions;
+	SceneDetector m_SceneDetector;
+	bool m_SceneDetectionPending = false;
+	float m_SceneSensitivity = 3.5f;
+	// Detected scene changes which aren't in scene_changes yet
+	std::vector<int> m_SceneChangeSuggestions;
+
+	// Script evaluation happens in the background, the project it belongs to waits here until it's done
+	ScriptLoader m_ScriptLoader;
+	bool m_PendingNewProject = false;
+	std::string m_PendingProjectFile;
+	json m_PendingProject;
+	std::string m_LoadError;
+	// Edits to the script (or modules next to it) re-evaluate it in place, m_PendingReload while that's loading
+	ScriptWatcher m_ScriptWatcher;
+	bool m_PendingReload = false;
+
+	// Thread count and cache budget of the script's core, projects can override the global defaults
+	CoreSettings m_DefaultCoreSettings;
+	CoreSettings m_PendingCoreSettings;
+	CoreGovernor m_CoreGovernor;
+	// Fields, output frames and grid rows wait here to be uploaded a few per UI frame
+	UploadQueue m_Uploads;
+	UploadBudget m_UploadBudget;
+	// Whether the windows were shown last frame, uploads for hidden ones go after everything on screen
+	bool m_FieldsVisible = true;
+	bool m_OutputVisible = true;
+	uint32_t m_BackgroundLimit = 0;
+	Walnut::JobSystemStats m_JobStats;
+	int64_t m_JobStatsTime = 0;
+	size_t m_ProjectFootprint = 0;
+	int64_t m_ProjectFootprintTime = 0;
+	std::string m_MemoryReportStatus;
+
+	// Y4M export of the project's output, cancelled whenever the script is reloaded since it uses the script's core
+	Y4MExporter m_Exporter;
+	bool m_ShowExport = false;
+
+	// Grid of many cycles at reduced resolution, one texture per visible row from a bounded pool
+	CycleGrid m_CycleGrid;
+	std::shared_ptr<Walnut::Image> m_GridImages[CycleGrid::MAX_ROWS] = {};
+	int m_GridImageCycles[CycleGrid::MAX_ROWS] = {};
+	bool m_GridShowFields = true;
+	bool m_GridShowOutput = true;
+	int m_GridFollowedCycle = -1;
+
+	// Actions and notes of every field, only written out as ivtc_actions and project_garbage.notes by ProjectDump()
+	PatternTrack<int8_t> m_Actions;
+	PatternTrack<std::string> m_Notes;
+
+	// Per cycle anomalies for the timeline heatmap, kept in sync with every edit of actions, notes, scene changes, no match
+	// handling and extra attributes
+	CycleStatus m_CycleStatus;
+	// Flags N/P search for
+	int m_FindFlags = 0xFF;
+
+	// Timeline of cycle thumbnails. Only the visible thumbnails are composed into the strip image.
+	ThumbnailCache m_ThumbnailCache;
+	int m_TimelineZoom = 0; // log2 of cycles per thumbnail
+	int m_TimelineFollowedCycle = -1;
+	std::shared_ptr<Walnut::Image> m_TimelineStrip;
+	std::vector<uint8_t> m_TimelineBuffer;
+	int m_TimelineComposedSlot = -1;
+	int m_TimelineComposedZoom = -1;
+	int m_TimelineComposedReady = -1;
+
 	// Frames
 	VSNode* m_FramesNode = nullptr;
 	int m_FramesWidth = 0;
 	int m_FramesHeight = 0;
 	int m_FramesFrameCount = 0;
+	Walnut::ImageFormat m_FramesFormat = Walnut::ImageFormat::None;
 	std::shared_ptr<Walnut::Image> m_Frames[4] = {};
 	int m_FieldCount[4] = {};
 	std::string m_FreezeFrames[4] = {};
 	int m_CombedMetrics[4] = {};
 
-	VSNode* SeparateFields(VSCore* core, VSNode* &node) {
-		VSMap* argument_map = m_VSAPI->createMap();
-		VSPlugin* std_plugin = m_VSAPI->getPluginByID("com.vapoursynth.std", core);
-		m_VSAPI->mapConsumeNode(argument_map, "clip", node, maReplace);
-		VSMap* result_map = m_VSAPI->invoke(std_plugin, "SeparateFields", argument_map);
-
-		const char* result_error = m_VSAPI->mapGetError(result_map);
-		if (result_error) {
-			fprintf(stderr, "%s\n", result_error);
-		}
-
-		VSNode* output = m_VSAPI->mapGetNode(result_map, "clip", 0, nullptr);
-		m_VSAPI->freeMap(argument_map);
-		m_VSAPI->freeMap(result_map);
-		return output;
-	}
-
-	VSNode* ConvertToYUV420P8(VSCore* core, VSNode* &node) {
-		VSMap* argument_map = m_VSAPI->createMap();
-		VSPlugin* resize_plugin = m_VSAPI->getPluginByID("com.vapoursynth.resize", core);
-		m_VSAPI->mapConsumeNode(argument_map, "clip", node, maReplace);
-		m_VSAPI->mapSetInt(argument_map, "format", pfYUV420P8, maReplace);
-		VSMap* result_map = m_VSAPI->invoke(resize_plugin, "Spline36", argument_map);
-
-		const char* result_error = m_VSAPI->mapGetError(result_map);
-		if (result_error) {
-			fprintf(stderr, "%s\n", result_error);
-		}
-
-		VSNode* output = m_VSAPI->mapGetNode(result_map, "clip", 0, nullptr);
-		m_VSAPI->freeMap(argument_map);
-		m_VSAPI->freeMap(result_map);
-		return output;
-	}
-
-	VSNode* ConvertToRGB(VSCore* core, VSNode* &node) {
-		VSMap* argument_map = m_VSAPI->createMap();
-		VSPlugin* resize_plugin = m_VSAPI->getPluginByID("com.vapoursynth.resize", core);
-		m_VSAPI->mapConsumeNode(argument_map, "clip", node, maReplace);
-		m_VSAPI->mapSetInt(argument_map, "format", pfRGB24, maReplace);
-		m_VSAPI->mapSetInt(argument_map, "matrix_in", 5, maReplace);
-		VSMap* result_map = m_VSAPI->invoke(resize_plugin, "Spline36", argument_map);
-
-		const char* result_error = m_VSAPI->mapGetError(result_map);
-		if (result_error) {
-			fprintf(stderr, "%s\n", result_error);
-		}
-
-		VSNode* output = m_VSAPI->mapGetNode(result_map, "clip", 0, nullptr);
-		m_VSAPI->freeMap(argument_map);
-		m_VSAPI->freeMap(result_map);
-		return output;
-	}
-
-	VSNode* IVTCDN(VSCore* core, VSNode* node) {
-		VSMap* argument_map = m_VSAPI->createMap();
-		VSPlugin* ivtcdn_plugin = m_VSAPI->getPluginByID("tools.mike.ivtc", core);
-		m_VSAPI->mapConsumeNode(argument_map, "clip", node, maReplace);
-		std::string rawProps = m_JsonProps.dump();
-		m_VSAPI->mapSetData(argument_map, "projectfile", rawProps.c_str(), rawProps.size(), dtUtf8, maReplace);
-		m_VSAPI->mapSetInt(argument_map, "rawproject", 1, maReplace);
-		VSMap* result_map = m_VSAPI->invoke(ivtcdn_plugin, "IVTC", argument_map);
-
-		const char* result_error = m_VSAPI->mapGetError(result_map);
-		if (result_error) {
-			fprintf(stderr, "%s\n", result_error);
-		}
-
-		VSNode* output = m_VSAPI->mapGetNode(result_map, "clip", 0, nullptr);
-		m_VSAPI->freeMap(argument_map);
-		m_VSAPI->freeMap(result_map);
-		return output;
-	}
-
-	VSNode* DMetrics(VSCore* core, VSNode* node) {
-		VSMap* argument_map = m_VSAPI->createMap();
-		VSPlugin* dmetrics_plugin = m_VSAPI->getPluginByID("com.vapoursynth.dmetrics", core);
-		m_VSAPI->mapConsumeNode(argument_map, "clip", node, maReplace);
-		VSMap* result_map = m_VSAPI->invoke(dmetrics_plugin, "DMetrics", argument_map);
-
-		const char* result_error = m_VSAPI->mapGetError(result_map);
-		if (result_error) {
-			fprintf(stderr, "%s\n", result_error);
-		}
-
-		VSNode* output = m_VSAPI->mapGetNode(result_map, "clip", 0, nullptr);
-		m_VSAPI->freeMap(argument_map);
-		m_VSAPI->freeMap(result_map);
-		return output;
+	ScriptGraph Graph() const {
+		return ScriptGraph(m_VSAPI, m_VSSAPI->getCore(m_FieldsScriptEnvironment));
 	}
 
 	void DrawField(const int i, const float display_width, const float display_height) {
@@ -670,66 +945,16 @@ private:
         ImGuiIO& io = ImGui::GetIO();
 		ImVec2 pos = ImGui::GetCursorScreenPos();
 		ImGui::Image(m_Fields[i]->GetDescriptorSet(), { display_width, display_height });
-		auto& note = m_JsonProps["project_garbage"]["notes"][activeField];
-		auto& action = m_JsonProps["ivtc_actions"][activeField];
+		const std::string note = m_Notes.Get(activeField);
+		const int_fast8_t action = m_Actions.Get(activeField);
 		auto& scene_changes = m_JsonProps["project_garbage"]["scene_changes"];
 		if (ImGui::IsItemHovered()) {
-			if (!io.WantCaptureKeyboard) { // Only enable hotkeys while text inputs are not capturing input
-				if (ImGui::IsKeyPressed(ImGuiKey_S) && !io.KeyCtrl) {
-					auto it = std::find(scene_changes.begin(), scene_changes.end(), activeField);
-					if (it == scene_changes.end()) {
-						scene_changes.push_back(activeField);
-					}
-					else {
-						scene_changes.erase(it);
-					}
-				}
-
-				if (ImGui::IsKeyPressed(ImGuiKey_A)) {
-					note = "A";
-				}
-				else if (ImGui::IsKeyPressed(ImGuiKey_B)) {
-					note = "B";
-				}
-				else if (ImGui::IsKeyPressed(ImGuiKey_C)) {
-					note = "C";
-				}
-				else if (ImGui::IsKeyPressed(ImGuiKey_D)) {
-					note = "D";
-				}
-
-				const int fieldOffset = i % 2;
-				static const int drop = 8;
-				if (ImGui::IsKeyPressed(ImGuiKey_1) && i < 11) {
-					int positiveAction = 0 + i % 2;
-					action = action == positiveAction ? drop : positiveAction;
-					AutoLoadFrames();
-				}
-				else if (ImGui::IsKeyPressed(ImGuiKey_2) && i < 11) {
-					int positiveAction = 2 + i % 2;
-					action = action == positiveAction ? drop : positiveAction;
-					AutoLoadFrames();
-				}
-				else if (ImGui::IsKeyPressed(ImGuiKey_3) && i < 11) {
-					int positiveAction = 4 + i % 2;
-					action = action == positiveAction ? drop : positiveAction;
-					AutoLoadFrames();
-				}
-				else if (ImGui::IsKeyPressed(ImGuiKey_4)) {
-					if (i < 10) {
-						int positiveAction = 6 + i % 2;
-						action = action == positiveAction ? drop : positiveAction;
-						AutoLoadFrames();
-					}
-					else {
-						int positiveAction = 9;
-						action = action == positiveAction ? drop : positiveAction;
-						AutoLoadFrames();
-					}
-				}
-			}
+			HandleFieldHotkeys(activeField, i);
 			ImGui::BeginTooltip();
 			ImGui::Text("In %d", activeField / 2);
+			if (m_NoteAnalyser.HasResults() && activeField >= 2) {
+				ImGui::Text("vs %d: SAD %.2f SSD %.2f", activeField - 2, m_NoteAnalyser.MeanAbsoluteDifference(activeField), m_NoteAnalyser.MeanSquaredDifference(activeField));
+			}
 			float region_size = 32.0f;
 			float region_x = io.MousePos.x - pos.x - region_size * 0.5f;
 			float region_y = io.MousePos.y - pos.y - region_size * 0.5f;
@@ -752,10 +977,173 @@ private:
 		if (std::find(scene_changes.begin(), scene_changes.end(), activeField) != scene_changes.end()) {
 			ImGui::GetWindowDrawList()->AddRectFilled(ImVec2(pos.x - 5, pos.y), ImVec2(pos.x, pos.y + display_height), IM_COL32(255, 128, 0, 255));
 		}
-		ImVec2 textSize = g_UbuntuMonoFont->CalcTextSizeA(64.0f, FLT_MAX, 0.0f, note.get<std::string>().c_str());
+		ImVec2 textSize = g_UbuntuMonoFont->CalcTextSizeA(64.0f, FLT_MAX, 0.0f, note.c_str());
 		ImVec2 textPos(pos.x + display_width / 2 - textSize.x / 2, pos.y + display_height / 2 - textSize.y / 2);
-		ImGui::GetWindowDrawList()->AddRectFilled(ImVec2(textPos.x - 4, textPos.y + 5), ImVec2(textPos.x + textSize.x + 4, textPos.y + textSize.y), ColorForAction(action.get<int_fast8_t>()));
-		ImGui::GetWindowDrawList()->AddText(g_UbuntuMonoFont, 64.0f, textPos, IM_COL32_WHITE, note.get<std::string>().c_str());
+		ImGui::GetWindowDrawList()->AddRectFilled(ImVec2(textPos.x - 4, textPos.y + 5), ImVec2(textPos.x + textSize.x + 4, textPos.y + textSize.y), ColorForAction(action));
+		ImGui::GetWindowDrawList()->AddText(g_UbuntuMonoFont, 64.0f, textPos, IM_COL32_WHITE, note.c_str());
+	}
+
+	// Edits the hovered field with the field hotkeys, i being its position in its cycle (0-10)
+	void HandleFieldHotkeys(const int activeField, const int i) {
+		ImGuiIO& io = ImGui::GetIO();
+		std::string note = m_Notes.Get(activeField);
+		int action = m_Actions.Get(activeField);
+		auto& scene_changes = m_JsonProps["project_garbage"]["scene_changes"];
+		const int previousAction = action;
+		const std::string previousNote = note;
+		if (!io.WantCaptureKeyboard) { // Only enable hotkeys while text inputs are not capturing input
+			if (ImGui::IsKeyPressed(ImGuiKey_S) && !io.KeyCtrl) {
+				auto it = std::find(scene_changes.begin(), scene_changes.end(), activeField);
+				if (it == scene_changes.end()) {
+					scene_changes.push_back(activeField);
+				}
+				else {
+					scene_changes.erase(it);
+				}
+				m_CycleStatus.SetSceneChanges(SceneChanges());
+			}
+
+			if (ImGui::IsKeyPressed(ImGuiKey_A)) {
+				note = "A";
+			}
+			else if (ImGui::IsKeyPressed(ImGuiKey_B)) {
+				note = "B";
+			}
+			else if (ImGui::IsKeyPressed(ImGuiKey_C)) {
+				note = "C";
+			}
+			else if (ImGui::IsKeyPressed(ImGuiKey_D)) {
+				note = "D";
+			}
+
+			const int fieldOffset = i % 2;
+			static const int drop = 8;
+			if (ImGui::IsKeyPressed(ImGuiKey_1) && i < 11) {
+				int positiveAction = 0 + i % 2;
+				action = action == positiveAction ? drop : positiveAction;
+				AutoLoadFrames();
+			}
+			else if (ImGui::IsKeyPressed(ImGuiKey_2) && i < 11) {
+				int positiveAction = 2 + i % 2;
+				action = action == positiveAction ? drop : positiveAction;
+				AutoLoadFrames();
+			}
+			else if (ImGui::IsKeyPressed(ImGuiKey_3) && i < 11) {
+				int positiveAction = 4 + i % 2;
+				action = action == positiveAction ? drop : positiveAction;
+				AutoLoadFrames();
+			}
+			else if (ImGui::IsKeyPressed(ImGuiKey_4)) {
+				if (i < 10) {
+					int positiveAction = 6 + i % 2;
+					action = action == positiveAction ? drop : positiveAction;
+					AutoLoadFrames();
+				}
+				else {
+					int positiveAction = 9;
+					action = action == positiveAction ? drop : positiveAction;
+					AutoLoadFrames();
+				}
+			}
+		}
+		if (action != previousAction) {
+			m_Actions.Set(activeField, (int8_t)action);
+			m_CycleStatus.SetAction(activeField, action);
+		}
+		if (note != previousNote) {
+			m_Notes.Set(activeField, note);
+			m_CycleStatus.SetNote(activeField, NoteLetter(note));
+		}
+	}
+
+	bool IsTopField(const int field) {
+		return (field % 2 == 0) == m_TopFieldFirst;
+	}
+
+	// Opposite parity fields the given field could be woven with: previous, current and next frame. SeparateFields pairs
+	// 2k with 2k + 1 whatever the field order, so the current frame's partner is field ^ 1.
+	void MatchCandidates(const int field, int candidates[3]) {
+		const int current = field ^ 1;
+		candidates[0] = current - 2;
+		candidates[1] = current;
+		candidates[2] = current + 2;
+	}
+
+	// Collects finished comb metrics, and queues every candidate match of the top row fields in the active cycle which
+	// isn't cached or already being computed
+	void LoadMatchMetrics() {
+		m_MatchMetricLoader.Collect(m_MatchMetricCache);
+		std::vector<MatchRequest> requests;
+		for (int i = 0; i < 11; i += 2) {
+			const int field = m_ActiveCycle * 10 + i;
+			if (field >= m_FieldsFrameCount) {
+				break;
+			}
+			int candidates[3];
+			MatchCandidates(field, candidates);
+			for (int partner : candidates) {
+				if (partner < 0 || partner >= m_FieldsFrameCount) {
+					continue;
+				}
+				const uint64_t key = MatchMetricKey(field, partner);
+				if (m_MatchMetricCache.contains(key)) {
+					m_MatchMetricHits++;
+					continue;
+				}
+				if (m_MatchMetricLoader.IsInFlight(key)) {
+					continue;
+				}
+				m_MatchMetricMisses++;
+				requests.push_back({ field, partner, IsTopField(field) });
+			}
+		}
+		m_MatchMetricLoader.Request(requests, m_InteractivePool);
+	}
+
+	void DrawMatchMetrics(const int i) {
+		const int field = m_ActiveCycle * 10 + i;
+		if (field >= m_FieldsFrameCount) {
+			return;
+		}
+		static const char* labels[3] = { "p", "c", "n" };
+		int candidates[3];
+		MatchCandidates(field, candidates);
+		for (int c = 0; c < 3; c++) {
+			if (c > 0) {
+				ImGui::SameLine();
+			}
+			auto it = m_MatchMetricCache.find(MatchMetricKey(field, candidates[c]));
+			if (candidates[c] < 0 || candidates[c] >= m_FieldsFrameCount || it == m_MatchMetricCache.end() || it->second < 0) {
+				ImGui::TextDisabled("%s: -", labels[c]);
+			} else if (it->second > m_CombedThreshold) {
+				ImGui::TextColored(ImVec4(1.0f, 0.3f, 0.3f, 1.0f), "%s: %d", labels[c], it->second);
+			} else {
+				ImGui::Text("%s: %d", labels[c], it->second);
+			}
+		}
+	}
+
+	// Edits the hovered output frame with the frame hotkeys
+	void HandleFrameHotkeys(const int frame) {
+		ImGuiIO& io = ImGui::GetIO();
+		if (io.WantCaptureKeyboard) { // Only enable hotkeys while text inputs are not capturing input
+			return;
+		}
+		if (ImGui::IsKeyPressed(ImGuiKey_F)) {
+			const std::string activeFrame = std::to_string(frame);
+			auto& noMatchHandling = m_JsonProps["no_match_handling"];
+			if (noMatchHandling.contains(activeFrame)) {
+				noMatchHandling.erase(activeFrame);
+			} else {
+				if (m_NoMatchHandling == NoMatchHandling::PREVIOUS) {
+					noMatchHandling[activeFrame] = "Next";
+				} else {
+					noMatchHandling[activeFrame] = "Previous";
+				}
+			}
+			m_CycleStatus.SetNoMatchOverride(frame, noMatchHandling.contains(activeFrame));
+			AutoLoadFrames();
+		}
 	}
 
 	void DrawFrame(const int i, const float display_width, const float display_height) {
@@ -771,21 +1159,7 @@ private:
 
 		if (ImGui::IsItemHovered()) {
 			auto activeFrame = std::to_string(m_ActiveCycle * 4 + i);
-			if (!io.WantCaptureKeyboard) { // Only enable hotkeys while text inputs are not capturing input
-				if (ImGui::IsKeyPressed(ImGuiKey_F)) {
-					auto& noMatchHandling = m_JsonProps["no_match_handling"];
-					if (noMatchHandling.contains(activeFrame)) {
-						noMatchHandling.erase(activeFrame);
-					} else {
-						if (m_NoMatchHandling == NoMatchHandling::PREVIOUS) {
-							noMatchHandling[activeFrame] = "Next";
-						} else {
-							noMatchHandling[activeFrame] = "Previous";
-						}
-					}
-					AutoLoadFrames();
-				}
-			}
+			HandleFrameHotkeys(m_ActiveCycle * 4 + i);
 
 			ImGui::BeginTooltip();
 			ImGui::Text("Out %s", activeFrame);
@@ -830,9 +1204,914 @@ private:
 		}
 	}
 
+	std::vector<int> SceneChanges() {
+		return m_JsonProps["project_garbage"]["scene_changes"].get<std::vector<int>>();
+	}
+
+	void UpdateSceneSuggestions() {
+		if (m_NoteSuggestions.empty()) {
+			m_SceneSuggestions.clear();
+			return;
+		}
+		m_SceneSuggestions = SummariseSuggestions(m_NoteSuggestions, m_Notes.ToVector(), SceneChanges());
+	}
+
+	void AcceptNoteSuggestions(const int start, const int end) {
+		for (int field = start; field < end && field < (int)m_NoteSuggestions.size(); field++) {
+			if (m_NoteSuggestions[field]) {
+				m_Notes.Set(field, std::string(1, m_NoteSuggestions[field]));
+				m_CycleStatus.SetNote(field, m_NoteSuggestions[field]);
+			}
+		}
+		UpdateSceneSuggestions();
+	}
+
+	void DrawNoteSuggestions() {
+		ImGui::Begin("Note Suggestions");
+		if (!m_ProjectOpened) {
+			ImGui::TextDisabled("No project");
+			ImGui::End();
+			return;
+		}
+
+		if (m_NoteAnalyser.IsRunning()) {
+			if (ImGui::Button("Cancel")) {
+				m_NoteAnalyser.Cancel();
+				m_NoteAnalysisPending = false;
+			}
+			ImGui::SameLine();
+			ImGui::ProgressBar(m_NoteAnalyser.GetProgress());
+		} else {
+			if (ImGui::Button("Analyse Fields")) {
+				m_NoteAnalyser.Start(m_VSAPI, m_NativeFieldsNode, m_WorkerPool);
+				m_NoteAnalysisPending = true;
+			}
+			ImGui::SameLine(); HelpMarker("Compares every field with the previous field of the same parity to find duplicates, then suggests notes so duplicates share a letter.");
+		}
+
+		if (!m_NoteSuggestions.empty()) {
+			if (ImGui::Button("Accept All")) {
+				AcceptNoteSuggestions(0, (int)m_NoteSuggestions.size());
+			}
+			ImGui::SameLine();
+			if (ImGui::Button("Discard")) {
+				m_NoteSuggestions.clear();
+				m_SceneSuggestions.clear();
+			}
+			if (m_SceneSuggestions.empty()) {
+				ImGui::Text("Notes match all suggestions");
+			}
+			// Accepting modifies m_SceneSuggestions, so defer it until after the loop
+			int acceptedScene = -1;
+			if (!m_SceneSuggestions.empty() && ImGui::BeginTable("scene suggestions", 3, ImGuiTableFlags_PadOuterX)) {
+				for (int i = 0; i < (int)m_SceneSuggestions.size(); i++) {
+					const auto& scene = m_SceneSuggestions[i];
+					ImGui::PushID(i);
+					ImGui::TableNextRow();
+					ImGui::TableNextColumn();
+					char label[64];
+					snprintf(label, sizeof(label), "Fields %d-%d", scene.start, scene.end - 1);
+					if (ImGui::Selectable(label)) {
+						m_ActiveCycle = scene.start / 10;
+					}
+					ImGui::TableNextColumn();
+					ImGui::Text("%d changed", scene.changedFields);
+					ImGui::TableNextColumn();
+					if (ImGui::SmallButton("Accept")) {
+						acceptedScene = i;
+					}
+					ImGui::PopID();
+				}
+				ImGui::EndTable();
+			}
+			if (acceptedScene >= 0) {
+				AcceptNoteSuggestions(m_SceneSuggestions[acceptedScene].start, m_SceneSuggestions[acceptedScene].end);
+			}
+		}
+		ImGui::End();
+	}
+
+	void OpenThumbnailCache(const char* script_file) {
+		if (m_FieldsWidth <= 0 || m_FieldsFrameCount <= 0) {
+			return;
+		}
+		// Thumbnails belong next to the project, new projects keep them in memory until they're saved
+		const std::string cache_file = m_ProjectFile.empty() ? std::string() : m_ProjectFile + ".thumbs";
+		std::error_code error;
+		const auto script_time = std::filesystem::last_write_time(script_file, error);
+		const uint64_t source_stamp = error ? 0 : (uint64_t)script_time.time_since_epoch().count();
+		const int cycle_count = (m_FieldsFrameCount + 9) / 10;
+		const int height = std::max(2, (int)((int64_t)THUMBNAIL_WIDTH * m_FieldsHeight * 2 / m_FieldsWidth) & ~1);
+		if (!m_ThumbnailCache.Open(cache_file, cycle_count, THUMBNAIL_WIDTH, height, source_stamp)) {
+			return;
+		}
+
+		const ScriptGraph graph = Graph();
+		VSNode* node = graph.SeparateFields(m_VSSAPI->getOutputNode(m_FieldsScriptEnvironment, 0));
+		node = graph.ConvertToThumbnail(node, THUMBNAIL_WIDTH, height);
+		if (node) {
+			m_ThumbnailCache.StartGenerating(m_VSAPI, node);
+			m_VSAPI->freeNode(node);
+		}
+	}
+
+	// Packs the thumbnails of `slots` consecutive timeline slots into the strip image, skipping the upload when nothing changed
+	void ComposeTimeline(const int first_slot, const int slots, const int cycles_per_slot) {
+		const int width = m_ThumbnailCache.GetWidth();
+		const int height = m_ThumbnailCache.GetHeight();
+		const int cycle_count = m_ThumbnailCache.GetCycleCount();
+		if (!m_TimelineStrip || m_TimelineStrip->GetWidth() != (uint32_t)(slots * width)) {
+			m_TimelineStrip = std::make_shared<Walnut::Image>(slots * width, height, Walnut::ImageFormat::RGBA, nullptr);
+			m_TimelineComposedSlot = -1;
+		}
+
+		int ready = 0;
+		for (int slot = first_slot; slot < first_slot + slots; slot++) {
+			ready += m_ThumbnailCache.GetThumbnail(slot * cycles_per_slot) != nullptr;
+		}
+		if (first_slot == m_TimelineComposedSlot && m_TimelineZoom == m_TimelineComposedZoom && ready == m_TimelineComposedReady) {
+			return;
+		}
+		m_TimelineComposedSlot = first_slot;
+		m_TimelineComposedZoom = m_TimelineZoom;
+		m_TimelineComposedReady = ready;
+
+		const size_t row_size = (size_t)slots * width * 4;
+		m_TimelineBuffer.resize(row_size * height);
+		for (int i = 0; i < slots; i++) {
+			const int cycle = (first_slot + i) * cycles_per_slot;
+			const uint8_t* thumbnail = m_ThumbnailCache.GetThumbnail(cycle);
+			for (int y = 0; y < height; y++) {
+				uint8_t* dst = m_TimelineBuffer.data() + y * row_size + (size_t)i * width * 4;
+				for (int x = 0; x < width; x++) {
+					if (thumbnail) {
+						const uint8_t* src = thumbnail + ((size_t)y * width + x) * 3;
+						dst[x * 4 + 0] = src[0];
+						dst[x * 4 + 1] = src[1];
+						dst[x * 4 + 2] = src[2];
+						dst[x * 4 + 3] = 255;
+					} else {
+						// Placeholder while generating, nothing at all past the end of the clip
+						const uint8_t placeholder = cycle < cycle_count ? 48 : 0;
+						dst[x * 4 + 0] = placeholder;
+						dst[x * 4 + 1] = placeholder;
+						dst[x * 4 + 2] = placeholder;
+						dst[x * 4 + 3] = cycle < cycle_count ? 255 : 0;
+					}
+				}
+			}
+		}
+		m_TimelineStrip->SetData(m_TimelineBuffer.data());
+	}
+
+	void DrawTimeline() {
+		ImGui::Begin("Timeline");
+		const int cycle_count = m_CycleStatus.GetCycleCount();
+		if (!m_ProjectOpened || cycle_count == 0) {
+			ImGui::TextDisabled("No project opened");
+			ImGui::End();
+			return;
+		}
+
+		ImGuiIO& io = ImGui::GetIO();
+		const float slot_width = (float)THUMBNAIL_WIDTH;
+		const float slot_height = m_ThumbnailCache.IsOpen() ? (float)m_ThumbnailCache.GetHeight() : 0.0f;
+		const float lane_height = 6.0f;
+		const float heatmap_height = lane_height * CYCLE_STATUS_FLAG_COUNT;
+		int max_zoom = 0;
+		while ((1 << max_zoom) < cycle_count && max_zoom < 16) {
+			max_zoom++;
+		}
+
+		int zoom = m_TimelineZoom;
+		if (ImGui::Button("-")) {
+			zoom++;
+		}
+		ImGui::SameLine();
+		if (ImGui::Button("+")) {
+			zoom--;
+		}
+		ImGui::SameLine();
+		ImGui::Text("%d %s per thumbnail", 1 << m_TimelineZoom, m_TimelineZoom ? "cycles" : "cycle");
+		if (m_ThumbnailCache.IsOpen() && m_ThumbnailCache.GetReadyCount() + m_ThumbnailCache.GetFailedCount() < cycle_count) {
+			ImGui::SameLine();
+			ImGui::TextDisabled("(generating %d/%d)", m_ThumbnailCache.GetReadyCount(), cycle_count);
+		}
+
+		// Which heatmap lanes N/P jump between
+		if (ImGui::Button("<")) {
+			FindFlaggedCycle(false);
+		}
+		ImGui::SameLine();
+		if (ImGui::Button(">")) {
+			FindFlaggedCycle(true);
+		}
+		for (int lane = 0; lane < CYCLE_STATUS_FLAG_COUNT; lane++) {
+			ImGui::SameLine();
+			ImGui::PushStyleColor(ImGuiCol_CheckMark, CycleStatusColor(lane));
+			if (ImGui::CheckboxFlags(CycleStatusLabel(lane), &m_FindFlags, 1 << lane)) {
+				UpdateFindFlags();
+			}
+			ImGui::PopStyleColor();
+		}
+
+		ImGui::BeginChild("timeline strip", ImVec2(0, slot_height + heatmap_height + ImGui::GetStyle().ItemSpacing.y + ImGui::GetStyle().ScrollbarSize + ImGui::GetStyle().WindowPadding.y), false, ImGuiWindowFlags_HorizontalScrollbar);
+		const float view_width = ImGui::GetWindowWidth();
+		float scroll = ImGui::GetScrollX();
+		const ImVec2 origin = ImGui::GetCursorScreenPos();
+
+		// CTRL+wheel zooms around the cycle under the mouse
+		if (ImGui::IsWindowHovered() && io.KeyCtrl && io.MouseWheel != 0.0f) {
+			zoom += io.MouseWheel > 0.0f ? -1 : 1;
+		}
+		zoom = std::clamp(zoom, 0, max_zoom);
+		if (zoom != m_TimelineZoom) {
+			const float anchor_x = ImGui::IsWindowHovered() ? io.MousePos.x - ImGui::GetWindowPos().x : view_width / 2;
+			const float anchor_cycle = (scroll + anchor_x) / (slot_width / (1 << m_TimelineZoom));
+			m_TimelineZoom = zoom;
+			scroll = std::max(0.0f, anchor_cycle * (slot_width / (1 << m_TimelineZoom)) - anchor_x);
+			ImGui::SetScrollX(scroll);
+		}
+
+		const int cycles_per_slot = 1 << m_TimelineZoom;
+		const float cycle_width = slot_width / cycles_per_slot;
+		const int slot_count = (cycle_count + cycles_per_slot - 1) / cycles_per_slot;
+
+		const int hovered_cycle = std::clamp((int)((io.MousePos.x - origin.x) / cycle_width), 0, cycle_count - 1);
+		if (slot_height > 0.0f) {
+			ImGui::InvisibleButton("timeline", ImVec2(slot_count * slot_width, slot_height));
+			if (ImGui::IsItemActive()) {
+				m_ActiveCycle = hovered_cycle;
+				m_TimelineFollowedCycle = m_ActiveCycle;
+			}
+			if (ImGui::IsItemHovered()) {
+				ImGui::SetTooltip("Cycle %d", hovered_cycle);
+			}
+		}
+
+		// Heatmap cells cover the smallest aligned run of cycles that is still a couple of pixels wide
+		int status_level = 0;
+		while (status_level + 1 < m_CycleStatus.GetLevelCount() && cycle_width * (1 << status_level) < 2.0f) {
+			status_level++;
+		}
+		const float cell_width = cycle_width * (1 << status_level);
+		const ImVec2 heatmap_origin = ImGui::GetCursorScreenPos();
+		ImGui::InvisibleButton("status heatmap", ImVec2(slot_count * slot_width, heatmap_height));
+		const int hovered_cell = hovered_cycle >> status_level;
+		if (ImGui::IsItemClicked()) {
+			// Jump to the first flagged cycle of the cell, which may not be the exact cycle under the mouse when zoomed out
+			const int flagged = m_CycleStatus.FindFirst(hovered_cell << status_level, (hovered_cell + 1) << status_level, 0xFF);
+			m_ActiveCycle = flagged >= 0 ? flagged : hovered_cycle;
+			m_TimelineFollowedCycle = m_ActiveCycle;
+		}
+		if (ImGui::IsItemHovered()) {
+			const uint8_t flags = m_CycleStatus.GetFlags(status_level, hovered_cell);
+			ImGui::BeginTooltip();
+			if (status_level > 0) {
+				ImGui::Text("Cycles %d-%d", hovered_cell << status_level, std::min((hovered_cell + 1) << status_level, cycle_count) - 1);
+			} else {
+				ImGui::Text("Cycle %d", hovered_cycle);
+			}
+			for (int lane = 0; lane < CYCLE_STATUS_FLAG_COUNT; lane++) {
+				if (flags & (1 << lane)) {
+					ImGui::TextColored(ImGui::ColorConvertU32ToFloat4(CycleStatusColor(lane)), "%s", CycleStatusLabel(lane));
+				}
+			}
+			ImGui::EndTooltip();
+		}
+
+		// Keep the active cycle in view when navigating by other means
+		if (m_TimelineFollowedCycle != m_ActiveCycle) {
+			m_TimelineFollowedCycle = m_ActiveCycle;
+			const float active_x = m_ActiveCycle * cycle_width;
+			if (active_x < scroll || active_x + cycle_width > scroll + view_width) {
+				scroll = std::max(0.0f, active_x - view_width / 2);
+				ImGui::SetScrollX(scroll);
+			}
+		}
+
+		ImDrawList* draw_list = ImGui::GetWindowDrawList();
+		if (m_ThumbnailCache.IsOpen()) {
+			const int first_slot = std::min((int)(scroll / slot_width), std::max(0, slot_count - 1));
+			const int visible_slots = (int)(view_width / slot_width) + 2;
+			m_ThumbnailCache.Prioritise(first_slot * cycles_per_slot, (first_slot + visible_slots) * cycles_per_slot - 1, cycles_per_slot);
+			ComposeTimeline(first_slot, visible_slots, cycles_per_slot);
+			const ImVec2 strip_min(origin.x + first_slot * slot_width, origin.y);
+			draw_list->AddImage(m_TimelineStrip->GetDescriptorSet(), strip_min, ImVec2(strip_min.x + visible_slots * slot_width, origin.y + slot_height));
+		}
+		draw_list->AddRectFilled(ImVec2(origin.x + scroll, heatmap_origin.y), ImVec2(origin.x + scroll + view_width, heatmap_origin.y + heatmap_height), IM_COL32(32, 32, 32, 255));
+		const int cell_count = (cycle_count + (1 << status_level) - 1) >> status_level;
+		const int first_cell = std::max(0, (int)(scroll / cell_width));
+		const int last_cell = std::min(cell_count - 1, (int)((scroll + view_width) / cell_width));
+		for (int cell = first_cell; cell <= last_cell; cell++) {
+			const uint8_t flags = m_CycleStatus.GetFlags(status_level, cell);
+			if (!flags) {
+				continue;
+			}
+			const float cell_x = heatmap_origin.x + cell * cell_width;
+			for (int lane = 0; lane < CYCLE_STATUS_FLAG_COUNT; lane++) {
+				if (flags & (1 << lane)) {
+					const float lane_y = heatmap_origin.y + lane * lane_height;
+					draw_list->AddRectFilled(ImVec2(cell_x, lane_y), ImVec2(cell_x + std::max(cell_width - 1.0f, 1.0f), lane_y + lane_height - 1.0f), CycleStatusColor(lane));
+				}
+			}
+		}
+
+		const float active_x = origin.x + m_ActiveCycle * cycle_width;
+		draw_list->AddRect(ImVec2(active_x, origin.y), ImVec2(active_x + std::max(cycle_width, 2.0f), heatmap_origin.y + heatmap_height), IM_COL32(255, 0, 0, 255), 0.0f, 0, 2.0f);
+		ImGui::EndChild();
+		ImGui::End();
+	}
+
+	void StartSceneDetection() {
+		const VSVideoInfo* vi = m_VSAPI->getVideoInfo(m_NativeFieldsNode);
+		const int width = std::min(vi->width, SCENE_DETECTION_WIDTH);
+		const int height = std::max(2, (int)((int64_t)vi->height * width / vi->width) & ~1);
+		const ScriptGraph graph = Graph();
+		VSNode* node = graph.SeparateFields(m_VSSAPI->getOutputNode(m_FieldsScriptEnvironment, 0));
+		node = graph.ConvertToSmallGray(node, width, height);
+		if (node) {
+			m_SceneDetector.Start(m_VSAPI, node, m_WorkerPool);
+			m_VSAPI->freeNode(node);
+			m_SceneDetectionPending = true;
+		}
+	}
+
+	void UpdateSceneChangeSuggestions() {
+		m_SceneChangeSuggestions.clear();
+		const auto& scene_changes = m_JsonProps["project_garbage"]["scene_changes"];
+		for (int field : m_SceneDetector.DetectSceneChanges(m_SceneSensitivity)) {
+			if (std::find(scene_changes.begin(), scene_changes.end(), field) == scene_changes.end()) {
+				m_SceneChangeSuggestions.push_back(field);
+			}
+		}
+	}
+
+	void AcceptSceneChange(const int field) {
+		auto& scene_changes = m_JsonProps["project_garbage"]["scene_changes"];
+		if (std::find(scene_changes.begin(), scene_changes.end(), field) == scene_changes.end()) {
+			scene_changes.push_back(field);
+			m_CycleStatus.SetSceneChanges(SceneChanges());
+		}
+	}
+
+	void StartExport(const std::string& path) {
+		VSNode* node = Graph().OutputView(m_VSSAPI->getOutputNode(m_FieldsScriptEnvironment, 0), ProjectDump());
+		m_Exporter.Start(m_VSAPI, m_VSSAPI->getCore(m_FieldsScriptEnvironment), node, path);
+		m_VSAPI->freeNode(node);
+		m_ShowExport = true;
+	}
+
+	void DrawScriptLoader() {
+		if (!m_ScriptLoader.IsLoading() && m_LoadError.empty()) {
+			return;
+		}
+		ImGui::Begin("Loading", nullptr, ImGuiWindowFlags_NoCollapse | ImGuiWindowFlags_AlwaysAutoResize);
+		if (m_ScriptLoader.IsLoading()) {
+			ImGui::TextUnformatted(m_ScriptLoader.GetPath().c_str());
+			ImGui::Text("%s... %.0f s", ScriptLoader::StageName(m_ScriptLoader.GetStage()), m_ScriptLoader.GetElapsedSeconds());
+			if (ImGui::Button("Cancel")) {
+				m_ScriptLoader.Cancel();
+			}
+			ImGui::SameLine(); HelpMarker("Indexing a source for the first time can take a while. Cancelling keeps the current project open, or a different script can be opened or dropped onto the window instead.");
+		} else {
+			ImGui::PushTextWrapPos(ImGui::GetFontSize() * 40);
+			ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "%s", m_LoadError.c_str());
+			ImGui::PopTextWrapPos();
+			if (ImGui::Button("Dismiss")) {
+				m_LoadError.clear();
+			}
+		}
+		ImGui::End();
+	}
+
+	void DrawExport() {
+		if (!m_ShowExport) {
+			return;
+		}
+		ImGui::Begin("Export", &m_ShowExport);
+		ImGui::TextUnformatted(m_Exporter.GetPath().c_str());
+		const int written = m_Exporter.GetFramesWritten();
+		const int total = m_Exporter.GetTotalFrames();
+		if (m_Exporter.IsRunning()) {
+			if (ImGui::Button("Cancel")) {
+				m_Exporter.Cancel();
+			}
+			ImGui::SameLine();
+			char overlay[64];
+			snprintf(overlay, sizeof(overlay), "%d/%d (%.1f fps)", written, total, m_Exporter.GetFps());
+			ImGui::ProgressBar(m_Exporter.GetProgress(), ImVec2(-FLT_MIN, 0), overlay);
+		} else if (m_Exporter.Succeeded()) {
+			ImGui::Text("Wrote %d frames in %.1f s (%.1f fps)", written, m_Exporter.GetElapsedSeconds(), m_Exporter.GetFps());
+		} else {
+			ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "%s", m_Exporter.GetError().c_str());
+			if (m_Exporter.HasStarted()) {
+				ImGui::Text("Stopped after %d of %d frames", written, total);
+			}
+		}
+		ImGui::End();
+	}
+
+	static std::string FormatBytes(const int64_t bytes) {
+		char text[32];
+		if (bytes >= (int64_t)1 << 30) {
+			snprintf(text, sizeof(text), "%.1f GB", bytes / (double)(1 << 30));
+		} else if (bytes >= 1 << 20) {
+			snprintf(text, sizeof(text), "%.0f MB", bytes / (double)(1 << 20));
+		} else {
+			snprintf(text, sizeof(text), "%.0f KB", bytes / (double)(1 << 10));
+		}
+		return text;
+	}
+
+	static json CacheStats(const uint64_t hits, const uint64_t misses) {
+		return {
+			{"hits", hits},
+			{"misses", misses},
+			{"hit_rate", hits + misses > 0 ? (double)hits / (hits + misses) : 0.0},
+		};
+	}
+
+	// Where the memory is going, by layer, and how busy the job system is. Sizes are in bytes under keys ending in
+	// _bytes, the project's JSON is only walked once a second since large projects have hundreds of thousands of values.
+	json MemoryReport() {
+		json report;
+
+		int nodes = (m_FieldsNode != nullptr) + (m_NativeFieldsNode != nullptr) + (m_FramesNode != nullptr);
+		const CycleGrid::Stats grid = m_CycleGrid.GetStats();
+		nodes += grid.nodes + m_ThumbnailCache.IsGenerating();
+		report["vapoursynth"] = {
+			{"threads", m_CoreGovernor.GetThreads()},
+			{"cache_used_bytes", m_CoreGovernor.GetUsedBytes()},
+			{"cache_budget_bytes", m_CoreGovernor.GetBudgetBytes()},
+			{"nodes_owned", nodes},
+		};
+
+		const Walnut::ImageMemoryStats images = Walnut::Image::GetMemoryStats();
+		const Walnut::MemoryAllocatorStats allocator = Walnut::MemoryAllocator::GetStats();
+		report["vulkan"] = {
+			{"images", images.ImageCount},
+			{"device_local_bytes", images.DeviceLocalBytes},
+			{"host_visible_bytes", images.HostVisibleBytes},
+			{"pending_frees", Walnut::Application::GetPendingResourceFreeCount()},
+			{"memory_blocks", allocator.BlockCount},
+			{"memory_block_bytes", allocator.BlockBytes},
+			{"suballocations", allocator.AllocationCount},
+			{"suballocated_bytes", allocator.AllocatedBytes},
+		};
+
+		const int64_t now = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+		if (now - m_ProjectFootprintTime >= 1000) {
+			m_ProjectFootprint = m_ProjectOpened ? JsonFootprint(m_JsonProps) : 0;
+			m_ProjectFootprintTime = now;
+		}
+		report["project"] = {
+			{"json_bytes", m_ProjectFootprint},
+			{"field_value_bytes", m_Actions.GetMemoryBytes() + m_Notes.GetMemoryBytes()},
+			{"field_value_runs", m_Actions.GetRunCount() + m_Notes.GetRunCount()},
+			{"field_value_overrides", m_Actions.GetOverrideCount() + m_Notes.GetOverrideCount()},
+			{"cycle_status_bytes", m_CycleStatus.GetMemoryBytes()},
+			{"suggestions_bytes", m_NoteSuggestions.capacity() + m_SceneSuggestions.capacity() * sizeof(SceneSuggestion) + m_SceneChangeSuggestions.capacity() * sizeof(int)},
+		};
+
+		// Entries of an unordered_map cost a node each plus a bucket pointer
+		json match_metrics = CacheStats(m_MatchMetricHits, m_MatchMetricMisses);
+		match_metrics["entries"] = m_MatchMetricCache.size();
+		match_metrics["bytes"] = m_MatchMetricCache.size() * (sizeof(std::pair<const uint64_t, int>) + 2 * sizeof(void*)) + m_MatchMetricCache.bucket_count() * sizeof(void*);
+		json grid_rows = CacheStats(grid.hits, grid.misses);
+		grid_rows["rows"] = grid.rows;
+		grid_rows["bytes"] = grid.bytes;
+		json thumbnails = CacheStats(m_ThumbnailCache.GetHits(), m_ThumbnailCache.GetMisses());
+		thumbnails["ready"] = m_ThumbnailCache.GetReadyCount();
+		thumbnails["cycles"] = m_ThumbnailCache.GetCycleCount();
+		thumbnails["mapped_bytes"] = m_ThumbnailCache.GetFileBytes();
+		thumbnails["memory_bytes"] = m_ThumbnailCache.GetMemoryBytes();
+		thumbnails["failed"] = m_ThumbnailCache.GetFailedCount();
+		thumbnails["strip_bytes"] = m_TimelineBuffer.capacity();
+		report["caches"] = {
+			{"match_metrics", match_metrics},
+			{"grid", grid_rows},
+			{"thumbnails", thumbnails},
+		};
+
+		report["uploads"] = {
+			{"queued", m_Uploads.GetQueueLength()},
+			{"queued_bytes", m_Uploads.GetQueuedBytes()},
+			{"replaced", m_Uploads.GetStats().replaced},
+		};
+
+		const Walnut::JobSystemStats& jobs = m_JobStats;
+		report["jobs"] = {
+			{"workers", jobs.WorkerCount},
+			{"background_limit", jobs.BackgroundLimit},
+			{"busy_workers", jobs.BusyWorkers},
+			{"queued_interactive", jobs.Queued[(int)Walnut::JobPriority::Interactive]},
+			{"queued_prefetch", jobs.Queued[(int)Walnut::JobPriority::Prefetch]},
+			{"queued_background", jobs.Queued[(int)Walnut::JobPriority::Background]},
+			{"completed", jobs.Completed},
+			{"stolen", jobs.Stolen},
+			{"utilisation", jobs.Utilisation},
+		};
+
+		if (m_CoreGovernor.HasSystemMemory()) {
+			const SystemMemory& system = m_CoreGovernor.GetSystemMemory();
+			report["system"] = {
+				{"total_bytes", system.total},
+				{"available_bytes", system.available},
+			};
+		}
+		return report;
+	}
+
+	static void DrawReportRows(const json& section, const std::string& prefix) {
+		for (auto it = section.begin(); it != section.end(); ++it) {
+			const std::string& key = it.key();
+			if (it->is_object()) {
+				DrawReportRows(*it, prefix + key + " ");
+				continue;
+			}
+			ImGui::TableNextRow();
+			ImGui::TableNextColumn();
+			ImGui::TextUnformatted((prefix + key).c_str());
+			ImGui::TableNextColumn();
+			const bool is_bytes = key.size() >= 5 && key.compare(key.size() - 5, 5, "bytes") == 0;
+			if (is_bytes) {
+				ImGui::TextUnformatted(FormatBytes(it->get<int64_t>()).c_str());
+			} else if (key == "hit_rate") {
+				ImGui::Text("%.1f%%", it->get<double>() * 100.0);
+			} else {
+				ImGui::TextUnformatted(it->dump().c_str());
+			}
+		}
+	}
+
+	void DrawMemoryAccounting() {
+		const json report = MemoryReport();
+		if (ImGui::BeginTable("memory accounting", 2, ImGuiTableFlags_RowBg | ImGuiTableFlags_PadOuterX)) {
+			for (auto it = report.begin(); it != report.end(); ++it) {
+				ImGui::TableNextRow();
+				ImGui::TableNextColumn();
+				ImGui::TextDisabled("%s", it.key().c_str());
+				DrawReportRows(*it, "  ");
+			}
+			ImGui::EndTable();
+		}
+		if (ImGui::Button("Save report")) {
+			std::ofstream output(MEMORY_REPORT_FILE);
+			output << report.dump(4) << std::endl;
+			m_MemoryReportStatus = output ? std::string("Saved to ") + MEMORY_REPORT_FILE : std::string("Failed to write ") + MEMORY_REPORT_FILE;
+		}
+		ImGui::SameLine(); ImGui::TextUnformatted(m_MemoryReportStatus.c_str());
+	}
+
+	// Background jobs mostly wait on frames from the script's core, so running as many at once as it has threads keeps
+	// it busy without piling requests onto it. One worker is always left for interactive work.
+	void UpdateBackgroundLimit() {
+		const uint32_t workers = Walnut::JobSystem::GetWorkerCount();
+		const uint32_t limit = std::clamp((uint32_t)std::max(m_CoreGovernor.GetThreads(), 1), 1u, std::max(workers, 2u) - 1);
+		if (limit != m_BackgroundLimit) {
+			Walnut::JobSystem::SetBackgroundLimit(limit);
+			m_BackgroundLimit = limit;
+		}
+	}
+
+	void DrawJobStats() {
+		// Utilisation is averaged over a second, sampling every frame would only show noise
+		const int64_t now = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+		if (now - m_JobStatsTime >= 1000) {
+			m_JobStats = Walnut::JobSystem::GetStats();
+			m_JobStatsTime = now;
+		}
+		const Walnut::JobSystemStats& stats = m_JobStats;
+		const uint32_t* queued = stats.Queued;
+		ImGui::Text("Workers: %u (%u for background jobs), %.0f%% busy", stats.WorkerCount, stats.BackgroundLimit, stats.Utilisation * 100.0f);
+		ImGui::Text("Queued: %u interactive, %u prefetch, %u background", queued[(int)Walnut::JobPriority::Interactive], queued[(int)Walnut::JobPriority::Prefetch], queued[(int)Walnut::JobPriority::Background]);
+	}
+
+	void DrawUploads() {
+		const UploadQueue::Stats& stats = m_Uploads.GetStats();
+		ImGui::Text("Uploads: %zu queued (%s), %d last frame in %.1f ms", m_Uploads.GetQueueLength(), FormatBytes(m_Uploads.GetQueuedBytes()).c_str(), stats.uploads, stats.milliseconds);
+		UploadBudget budget = m_UploadBudget;
+		bool changed = false;
+		ImGui::SetNextItemWidth(ImGui::GetFontSize() * 8);
+		changed |= ImGui::InputFloat("Upload time (ms)", &budget.milliseconds, 1.0f, 4.0f, "%.1f");
+		ImGui::SameLine(); HelpMarker("Most of each frame to spend uploading fields and frames to the GPU. The rest wait for the next frame, which keeps the UI responsive while large fields stream in.");
+		ImGui::SetNextItemWidth(ImGui::GetFontSize() * 8);
+		changed |= ImGui::InputInt("Upload size (MB)", &budget.megabytes, 16, 64);
+		ImGui::SameLine(); HelpMarker("Most data to upload in one frame. At least one image goes up every frame whatever the budget.");
+		if (changed) {
+			budget.milliseconds = std::max(0.0f, budget.milliseconds);
+			budget.megabytes = std::max(0, budget.megabytes);
+			m_UploadBudget = budget;
+			json appSettings = ReadAppSettings();
+			appSettings["upload"] = budget.ToJson();
+			WriteAppSettings(appSettings);
+		}
+	}
+
+	void DrawResources() {
+		ImGui::Begin("Resources");
+		if (m_CoreGovernor.IsAttached()) {
+			const int64_t used = m_CoreGovernor.GetUsedBytes();
+			const int64_t budget = m_CoreGovernor.GetBudgetBytes();
+			ImGui::Text("Threads: %d", m_CoreGovernor.GetThreads());
+			ImGui::Text("Frame cache: %s of %s%s", FormatBytes(used).c_str(), FormatBytes(budget).c_str(), m_CoreGovernor.GetSettings().adaptive ? " (adaptive)" : "");
+			ImGui::ProgressBar(budget > 0 ? std::min(1.0f, (float)used / budget) : 0.0f, ImVec2(-FLT_MIN, 0), "");
+		} else {
+			ImGui::TextDisabled("No script loaded");
+		}
+		if (m_CoreGovernor.HasSystemMemory()) {
+			const SystemMemory& system = m_CoreGovernor.GetSystemMemory();
+			ImGui::Text("System memory: %s available of %s", FormatBytes(system.available).c_str(), FormatBytes(system.total).c_str());
+		}
+		DrawJobStats();
+		DrawUploads();
+		if (ImGui::CollapsingHeader("Memory accounting")) {
+			DrawMemoryAccounting();
+		}
+		ImGui::Separator();
+
+		bool forProject = HasProjectCoreSettings();
+		if (!m_ProjectOpened) {
+			ImGui::BeginDisabled();
+		}
+		if (ImGui::Checkbox("Project settings", &forProject)) {
+			UseProjectCoreSettings(forProject);
+		}
+		if (!m_ProjectOpened) {
+			ImGui::EndDisabled();
+		}
+		ImGui::SameLine(); HelpMarker("Saves the settings below in this project only, instead of changing the defaults used by every project without its own settings.");
+
+		CoreSettings settings = forProject ? ProjectCoreSettings() : m_DefaultCoreSettings;
+		bool changed = false;
+		ImGui::SetNextItemWidth(ImGui::GetFontSize() * 8);
+		changed |= ImGui::InputInt("Threads", &settings.threads);
+		ImGui::SameLine(); HelpMarker("0 uses one thread per CPU core. Lower it when running several instances side by side.");
+		ImGui::SetNextItemWidth(ImGui::GetFontSize() * 8);
+		changed |= ImGui::InputInt("Cache (MB)", &settings.cacheMB, 256, 1024);
+		ImGui::SameLine(); HelpMarker("0 keeps VapourSynth's default. VapourSynth starts dropping cached frames above this, it isn't a hard limit.");
+		changed |= ImGui::Checkbox("Adaptive cache", &settings.adaptive);
+		ImGui::SameLine(); HelpMarker("Shrinks the cache when system memory runs low and grows it (up to the cache size above, if set) while it's full and memory is plentiful.");
+		if (settings.adaptive) {
+			ImGui::Indent();
+			ImGui::SetNextItemWidth(ImGui::GetFontSize() * 8);
+			changed |= ImGui::InputInt("Reserve (MB)", &settings.reserveMB, 256, 1024);
+			ImGui::SameLine(); HelpMarker("System memory to keep available for other programs.");
+			ImGui::Unindent();
+		}
+		if (changed) {
+			settings.threads = std::max(0, settings.threads);
+			settings.cacheMB = std::max(0, settings.cacheMB);
+			settings.reserveMB = std::max(0, settings.reserveMB);
+			UpdateCoreSettings(settings, forProject);
+		}
+		ImGui::End();
+	}
+
+	VSNode* GridFramesNode() {
+		const ScriptGraph graph = Graph();
+		VSNode* node = graph.OutputView(m_VSSAPI->getOutputNode(m_FieldsScriptEnvironment, 0), ProjectDump());
+		return graph.ConvertToThumbnail(node, GRID_CELL_WIDTH, m_CycleGrid.GetCellHeight());
+	}
+
+	void OpenCycleGrid() {
+		if (m_FieldsWidth <= 0) {
+			return;
+		}
+		// Cells are the size of an output frame, each field takes half the height
+		const int cell_height = std::max(2, (int)((int64_t)GRID_CELL_WIDTH * m_FieldsHeight * 2 / m_FieldsWidth) & ~1);
+		const ScriptGraph graph = Graph();
+		VSNode* fields = graph.ConvertToThumbnail(graph.SeparateFields(m_VSSAPI->getOutputNode(m_FieldsScriptEnvironment, 0)), GRID_CELL_WIDTH, cell_height / 2);
+		VSNode* frames = graph.ConvertToThumbnail(graph.OutputView(m_VSSAPI->getOutputNode(m_FieldsScriptEnvironment, 0), ProjectDump()), GRID_CELL_WIDTH, cell_height);
+		if (fields) {
+			m_CycleGrid.Open(m_VSAPI, fields, frames, GRID_CELL_WIDTH, cell_height);
+		}
+		m_VSAPI->freeNode(fields);
+		m_VSAPI->freeNode(frames);
+		for (int i = 0; i < CycleGrid::MAX_ROWS; i++) {
+			m_GridImages[i] = nullptr;
+			m_GridImageCycles[i] = -1;
+		}
+	}
+
+	void DrawGrid() {
+		const bool visible = ImGui::Begin("Grid");
+		if (!visible) {
+			// Collapsed or a hidden tab, nothing is requested
+			ImGui::End();
+			return;
+		}
+		if (!m_ProjectOpened) {
+			ImGui::TextDisabled("No project opened");
+			ImGui::End();
+			return;
+		}
+		if (!m_CycleGrid.IsOpen()) {
+			OpenCycleGrid();
+		}
+
+		ImGui::Checkbox("Fields", &m_GridShowFields);
+		ImGui::SameLine();
+		ImGui::Checkbox("Output", &m_GridShowOutput);
+		ImGui::SameLine(); HelpMarker("Every field and output frame hotkey works on the cell under the mouse. Click a row to make it the active cycle.");
+		const int columns = (m_GridShowFields ? GRID_FIELD_COLUMNS : 0) + (m_GridShowOutput ? GRID_FRAME_COLUMNS : 0);
+		if (!m_CycleGrid.IsOpen() || columns == 0) {
+			ImGui::End();
+			return;
+		}
+
+		ImGui::BeginChild("grid rows");
+		const float label_width = ImGui::CalcTextSize("000000").x;
+		const float row_width = std::max(64.0f, ImGui::GetContentRegionAvail().x - label_width - ImGui::GetStyle().ItemSpacing.x);
+		const float cell_width = row_width / columns;
+		const float row_height = cell_width * m_CycleGrid.GetCellHeight() / m_CycleGrid.GetCellWidth();
+		const float row_stride = row_height + ImGui::GetStyle().ItemSpacing.y;
+		const int cycle_count = (m_FieldsFrameCount + 9) / 10;
+
+		// Keep the active cycle in view when it's changed from elsewhere
+		if (m_GridFollowedCycle != m_ActiveCycle) {
+			m_GridFollowedCycle = m_ActiveCycle;
+			const float active_y = m_ActiveCycle * row_stride;
+			if (active_y < ImGui::GetScrollY() || active_y + row_height > ImGui::GetScrollY() + ImGui::GetWindowHeight()) {
+				ImGui::SetScrollY(std::max(0.0f, active_y - (ImGui::GetWindowHeight() - row_height) / 2));
+			}
+		}
+
+		const std::vector<int> scene_changes = SceneChanges();
+		m_CycleGrid.BeginFrame();
+		ImGuiListClipper clipper;
+		clipper.Begin(cycle_count, row_stride);
+		while (clipper.Step()) {
+			for (int cycle = clipper.DisplayStart; cycle < clipper.DisplayEnd; cycle++) {
+				DrawGridRow(cycle, label_width, cell_width, row_height, scene_changes);
+			}
+		}
+		clipper.End();
+		ImGui::EndChild();
+		ImGui::End();
+	}
+
+	void DrawGridRow(const int cycle, const float label_width, const float cell_width, const float row_height, const std::vector<int>& scene_changes) {
+		const int first_column = m_GridShowFields ? 0 : GRID_FIELD_COLUMNS;
+		const int last_column = m_GridShowOutput ? GRID_FIELD_COLUMNS + GRID_FRAME_COLUMNS : GRID_FIELD_COLUMNS;
+		const ImVec2 size(cell_width * (last_column - first_column), row_height);
+
+		ImGui::PushID(cycle);
+		if (cycle == m_ActiveCycle) {
+			ImGui::TextColored(ImVec4(1.0f, 0.8f, 0.2f, 1.0f), "%d", cycle);
+		} else {
+			ImGui::TextDisabled("%d", cycle);
+		}
+		ImGui::SameLine(label_width + ImGui::GetStyle().ItemSpacing.x);
+		const ImVec2 pos = ImGui::GetCursorScreenPos();
+
+		const int slot = m_CycleGrid.Request(cycle);
+		std::vector<uint8_t> pixels;
+		if (slot >= 0 && m_CycleGrid.TakeUpdate(slot, pixels)) {
+			if (m_GridImages[slot] == nullptr) {
+				m_GridImages[slot] = std::make_shared<Walnut::Image>(
+					m_CycleGrid.GetRowWidth(),
+					m_CycleGrid.GetCellHeight(),
+					Walnut::ImageFormat::RGBA,
+					nullptr);
+			}
+			const size_t bytes = pixels.size();
+			m_Uploads.Push(GRID_UPLOAD_KEY + slot, UPLOAD_ON_SCREEN, bytes, [this, slot, cycle, image = m_GridImages[slot], pixels = std::move(pixels)]() {
+				// The grid may have been reopened since
+				if (image == m_GridImages[slot]) {
+					image->SetData(pixels.data());
+					m_GridImageCycles[slot] = cycle;
+				}
+			});
+		}
+		if (slot >= 0 && m_GridImageCycles[slot] == cycle) {
+			const float total_columns = GRID_FIELD_COLUMNS + GRID_FRAME_COLUMNS;
+			ImGui::Image(m_GridImages[slot]->GetDescriptorSet(), size, ImVec2(first_column / total_columns, 0.0f), ImVec2(last_column / total_columns, 1.0f));
+		} else {
+			// Still loading, or the pool is taken up by other visible rows
+			ImGui::Dummy(size);
+		}
+
+		if (ImGui::IsItemClicked()) {
+			m_ActiveCycle = cycle;
+			m_GridFollowedCycle = cycle;
+		}
+		if (ImGui::IsItemHovered()) {
+			const ImVec2 mouse = ImGui::GetIO().MousePos;
+			const int column = first_column + std::clamp((int)((mouse.x - pos.x) / cell_width), 0, last_column - first_column - 1);
+			if (column < GRID_FIELD_COLUMNS) {
+				const int i = column * 2 + (mouse.y - pos.y >= row_height / 2 ? 1 : 0);
+				const int field = cycle * 10 + i;
+				if (field < m_FieldsFrameCount) {
+					HandleFieldHotkeys(field, i);
+					ImGui::SetTooltip("In %d", field / 2);
+				}
+			} else {
+				const int frame = cycle * 4 + column - GRID_FIELD_COLUMNS;
+				if (frame < m_FramesFrameCount) {
+					HandleFrameHotkeys(frame);
+					ImGui::SetTooltip("Out %d", frame);
+				}
+			}
+		}
+
+		// Notes in their action's colour, and scene changes, on every field
+		ImDrawList* draw_list = ImGui::GetWindowDrawList();
+		for (int column = first_column; column < std::min(last_column, GRID_FIELD_COLUMNS); column++) {
+			for (int parity = 0; parity < 2; parity++) {
+				const int field = cycle * 10 + column * 2 + parity;
+				if (field >= m_FieldsFrameCount) {
+					break;
+				}
+				const ImVec2 cell(pos.x + (column - first_column) * cell_width, pos.y + parity * row_height / 2);
+				const std::string note = m_Notes.Get(field);
+				const ImVec2 text_size = ImGui::CalcTextSize(note.empty() ? " " : note.c_str());
+				draw_list->AddRectFilled(ImVec2(cell.x + 2, cell.y + 2), ImVec2(cell.x + text_size.x + 6, cell.y + text_size.y + 2), ColorForAction(m_Actions.Get(field)));
+				draw_list->AddText(ImVec2(cell.x + 4, cell.y + 2), IM_COL32_WHITE, note.c_str());
+				if (std::find(scene_changes.begin(), scene_changes.end(), field) != scene_changes.end()) {
+					draw_list->AddRectFilled(ImVec2(cell.x, cell.y), ImVec2(cell.x + 3, cell.y + row_height / 2), IM_COL32(255, 128, 0, 255));
+				}
+			}
+		}
+		if (cycle == m_ActiveCycle) {
+			draw_list->AddRect(pos, ImVec2(pos.x + size.x, pos.y + size.y), IM_COL32(255, 204, 51, 255));
+		}
+		ImGui::PopID();
+	}
+
+	void DrawSceneChangeSuggestions() {
+		ImGui::Begin("Scene Suggestions");
+		if (!m_ProjectOpened) {
+			ImGui::TextDisabled("No project");
+			ImGui::End();
+			return;
+		}
+
+		if (m_SceneDetector.IsRunning()) {
+			if (ImGui::Button("Cancel")) {
+				m_SceneDetector.Cancel();
+				m_SceneDetectionPending = false;
+			}
+			ImGui::SameLine();
+			ImGui::ProgressBar(m_SceneDetector.GetProgress());
+		} else if (ImGui::Button("Detect Scene Changes")) {
+			StartSceneDetection();
+		}
+
+		if (m_SceneDetector.HasResults()) {
+			ImGui::SetNextItemWidth(ImGui::GetFontSize() * 8);
+			if (ImGui::SliderFloat("Sensitivity", &m_SceneSensitivity, 1.0f, 10.0f, "%.1f")) {
+				UpdateSceneChangeSuggestions();
+			}
+			ImGui::SameLine(); HelpMarker("How many standard deviations a field's difference to the previous field must stand out from its neighbours. Lower finds more scene changes.");
+
+			if (!m_SceneChangeSuggestions.empty()) {
+				if (ImGui::Button("Add All")) {
+					for (int field : m_SceneChangeSuggestions) {
+						AcceptSceneChange(field);
+					}
+					m_SceneChangeSuggestions.clear();
+					UpdateSceneSuggestions();
+				}
+				ImGui::SameLine();
+				if (ImGui::Button("Discard")) {
+					m_SceneChangeSuggestions.clear();
+				}
+			} else {
+				ImGui::Text("No new scene changes");
+			}
+
+			int acceptedSuggestion = -1;
+			if (!m_SceneChangeSuggestions.empty() && ImGui::BeginTable("scene change suggestions", 2, ImGuiTableFlags_PadOuterX)) {
+				for (int i = 0; i < (int)m_SceneChangeSuggestions.size(); i++) {
+					const int field = m_SceneChangeSuggestions[i];
+					ImGui::PushID(i);
+					ImGui::TableNextRow();
+					ImGui::TableNextColumn();
+					char label[32];
+					snprintf(label, sizeof(label), "Field %d", field);
+					if (ImGui::Selectable(label)) {
+						m_ActiveCycle = field / 10;
+					}
+					ImGui::TableNextColumn();
+					if (ImGui::SmallButton("Add")) {
+						acceptedSuggestion = i;
+					}
+					ImGui::PopID();
+				}
+				ImGui::EndTable();
+			}
+			if (acceptedSuggestion >= 0) {
+				AcceptSceneChange(m_SceneChangeSuggestions[acceptedSuggestion]);
+				m_SceneChangeSuggestions.erase(m_SceneChangeSuggestions.begin() + acceptedSuggestion);
+				UpdateSceneSuggestions();
+			}
+		}
+		ImGui::End();
+	}
+
 	void ApplyCycleToScene() {
-		auto& notes = m_JsonProps["project_garbage"]["notes"];
-		auto& actions = m_JsonProps["ivtc_actions"];
 		const auto& scene_changes = m_JsonProps["project_garbage"]["scene_changes"];
 
 		int start_of_cycle = m_ActiveCycle * 10;
@@ -853,63 +2132,84 @@ private:
 		std::cerr << "Scene [" << start_of_scene << ", " << end_of_scene << "]" << std::endl;
 
 		// TODO need to think about cycles a lot
-		int_fast8_t cycle_actions[10];
-		std::string cycle_notes[10];
+		PatternTrack<int8_t>::Pattern cycle_actions;
+		PatternTrack<std::string>::Pattern cycle_notes;
 		int position_in_cycle = 0;
 		for (int i = start_of_cycle; i <= end_of_cycle; i++) {
-			cycle_actions[position_in_cycle] = actions[i];
-			cycle_notes[position_in_cycle] = notes[i];
+			cycle_actions[position_in_cycle] = m_Actions.Get(i);
+			cycle_notes[position_in_cycle] = m_Notes.Get(i);
 			++position_in_cycle;
 		}
+		m_Actions.SetPattern(start_of_scene, end_of_scene, cycle_actions);
+		m_Notes.SetPattern(start_of_scene, end_of_scene, cycle_notes);
 
 		// TODO need to think about cycles a lot
 		position_in_cycle = start_of_scene % 10;
+		std::vector<int8_t> scene_actions;
+		std::vector<char> scene_notes;
 		for (int i = start_of_scene; i < end_of_scene; i++) {
-			actions[i] = cycle_actions[position_in_cycle];
-			notes[i] = cycle_notes[position_in_cycle];
+			scene_actions.push_back(cycle_actions[position_in_cycle]);
+			scene_notes.push_back(NoteLetter(cycle_notes[position_in_cycle]));
 			++position_in_cycle %= 10;
 		}
+		m_CycleStatus.SetActions(start_of_scene, scene_actions);
+		m_CycleStatus.SetNotes(start_of_scene, scene_notes);
 	}
 
-	void SetActiveFields(const char* file, bool doLoadFrames=true) {
+	// Takes ownership of the loaded script and nodes, replacing the current ones. keepFieldCaches when the new fields are
+	// known to be the same size, format and length as the old ones.
+	void SetActiveFields(const LoadedScript& loaded, const char* file, bool doLoadFrames=true, bool keepFieldCaches=false) {
+		// Waits for requests in flight, which must finish before their core is freed
+		m_Exporter.Cancel();
+		m_Reloads.Drain(m_VSAPI);
+		m_Uploads.Clear();
+		m_CycleGrid.Close();
+		m_CoreGovernor.Detach();
+		// Suggestions already made stay valid as long as the fields do, analyses in progress are abandoned
+		m_MatchMetricLoader.CancelAndWait(m_InteractivePool);
+		m_NoteAnalyser.CancelAndWait(m_WorkerPool);
+		m_NoteAnalysisPending = false;
+		m_SceneDetector.CancelAndWait(m_WorkerPool);
+		m_SceneDetectionPending = false;
+		// Joins the generator and releases its node
+		m_ThumbnailCache.Close();
 		if (m_FieldsScriptEnvironment != nullptr) {
+			m_VSAPI->freeNode(m_FramesNode);
+			m_FramesNode = nullptr;
 			m_VSAPI->freeNode(m_FieldsNode);
+			m_VSAPI->freeNode(m_NativeFieldsNode);
 			m_VSSAPI->freeScript(m_FieldsScriptEnvironment);
 		}
-		m_FieldsScriptEnvironment = m_VSSAPI->createScript(nullptr);
-
-		m_VSSAPI->evalSetWorkingDir(m_FieldsScriptEnvironment, 1);
-		int error = m_VSSAPI->evaluateFile(m_FieldsScriptEnvironment, file);
-		if (error != 0) {
-			fprintf(stderr, "Error loading file: %s\n", m_VSSAPI->getError(m_FieldsScriptEnvironment));
+		if (!keepFieldCaches) {
+			m_MatchMetricCache.clear();
+			m_NoteSuggestions.clear();
+			m_SceneSuggestions.clear();
+			m_SceneChangeSuggestions.clear();
 		}
-
-		m_FieldsNode = m_VSSAPI->getOutputNode(m_FieldsScriptEnvironment, 0);
+		m_TimelineStrip = nullptr;
+		m_FieldsScriptEnvironment = loaded.script;
+		m_FieldsNode = loaded.fieldsNode;
+		m_NativeFieldsNode = loaded.nativeFieldsNode;
+		m_MatchMetricLoader.Open(m_VSAPI, m_NativeFieldsNode);
+		m_CoreGovernor.Attach(m_VSAPI, m_VSSAPI->getCore(m_FieldsScriptEnvironment), m_PendingCoreSettings);
 		const VSVideoInfo* vi = m_VSAPI->getVideoInfo(m_FieldsNode);
-		if (vi->format.colorFamily == cfYUV) {
-			// Convert to RGB & pack
-			VSCore* core = m_VSSAPI->getCore(m_FieldsScriptEnvironment);
-			m_FieldsNode = SeparateFields(core, m_FieldsNode);
-			m_FieldsNode = ConvertToRGB(core, m_FieldsNode);
-		} else if (vi->format.colorFamily == cfRGB) {
-			VSCore* core = m_VSSAPI->getCore(m_FieldsScriptEnvironment);
-			m_FieldsNode = SeparateFields(core, m_FieldsNode);
-		} else {
-			// Hope for the best?
-		}
-		vi = m_VSAPI->getVideoInfo(m_FieldsNode);
 		m_FieldsWidth = vi->width;
 		m_FieldsHeight = vi->height;
 		m_FieldsFrameCount = vi->numFrames;
 
 		for (int i = 0; i < 11; i++) {
-			m_Fields[i] = std::make_shared<Walnut::Image>(
-				m_FieldsWidth,
-				m_FieldsHeight,
-				Walnut::ImageFormat::RGBA,
-				nullptr);
+			// Kept fields stay up until the reloaded ones arrive
+			if (!keepFieldCaches || m_Fields[i] == nullptr) {
+				m_Fields[i] = std::make_shared<Walnut::Image>(
+					m_FieldsWidth,
+					m_FieldsHeight,
+					ImageFormatFor(vi->format),
+					nullptr);
+			}
 		}
 
+		OpenThumbnailCache(file);
+
 		if (doLoadFrames) {
 			LoadFrames();
 		}
@@ -917,55 +2217,105 @@ private:
 
 	void AutoLoadFrames() {
 		if (m_AutoReload) {
-			m_WantNewFrames = true;
+			m_Reloads.InvalidateFrames(true);
 		}
 	}
 
+	// Rebuilds the output graph and refetches the active cycle, as soon as the scheduler allows
 	void LoadFrames() {
+		m_Reloads.InvalidateFields();
+		m_Reloads.InvalidateFrames(true);
+	}
+
+	void RebuildFramesNode() {
 		if (m_FramesNode != nullptr) {
 			m_VSAPI->freeNode(m_FramesNode);
 		}
 		VSNode* rawFieldsNode = m_VSSAPI->getOutputNode(m_FieldsScriptEnvironment, 0);
+		m_FramesNode = Graph().FramesView(rawFieldsNode, ProjectDump(), m_CombedDetection, m_UploadYUV);
 
-		const VSVideoInfo* vi = m_VSAPI->getVideoInfo(rawFieldsNode);
-		if (vi->format.colorFamily == cfYUV) {
-			// Convert to RGB & pack
-			VSCore* core = m_VSSAPI->getCore(m_FieldsScriptEnvironment);
-			m_FramesNode = SeparateFields(core, rawFieldsNode);
-			m_FramesNode = IVTCDN(core, m_FramesNode);
-			if (m_CombedDetection) {
-				m_FramesNode = ConvertToYUV420P8(core, m_FramesNode);
-				m_FramesNode = DMetrics(core, m_FramesNode);
-			}
-			m_FramesNode = ConvertToRGB(core, m_FramesNode);
-		} else if (vi->format.colorFamily == cfRGB) {
-			VSCore* core = m_VSSAPI->getCore(m_FieldsScriptEnvironment);
-			m_FramesNode = SeparateFields(core, rawFieldsNode);
-			m_FramesNode = IVTCDN(core, m_FramesNode);
-			// Doesn't support DMetrics
-		} else {
-			// Hope for the best?
-		}
-
-		vi = m_VSAPI->getVideoInfo(m_FramesNode);
+		const VSVideoInfo* vi = m_VSAPI->getVideoInfo(m_FramesNode);
+		// Toggling combed detection switches between the script's format and DMetrics' YUV420P8
+		const Walnut::ImageFormat format = ImageFormatFor(vi->format);
+		const bool resized = vi->width != m_FramesWidth || vi->height != m_FramesHeight || format != m_FramesFormat;
 		m_FramesWidth = vi->width;
 		m_FramesHeight = vi->height;
 		m_FramesFrameCount = vi->numFrames;
+		m_FramesFormat = format;
 
+		// The previous images stay up until the new frames arrive, unless they no longer fit
 		for (int i = 0; i < 4; i++) {
-			m_Frames[i] = std::make_shared<Walnut::Image>(
-				m_FramesWidth,
-				m_FramesHeight,
-				Walnut::ImageFormat::RGBA,
-				nullptr);
+			if (resized || m_Frames[i] == nullptr) {
+				m_Frames[i] = std::make_shared<Walnut::Image>(
+					m_FramesWidth,
+					m_FramesHeight,
+					m_FramesFormat,
+					nullptr);
+			}
+		}
+	}
+
+	// Requests whatever the scheduler has invalidated, for the cycle that is active now
+	void IssueFetches() {
+		const ReloadScheduler::Batch batch = m_Reloads.BeginBatch();
+		if (batch.rebuildGraph || m_FramesNode == nullptr) {
+			RebuildFramesNode();
+			if (m_CycleGrid.IsOpen()) {
+				VSNode* gridFrames = GridFramesNode();
+				m_CycleGrid.SetFramesNode(gridFrames);
+				m_VSAPI->freeNode(gridFrames);
+			}
+		}
+		const int fields_in_cycle = std::min(m_FieldsFrameCount - m_ActiveCycle * 10, 11);
+		if (batch.fields) {
+			for (int i = 0; i < fields_in_cycle; i++) {
+				m_Reloads.Request(m_VSAPI, m_FieldsNode, m_ActiveCycle * 10 + i, FETCH_FIELD, i);
+			}
+		}
+		if (batch.frames) {
+			const int frames_in_cycle = std::min(fields_in_cycle * 4 / 10, m_FramesFrameCount - m_ActiveCycle * 4);
+			for (int i = 0; i < frames_in_cycle; i++) {
+				m_Reloads.Request(m_VSAPI, m_FramesNode, m_ActiveCycle * 4 + i, FETCH_FRAME, i);
+			}
 		}
+	}
 
-		m_NeedNewFields = true;
-		m_WantNewFrames = false;
+	// Takes ownership of the fetched frame, which is uploaded (along with its properties) once the queue gets to it
+	void QueueFetched(const FetchedFrame& fetched) {
+		const VSAPI* vsapi = m_VSAPI;
+		const std::shared_ptr<const VSFrame> frame(fetched.frame, [vsapi](const VSFrame* frame) { vsapi->freeFrame(frame); });
+		const size_t bytes = UploadFrameBytes(m_VSAPI, fetched.frame);
+		const int i = fetched.slot;
+		if (fetched.kind == FETCH_FIELD) {
+			m_Uploads.Push(FIELD_UPLOAD_KEY + i, m_FieldsVisible ? UPLOAD_ON_SCREEN : UPLOAD_OFF_SCREEN, bytes, [this, i, frame, image = m_Fields[i]]() {
+				// Images replaced since no longer match the frame's size or format
+				if (image == m_Fields[i]) {
+					UploadFrame(*image, m_VSAPI, frame.get());
+				}
+			});
+		} else {
+			m_Uploads.Push(FRAME_UPLOAD_KEY + i, m_OutputVisible ? UPLOAD_ON_SCREEN : UPLOAD_OFF_SCREEN, bytes, [this, i, frame, image = m_Frames[i]]() {
+				if (image != m_Frames[i]) {
+					return;
+				}
+				const VSMap* props = m_VSAPI->getFramePropertiesRO(frame.get());
+				int err = 0;
+				m_FieldCount[i] = m_VSAPI->mapGetInt(props, "IVTCDN_Fields", 0, &err);
+				const char* freezeFrameProp = m_VSAPI->mapGetData(props, "IVTCDN_FreezeFrame", 0, &err);
+				std::string freezeFrame = err ? "" : freezeFrameProp;
+				UploadFrame(*image, m_VSAPI, frame.get());
+				m_FreezeFrames[i] = freezeFrame;
+				if (m_VSAPI->mapNumElements(props, "VMetrics") == 2) {
+					const int64_t* vmetrics = m_VSAPI->mapGetIntArray(props, "VMetrics", &err);
+					m_CombedMetrics[i] = err ? -1 : vmetrics[1];
+				}
+			});
+		}
 	}
 };
 
-std::shared_ptr<ExampleLayer> g_Layer = nullptr;
+// Doesn't own the layer, which the application destroys before shutting down what it uses
+ExampleLayer* g_Layer = nullptr;
 
 void glfw_drop_callback(GLFWwindow* window, int path_count, const char* paths[]) {
 	const char* filePathName = paths[0];
@@ -979,13 +2329,42 @@ void glfw_drop_callback(GLFWwindow* window, int path_count, const char* paths[])
 
 Walnut::Application* Walnut::CreateApplication(int argc, char** argv)
 {
+	// Subcommands run headless and never create a window
+	const int command_status = RunCommandLine(argc, argv);
+	if (command_status >= 0) {
+		std::exit(command_status);
+	}
+
 	Walnut::ApplicationSpecification spec;
 	spec.Name = "IVTC DN";
+	bool checkYUV = false;
+	bool uploadYUV = false;
+	for (int i = 1; i < argc; i++) {
+		if (std::string(argv[i]) == "--startup-timing") {
+			spec.PrintStartupTiming = true;
+		} else if (std::string(argv[i]) == "--check-yuv") {
+			checkYUV = true;
+		} else if (std::string(argv[i]) == "--upload-yuv") {
+			uploadYUV = true;
+		}
+	}
+
+	// Loading VSScript initialises Python, which takes about as long as everything else at startup put together
+	if (!checkYUV) {
+		PreloadVSScriptAPI();
+	}
 
 	Walnut::Application* app = new Walnut::Application(spec);
+	// Needs the window's Vulkan device, unlike the headless subcommands
+	if (checkYUV) {
+		const int status = CheckYUVConversion();
+		delete app;
+		std::exit(status);
+	}
 	g_UbuntuMonoFont = app->m_UbuntuMonoFont;
-	g_Layer = std::make_shared<ExampleLayer>();
-	app->PushLayer(g_Layer);
+	auto layer = std::make_shared<ExampleLayer>(spec.PrintStartupTiming, uploadYUV);
+	g_Layer = layer.get();
+	app->PushLayer(layer);
 	app->SetMenubarCallback([app]()
 	{
 		if (ImGui::BeginMenu("File"))
@@ -1002,6 +2381,9 @@ Walnut::Application* Walnut::CreateApplication(int argc, char** argv)
 			if (ImGui::MenuItem("Save project as...")) {
 				g_Layer->SaveProjectAsDialog();
 			}
+			if (ImGui::MenuItem("Export Y4M...", nullptr, false, g_Layer->m_ProjectOpened)) {
+				g_Layer->ExportY4MDialog();
+			}
 			if (ImGui::MenuItem("Exit")) {
 				app->Close();
 			}
@@ -1013,10 +2395,17 @@ Walnut::Application* Walnut::CreateApplication(int argc, char** argv)
 			if (ImGui::Checkbox("Auto-reload", &g_Layer->m_AutoReload)) {
 				g_Layer->UpdateAutoReload();
 			}
+			if (ImGui::Checkbox("Reload script on change", &g_Layer->m_WatchScript)) {
+				g_Layer->UpdateWatchScript();
+			}
 			if (ImGui::Checkbox("Combed Detection", &g_Layer->m_CombedDetection)) {
 				g_Layer->UpdateCombedDetection();
 			}
-			if (!g_Layer->m_CombedDetection) {
+			if (ImGui::Checkbox("Field Match Metrics", &g_Layer->m_MatchMetrics)) {
+				g_Layer->UpdateMatchMetrics();
+			}
+			const bool thresholdDisabled = !g_Layer->m_CombedDetection && !g_Layer->m_MatchMetrics;
+			if (thresholdDisabled) {
 				ImGui::BeginDisabled();
 			}
 			ImGui::Indent();
@@ -1026,7 +2415,7 @@ Walnut::Application* Walnut::CreateApplication(int argc, char** argv)
 				g_Layer->UpdateCombedThreshold();
 			}
 			ImGui::Unindent();
-			if (!g_Layer->m_CombedDetection) {
+			if (thresholdDisabled) {
 				ImGui::EndDisabled();
 			}
 			ImGui::Text("No Match Default");
@@ -1051,5 +2440,6 @@ Walnut::Application* Walnut::CreateApplication(int argc, char** argv)
 	glfwSetDropCallback(app->GetWindowHandle(), glfw_drop_callback);
 	GLFWimage image(32, 32, ICON_DATA);
 	glfwSetWindowIcon(app->GetWindowHandle(), 1, &image);
+	app->MarkStartupStage("layers and menus");
 	return app;
 }
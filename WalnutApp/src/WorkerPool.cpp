@@ -0,0 +1,73 @@
+#include "WorkerPool.h"
+
+#include <algorithm>
+#include <chrono>
+
+void WorkerPool::Shared::NotifyFinished() {
+	// Under the lock, so a waiter can't miss it between checking and going to sleep
+	std::lock_guard<std::mutex> lock(mutex);
+	finished.notify_all();
+}
+
+WorkerPool::WorkerPool(const Walnut::JobPriority priority) : m_Priority(priority) {
+}
+
+WorkerPool::TaskCount::~TaskCount() {
+	if (progress) {
+		progress->pendingTasks--;
+	}
+	shared->pendingTasks--;
+	shared->NotifyFinished();
+}
+
+WorkerPool::~WorkerPool() {
+	Stop();
+}
+
+void WorkerPool::Stop() {
+	m_Shared->stopping = true;
+	WaitUntil([shared = m_Shared.get()]() { return shared->pendingTasks == 0; });
+}
+
+void WorkerPool::Submit(std::function<void()>&& task) {
+	m_Shared->pendingTasks++;
+	auto count = std::make_shared<TaskCount>(m_Shared, nullptr);
+	Walnut::JobSystem::Submit(m_Priority, [shared = m_Shared, count, task = std::move(task)]() {
+		// Tasks left when the pool stops are skipped, they only hold progress and cancellation state
+		if (!shared->stopping) {
+			task();
+		}
+	});
+}
+
+void WorkerPool::ParallelFor(int begin, int end, int chunkSize, const std::shared_ptr<JobProgress>& progress, std::function<void(int, int)> body) {
+	chunkSize = std::max(1, chunkSize);
+	progress->total += end - begin;
+	for (int chunkBegin = begin; chunkBegin < end; chunkBegin += chunkSize) {
+		const int chunkEnd = std::min(end, chunkBegin + chunkSize);
+		progress->pendingTasks++;
+		m_Shared->pendingTasks++;
+		auto count = std::make_shared<TaskCount>(m_Shared, progress);
+		Walnut::JobSystem::Submit(m_Priority, [shared = m_Shared, count, progress, body, chunkBegin, chunkEnd]() {
+			if (!shared->stopping && !progress->cancelled) {
+				body(chunkBegin, chunkEnd);
+			}
+		});
+	}
+}
+
+void WorkerPool::Wait(const std::shared_ptr<JobProgress>& progress) {
+	WaitUntil([&]() { return !progress->IsRunning(); });
+}
+
+void WorkerPool::WaitUntil(const std::function<bool()>& done) {
+	while (!done()) {
+		if (Walnut::JobSystem::RunPendingTask()) {
+			continue;
+		}
+		// Nothing this thread may run (the rest is running, or held back by the background limit), so sleep until one of
+		// the pool's tasks finishes. The timeout covers tasks of other pools becoming runnable meanwhile.
+		std::unique_lock<std::mutex> lock(m_Shared->mutex);
+		m_Shared->finished.wait_for(lock, std::chrono::milliseconds(10), done);
+	}
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+#include "Walnut/JobSystem.h"
+
+// Progress and cancellation shared between a background job and the UI thread
+struct JobProgress {
+	std::atomic<int> completed = 0;
+	std::atomic<int> total = 0;
+	std::atomic<int> pendingTasks = 0;
+	std::atomic<bool> cancelled = false;
+
+	bool IsRunning() const { return pendingTasks > 0; }
+	float Fraction() const { return total > 0 ? (float)completed / total : 0.0f; }
+};
+
+// Queues tasks on the shared job system at one priority, used for background analysis of the whole clip. Destroying
+// the pool stops it, so its tasks can't outlive what they use.
+class WorkerPool {
+public:
+	explicit WorkerPool(Walnut::JobPriority priority);
+	~WorkerPool();
+
+	void Submit(std::function<void()>&& task);
+	// Skips the tasks which haven't started and waits for those which have. Nothing submitted afterwards runs.
+	void Stop();
+
+	unsigned GetThreadCount() const { return Walnut::JobSystem::GetWorkerCount(); }
+
+	// Splits [begin, end) into chunks and queues body(chunkBegin, chunkEnd) for each. Returns immediately.
+	// progress->total is increased by the size of the range, and body is expected to advance progress->completed.
+	// Chunks which haven't started when progress->cancelled is set, or the pool is stopped, are skipped but still
+	// counted off progress->pendingTasks.
+	void ParallelFor(int begin, int end, int chunkSize, const std::shared_ptr<JobProgress>& progress, std::function<void(int, int)> body);
+
+	// Blocks until the job has no pending tasks, running queued tasks on the calling thread meanwhile and sleeping when
+	// there are none it may run
+	void Wait(const std::shared_ptr<JobProgress>& progress);
+private:
+	struct Shared {
+		std::atomic<int> pendingTasks = 0;
+		std::atomic<bool> stopping = false;
+		// Notified whenever one of the pool's tasks finishes
+		std::mutex mutex;
+		std::condition_variable finished;
+
+		void NotifyFinished();
+	};
+
+	// Held by a task until the job system destroys it, having run it or dropped it unrun on shutdown, so every task
+	// counts itself off its pool (and job) exactly once
+	struct TaskCount {
+		std::shared_ptr<Shared> shared;
+		std::shared_ptr<JobProgress> progress;
+
+		TaskCount(std::shared_ptr<Shared> shared, std::shared_ptr<JobProgress> progress) : shared(std::move(shared)), progress(std::move(progress)) {}
+		TaskCount(const TaskCount&) = delete;
+		TaskCount& operator=(const TaskCount&) = delete;
+		~TaskCount();
+	};
+
+	// Runs queued tasks or sleeps until a task of the pool finishes, until done() holds
+	void WaitUntil(const std::function<bool()>& done);
+
+	Walnut::JobPriority m_Priority;
+	// Outlives the pool in tasks still queued when it's destroyed
+	std::shared_ptr<Shared> m_Shared = std::make_shared<Shared>();
+};
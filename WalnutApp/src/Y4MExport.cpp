@@ -0,0 +1,300 @@
+#include "Y4MExport.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <vector>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+// Large writes keep the writer thread from being the bottleneck on fast clips
+static const size_t OUTPUT_BUFFER_SIZE = 8 << 20;
+
+static int64_t NowMicroseconds() {
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+std::string Y4MColorspace(const VSVideoFormat& format) {
+	if (format.sampleType != stInteger || format.bitsPerSample > 16) {
+		return "";
+	}
+	std::string colorspace;
+	if (format.colorFamily == cfGray) {
+		colorspace = "mono";
+		if (format.bitsPerSample > 8) {
+			colorspace += std::to_string(format.bitsPerSample);
+		}
+		return colorspace;
+	} else if (format.colorFamily != cfYUV) {
+		return "";
+	}
+	const int w = format.subSamplingW;
+	const int h = format.subSamplingH;
+	if (w == 1 && h == 1) {
+		colorspace = "420";
+	} else if (w == 1 && h == 0) {
+		colorspace = "422";
+	} else if (w == 0 && h == 0) {
+		colorspace = "444";
+	} else if (w == 2 && h == 2) {
+		colorspace = "410";
+	} else if (w == 2 && h == 0) {
+		colorspace = "411";
+	} else if (w == 0 && h == 1) {
+		colorspace = "440";
+	} else {
+		return "";
+	}
+	if (format.bitsPerSample > 8) {
+		colorspace += "p" + std::to_string(format.bitsPerSample);
+	}
+	return colorspace;
+}
+
+// Frames come back from VapourSynth's threads in any order, the writer thread takes them out in order
+struct ReorderBuffer {
+	std::mutex mutex;
+	std::condition_variable condition;
+	std::map<int, const VSFrame*> frames;
+	std::string error;
+	int outstanding = 0;
+};
+
+static void VS_CC FrameDoneCallback(void* userData, const VSFrame* frame, int n, VSNode*, const char* errorMsg) {
+	ReorderBuffer* buffer = (ReorderBuffer*)userData;
+	{
+		std::lock_guard<std::mutex> lock(buffer->mutex);
+		if (frame) {
+			buffer->frames[n] = frame;
+		} else if (buffer->error.empty()) {
+			buffer->error = "Frame " + std::to_string(n) + ": " + (errorMsg ? errorMsg : "unknown error");
+		}
+		buffer->outstanding--;
+		// Notified under the lock, Run may destroy the buffer as soon as the last request is accounted for
+		buffer->condition.notify_all();
+	}
+}
+
+Y4MExporter::~Y4MExporter() {
+	Cancel();
+}
+
+bool Y4MExporter::Start(const VSAPI* vsapi, VSCore* core, VSNode* node, const std::string& path, int requests) {
+	Cancel();
+	m_VSAPI = vsapi;
+	m_Path = path;
+	m_FramesWritten = 0;
+	m_TotalFrames = 0;
+	m_Succeeded = false;
+	m_CancelRequested = false;
+	m_StartTime = NowMicroseconds();
+	m_EndTime = 0;
+	{
+		std::lock_guard<std::mutex> lock(m_ErrorMutex);
+		m_Error.clear();
+	}
+
+	if (!node) {
+		Fail("Failed to build the output graph");
+		return false;
+	}
+	const VSVideoInfo* vi = vsapi->getVideoInfo(node);
+	if (Y4MColorspace(vi->format).empty()) {
+		char formatName[32] = {};
+		vsapi->getVideoFormatName(&vi->format, formatName);
+		Fail(std::string("Y4M can't store ") + formatName + ", only integer YUV and GRAY formats");
+		return false;
+	}
+	if (path == "-") {
+#ifdef _WIN32
+		_setmode(_fileno(stdout), _O_BINARY);
+#endif
+		m_Output = stdout;
+	} else {
+		m_Output = fopen(path.c_str(), "wb");
+		if (!m_Output) {
+			Fail("Could not open " + path + " for writing");
+			return false;
+		}
+	}
+	setvbuf(m_Output, nullptr, _IOFBF, OUTPUT_BUFFER_SIZE);
+
+	if (requests <= 0) {
+		VSCoreInfo info;
+		vsapi->getCoreInfo(core, &info);
+		// Twice the threads so the core has work queued while the writer is busy
+		requests = std::max(1, info.numThreads) * 2;
+	}
+	m_Node = vsapi->addNodeRef(node);
+	m_TotalFrames = vi->numFrames;
+	m_Running = true;
+	m_Thread = std::thread(&Y4MExporter::Run, this, requests);
+	return true;
+}
+
+void Y4MExporter::Cancel() {
+	{
+		// Set under the buffer's lock so Run can't miss it between checking and going back to sleep
+		std::lock_guard<std::mutex> lock(m_BufferMutex);
+		if (m_Buffer) {
+			std::lock_guard<std::mutex> bufferLock(m_Buffer->mutex);
+			m_CancelRequested = true;
+			m_Buffer->condition.notify_all();
+		} else {
+			m_CancelRequested = true;
+		}
+	}
+	Wait();
+}
+
+void Y4MExporter::Wait() {
+	if (m_Thread.joinable()) {
+		m_Thread.join();
+	}
+}
+
+double Y4MExporter::GetElapsedSeconds() const {
+	const int64_t end = m_EndTime ? (int64_t)m_EndTime : NowMicroseconds();
+	return (end - m_StartTime) / 1e6;
+}
+
+double Y4MExporter::GetFps() const {
+	const double elapsed = GetElapsedSeconds();
+	return elapsed > 0 ? m_FramesWritten / elapsed : 0.0;
+}
+
+std::string Y4MExporter::GetError() const {
+	std::lock_guard<std::mutex> lock(m_ErrorMutex);
+	return m_Error;
+}
+
+void Y4MExporter::Fail(const std::string& error) {
+	std::lock_guard<std::mutex> lock(m_ErrorMutex);
+	if (m_Error.empty()) {
+		m_Error = error;
+	}
+}
+
+bool Y4MExporter::WriteHeader() {
+	const VSVideoInfo* vi = m_VSAPI->getVideoInfo(m_Node);
+	// IVTC output is film rate unless the script says otherwise
+	const int64_t fpsNum = vi->fpsNum ? vi->fpsNum : 24000;
+	const int64_t fpsDen = vi->fpsNum ? vi->fpsDen : 1001;
+	const std::string header = "YUV4MPEG2 C" + Y4MColorspace(vi->format) +
+		" W" + std::to_string(vi->width) +
+		" H" + std::to_string(vi->height) +
+		" F" + std::to_string(fpsNum) + ":" + std::to_string(fpsDen) +
+		" Ip A0:0 XLENGTH=" + std::to_string(vi->numFrames) + "\n";
+	return fwrite(header.data(), 1, header.size(), m_Output) == header.size();
+}
+
+bool Y4MExporter::WriteFrame(const VSFrame* frame) {
+	static const char FRAME_HEADER[] = "FRAME\n";
+	if (fwrite(FRAME_HEADER, 1, sizeof(FRAME_HEADER) - 1, m_Output) != sizeof(FRAME_HEADER) - 1) {
+		return false;
+	}
+	const VSVideoFormat* format = m_VSAPI->getVideoFrameFormat(frame);
+	for (int plane = 0; plane < format->numPlanes; plane++) {
+		const uint8_t* row = m_VSAPI->getReadPtr(frame, plane);
+		const ptrdiff_t stride = m_VSAPI->getStride(frame, plane);
+		const size_t rowSize = (size_t)m_VSAPI->getFrameWidth(frame, plane) * format->bytesPerSample;
+		const int height = m_VSAPI->getFrameHeight(frame, plane);
+		if (stride == (ptrdiff_t)rowSize) {
+			if (fwrite(row, 1, rowSize * height, m_Output) != rowSize * height) {
+				return false;
+			}
+			continue;
+		}
+		for (int y = 0; y < height; y++, row += stride) {
+			if (fwrite(row, 1, rowSize, m_Output) != rowSize) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+void Y4MExporter::Run(int requests) {
+	ReorderBuffer buffer;
+	{
+		std::lock_guard<std::mutex> lock(m_BufferMutex);
+		m_Buffer = &buffer;
+	}
+	const int total = m_TotalFrames;
+	int requested = 0;
+	auto request = [&]() {
+		{
+			std::lock_guard<std::mutex> lock(buffer.mutex);
+			buffer.outstanding++;
+		}
+		m_VSAPI->getFrameAsync(requested++, m_Node, FrameDoneCallback, &buffer);
+	};
+
+	bool ok = WriteHeader();
+	if (!ok) {
+		Fail("Could not write to " + m_Path);
+	}
+	while (ok && requested < std::min(total, requests)) {
+		request();
+	}
+	for (int next = 0; ok && next < total; next++) {
+		const VSFrame* frame = nullptr;
+		{
+			std::unique_lock<std::mutex> lock(buffer.mutex);
+			buffer.condition.wait(lock, [&]() { return buffer.frames.count(next) || !buffer.error.empty() || m_CancelRequested; });
+			if (!buffer.error.empty()) {
+				Fail(buffer.error);
+				break;
+			}
+			if (m_CancelRequested) {
+				Fail("Cancelled");
+				break;
+			}
+			auto it = buffer.frames.find(next);
+			frame = it->second;
+			buffer.frames.erase(it);
+		}
+		if (requested < total) {
+			request();
+		}
+		ok = WriteFrame(frame);
+		m_VSAPI->freeFrame(frame);
+		if (!ok) {
+			Fail("Could not write to " + m_Path);
+			break;
+		}
+		m_FramesWritten++;
+	}
+
+	// The callbacks point at the buffer, so every request has to come back before it goes away
+	{
+		std::unique_lock<std::mutex> lock(buffer.mutex);
+		buffer.condition.wait(lock, [&]() { return buffer.outstanding == 0; });
+		for (auto& [n, frame] : buffer.frames) {
+			m_VSAPI->freeFrame(frame);
+		}
+		buffer.frames.clear();
+	}
+	{
+		std::lock_guard<std::mutex> lock(m_BufferMutex);
+		m_Buffer = nullptr;
+	}
+
+	if (fflush(m_Output) != 0 && ok) {
+		Fail("Could not write to " + m_Path);
+		ok = false;
+	}
+	if (m_Output != stdout) {
+		fclose(m_Output);
+	}
+	m_Output = nullptr;
+	m_VSAPI->freeNode(m_Node);
+	m_Node = nullptr;
+	m_EndTime = NowMicroseconds();
+	m_Succeeded = ok && m_FramesWritten == total;
+	m_Running = false;
+}
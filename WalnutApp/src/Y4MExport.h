@@ -0,0 +1,67 @@
+#pragma once
+
+#include <atomic>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "vapoursynth/VapourSynth4.h"
+
+// Y4M colorspace tag for a clip's format, or an empty string if Y4M can't hold it (RGB, float or unknown formats)
+std::string Y4MColorspace(const VSVideoFormat& format);
+
+struct ReorderBuffer;
+
+// Streams a clip to a Y4M file on a background thread. Up to `requests` frames are requested with getFrameAsync at
+// a time so every VapourSynth thread stays busy, and completed frames wait in a reorder buffer until they can be
+// written in order.
+class Y4MExporter {
+public:
+	~Y4MExporter();
+
+	// Takes its own reference to node. A path of "-" writes to stdout. requests <= 0 picks a window from the core's thread count.
+	bool Start(const VSAPI* vsapi, VSCore* core, VSNode* node, const std::string& path, int requests = 0);
+	// Stops requesting frames and blocks until the ones in flight have come back
+	void Cancel();
+	// Blocks until the export has finished or failed
+	void Wait();
+
+	bool IsRunning() const { return m_Running; }
+	bool HasStarted() const { return m_Thread.joinable(); }
+	bool Succeeded() const { return !m_Running && m_Succeeded; }
+	int GetFramesWritten() const { return m_FramesWritten; }
+	int GetTotalFrames() const { return m_TotalFrames; }
+	float GetProgress() const { return m_TotalFrames > 0 ? (float)m_FramesWritten / m_TotalFrames : 0.0f; }
+	// Average output rate since the export started
+	double GetFps() const;
+	double GetElapsedSeconds() const;
+	const std::string& GetPath() const { return m_Path; }
+	std::string GetError() const;
+private:
+	void Run(int requests);
+	bool WriteHeader();
+	bool WriteFrame(const VSFrame* frame);
+	void Fail(const std::string& error);
+
+	const VSAPI* m_VSAPI = nullptr;
+	VSNode* m_Node = nullptr;
+	FILE* m_Output = nullptr;
+	std::string m_Path;
+	std::thread m_Thread;
+
+	std::atomic<bool> m_Running = false;
+	std::atomic<bool> m_Succeeded = false;
+	std::atomic<bool> m_CancelRequested = false;
+	std::atomic<int> m_FramesWritten = 0;
+	std::atomic<int> m_TotalFrames = 0;
+	std::atomic<int64_t> m_StartTime = 0;
+	std::atomic<int64_t> m_EndTime = 0;
+
+	// The running export's reorder buffer, so Cancel can wake a Run waiting on it
+	std::mutex m_BufferMutex;
+	ReorderBuffer* m_Buffer = nullptr;
+
+	mutable std::mutex m_ErrorMutex;
+	std::string m_Error;
+};
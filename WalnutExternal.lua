@@ -13,6 +13,12 @@ LibraryDir["VulkanSDK"] = "%{VULKAN_SDK}/Lib"
 Library = {}
 Library["Vulkan"] = "%{LibraryDir.VulkanSDK}/vulkan-1.lib"
 
+if os.ishost("windows") then
+   GLSLANG_VALIDATOR = "%{VULKAN_SDK}/Bin/glslangValidator.exe"
+else
+   GLSLANG_VALIDATOR = "glslangValidator"
+end
+
 
 function linux_dpkg_check_if_package_is_installed(package)
    if os.isfile("/usr/bin/dpkg-query") then -- It's Debian or a derivative of it:
@@ -35,6 +41,7 @@ group "Dependencies"
       linux_dpkg_check_if_package_is_installed("libvulkan-dev")
       linux_dpkg_check_if_package_is_installed("mesa-vulkan-drivers")
       linux_dpkg_check_if_package_is_installed("vulkan-tools")
+      linux_dpkg_check_if_package_is_installed("glslang-tools")
    else
       -- For other operating systems, build GLFW in the cloned git submodule:
       include "vendor/GLFW"
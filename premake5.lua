@@ -7,4 +7,9 @@ workspace "IVTCDN"
 outputdir = "%{cfg.buildcfg}-%{cfg.system}-%{cfg.architecture}"
 
 include "WalnutExternal.lua"
-include "WalnutApp"
\ No newline at end of file
+include "WalnutApp"
+
+group "Tools"
+include "Benchmarks"
+include "Tests"
+group ""
\ No newline at end of file